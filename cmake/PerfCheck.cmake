@@ -0,0 +1,89 @@
+#
+# 运行单个性能用例并与基线比较, 由 cmake/PerfTests.cmake 注册
+#
+# 输入:
+#   PERF_COMMAND            : 以 | 分隔的命令行
+#   PERF_METRIC             : 指标名, 对应输出中的 "PERF <metric> <value>"
+#   PERF_DIRECTION          : higher (越大越好) 或 lower (越小越好)
+#   PERF_BASELINE_FILE      : 基线文件, 每行 "<metric> <value>"
+#   PERF_THRESHOLD_PERCENT  : 允许的劣化百分比
+#   PERF_UPDATE_BASELINE    : 为 ON 时将本次结果写入基线文件
+#
+
+# 将小数转换为千分之一为单位的整数, CMake math 只支持整数运算
+function(perf_to_milli value out)
+    if(value MATCHES "^([0-9]+)\\.?([0-9]*)")
+        set(integer ${CMAKE_MATCH_1})
+        string(SUBSTRING "${CMAKE_MATCH_2}000" 0 3 fraction)
+        math(EXPR milli "${integer} * 1000 + ${fraction}")
+        set(${out} ${milli} PARENT_SCOPE)
+    else()
+        message(FATAL_ERROR "invalid number: ${value}")
+    endif()
+endfunction()
+
+string(REPLACE "|" ";" command "${PERF_COMMAND}")
+execute_process(COMMAND ${command}
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message("${output}")
+    message(FATAL_ERROR "${PERF_METRIC}: command failed (${result})")
+endif()
+if(NOT output MATCHES "PERF ${PERF_METRIC} ([0-9.e+-]+)")
+    message("${output}")
+    message(FATAL_ERROR "${PERF_METRIC}: metric not found in output")
+endif()
+set(measured ${CMAKE_MATCH_1})
+if(NOT measured MATCHES "^[0-9]+(\\.[0-9]+)?$")
+    # Hint : ReportPerfMetric 以固定小数格式输出, 科学计数法或负数说明输出格式有误, 不做猜测
+    message(FATAL_ERROR "${PERF_METRIC}: unexpected value format: ${measured}")
+endif()
+
+set(baseline "")
+set(lines "")
+if(EXISTS ${PERF_BASELINE_FILE})
+    file(STRINGS ${PERF_BASELINE_FILE} lines)
+    foreach(line ${lines})
+        if(line MATCHES "^${PERF_METRIC} ([0-9.]+)$")
+            set(baseline ${CMAKE_MATCH_1})
+        endif()
+    endforeach()
+endif()
+
+if(PERF_UPDATE_BASELINE)
+    set(updated "")
+    foreach(line ${lines})
+        if(NOT line MATCHES "^${PERF_METRIC} ")
+            string(APPEND updated "${line}\n")
+        endif()
+    endforeach()
+    string(APPEND updated "${PERF_METRIC} ${measured}\n")
+    file(WRITE ${PERF_BASELINE_FILE} "${updated}")
+    message("${PERF_METRIC}: ${measured} (baseline updated)")
+    return()
+endif()
+
+if(baseline STREQUAL "")
+    message("${PERF_METRIC}: ${measured} (no baseline in ${PERF_BASELINE_FILE}, not compared)")
+    return()
+endif()
+
+perf_to_milli(${measured} measured_milli)
+perf_to_milli(${baseline} baseline_milli)
+if(PERF_DIRECTION STREQUAL "higher")
+    # measured < baseline * (100 - threshold) / 100
+    math(EXPR limit "${baseline_milli} * (100 - ${PERF_THRESHOLD_PERCENT}) / 100")
+    if(measured_milli LESS limit)
+        message(FATAL_ERROR "${PERF_METRIC}: ${measured} regressed more than ${PERF_THRESHOLD_PERCENT}% from baseline ${baseline}")
+    endif()
+else()
+    # measured > baseline * (100 + threshold) / 100
+    math(EXPR limit "${baseline_milli} * (100 + ${PERF_THRESHOLD_PERCENT}) / 100")
+    if(measured_milli GREATER limit)
+        message(FATAL_ERROR "${PERF_METRIC}: ${measured} regressed more than ${PERF_THRESHOLD_PERCENT}% from baseline ${baseline}")
+    endif()
+endif()
+message("${PERF_METRIC}: ${measured} (baseline ${baseline}, threshold ${PERF_THRESHOLD_PERCENT}%)")
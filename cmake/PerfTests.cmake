@@ -0,0 +1,76 @@
+#
+# 性能回归测试, 通过 ctest -L perf 运行
+#
+# 每个用例运行一个 sample, 解析其输出的 "PERF <metric> <value>", 与
+# perf/baselines/<MMP_PERF_MACHINE_CLASS>.txt 中的基线比较, 劣化超过
+# MMP_PERF_THRESHOLD_PERCENT 时失败. 所有用例均不打开显示窗口, 并强制使用软件 GL.
+#
+
+set(MMP_PERF_MACHINE_CLASS "generic" CACHE STRING "Baseline file name under perf/baselines (without .txt)")
+set(MMP_PERF_THRESHOLD_PERCENT "10" CACHE STRING "Allowed regression in percent before a perf test fails")
+set(MMP_PERF_UPDATE_BASELINE OFF CACHE BOOL "Write measured values into the baseline file instead of comparing")
+set(MMP_PERF_BACKEND "OPENGL" CACHE STRING "GPU backend used by perf tests")
+set(MMP_PERF_ENCODER "OpenH264Encoder" CACHE STRING "Encoder used to generate the perf clip")
+set(MMP_PERF_DECODER "OpenH264Decoder" CACHE STRING "Decoder used by the decode perf test")
+set(MMP_PERF_TRANSITIONS "DirectionalTransition;FadeTransition;CrossZoomTransition;PixelizeTransition;CubeTransition"
+    CACHE STRING "Transitions covered by the transition sweep")
+
+set(MMP_PERF_BASELINE_FILE ${CMAKE_CURRENT_SOURCE_DIR}/perf/baselines/${MMP_PERF_MACHINE_CLASS}.txt)
+set(MMP_PERF_CLIP ${CMAKE_CURRENT_BINARY_DIR}/perf_clip.h264)
+set(MMP_PERF_ENVIRONMENT "LIBGL_ALWAYS_SOFTWARE=1;SDL_VIDEODRIVER=dummy")
+
+enable_testing()
+
+# mmp_add_perf_test(<name> <metric> <higher|lower> <command...>)
+function(mmp_add_perf_test name metric direction)
+    # Hint : 命令作为单个 -D 参数传入, 使用 | 代替列表分隔符
+    string(REPLACE ";" "|" command "${ARGN}")
+    add_test(NAME ${name}
+        COMMAND ${CMAKE_COMMAND}
+            "-DPERF_COMMAND=${command}"
+            -DPERF_METRIC=${metric}
+            -DPERF_DIRECTION=${direction}
+            -DPERF_BASELINE_FILE=${MMP_PERF_BASELINE_FILE}
+            -DPERF_THRESHOLD_PERCENT=${MMP_PERF_THRESHOLD_PERCENT}
+            -DPERF_UPDATE_BASELINE=${MMP_PERF_UPDATE_BASELINE}
+            -P ${CMAKE_CURRENT_SOURCE_DIR}/cmake/PerfCheck.cmake
+    )
+    set_tests_properties(${name} PROPERTIES
+        LABELS perf
+        ENVIRONMENT "${MMP_PERF_ENVIRONMENT}"
+        RUN_SERIAL TRUE
+    )
+endfunction()
+
+# Hint : 仓库中不附带码流文件, 由 test_gl_encoder 生成并作为 fixture 供后续用例使用
+add_test(NAME perf_generate_clip
+    COMMAND $<TARGET_FILE:test_gl_encoder> --backend=${MMP_PERF_BACKEND} --split_num=2 --frames=300
+            --codec_name=${MMP_PERF_ENCODER} --output=${MMP_PERF_CLIP}
+)
+set_tests_properties(perf_generate_clip PROPERTIES
+    LABELS perf
+    ENVIRONMENT "${MMP_PERF_ENVIRONMENT}"
+    FIXTURES_SETUP perf_clip
+)
+
+mmp_add_perf_test(perf_decode decode_fps higher
+    $<TARGET_FILE:test_decoder> --codec_name=${MMP_PERF_DECODER} --input=${MMP_PERF_CLIP} --display=false --replay=10
+)
+set_tests_properties(perf_decode PROPERTIES FIXTURES_REQUIRED perf_clip)
+
+mmp_add_perf_test(perf_nal_scan nal_scan_mbps higher
+    $<TARGET_FILE:test_byte_source> --input=${MMP_PERF_CLIP}
+)
+set_tests_properties(perf_nal_scan PROPERTIES FIXTURES_REQUIRED perf_clip)
+
+foreach(split 4 8)
+    mmp_add_perf_test(perf_compositor_${split}x${split} compositor_${split}x${split}_frame_us lower
+        $<TARGET_FILE:test_gl_compositor> --backend=${MMP_PERF_BACKEND} --split_num=${split} --duration=5 --display=false --governor=false
+    )
+endforeach()
+
+foreach(transition ${MMP_PERF_TRANSITIONS})
+    mmp_add_perf_test(perf_transition_${transition} transition_${transition}_frame_us lower
+        $<TARGET_FILE:test_gl_transition> --backend=${MMP_PERF_BACKEND} --transition=${transition} --duration=2 --display=false --governor=false
+    )
+endforeach()
@@ -0,0 +1,54 @@
+//
+// AbstractByteSource.h
+//
+// Library: Common
+// Package: Stream
+// Module:  ByteSource
+//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <cstdint>
+
+namespace Mmp
+{
+
+/**
+ * @brief  字节流输入源
+ * @note   1 - 文件 : 普通路径或 file://<path>, 支持 Seek
+ *         2 - 管道 : - 或 stdin (标准输入), pipe://<path> (命名管道)
+ *         3 - UDP : udp://<ip>:<port>, 在本地地址上接收
+ *         4 - Unix 套接字 : unix://<path>, 在 path 上监听并接收一个连接
+ *         5 - 除文件外均由接收线程写入无锁环形缓冲, Read 不直接发起系统调用
+ */
+class AbstractByteSource
+{
+public:
+    using ptr = std::shared_ptr<AbstractByteSource>;
+public:
+    virtual ~AbstractByteSource() = default;
+public:
+    /**
+     * @brief      根据 url 创建并打开输入源
+     * @return     打开失败时返回 nullptr
+     */
+    static AbstractByteSource::ptr Create(const std::string& url);
+public:
+    virtual bool Open(const std::string& url) = 0;
+    virtual void Close() = 0;
+    /**
+     * @brief      读取至多 bytes 字节
+     * @return     实际读取字节数, 没有数据时阻塞等待, 仅在结束时返回 0
+     */
+    virtual size_t Read(void* data, size_t bytes) = 0;
+    virtual bool eof() = 0;
+    /**
+     * @brief      是否支持随机访问
+     */
+    virtual bool Seekable() { return false; }
+    virtual bool Seek(size_t /* offset */) { return false; }
+};
+
+} // namespace Mmp
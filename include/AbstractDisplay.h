@@ -9,9 +9,13 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "Common/LogMessage.h"
 #include "Common/PixelsInfo.h"
+#include "Common/AbstractPicture.h"
+
+#include "FrameScaler.h"
 
 #define  DISPLAY_LOG_TRACE      MMP_MLOG_TRACE("Display")    
 #define  DISPLAY_LOG_DEBUG      MMP_MLOG_DEBUG("Display")    
@@ -23,6 +27,54 @@
 namespace Mmp
 {
 
+/**
+ * @brief  可直接写入的显示缓冲
+ * @note   data/stride 依次为各平面的地址及跨距 (单位字节), 未使用的平面为空
+ */
+class DisplayBuffer
+{
+public:
+    DisplayBuffer();
+public:
+    uint8_t*    data[3];
+    int32_t     stride[3];
+    PixelsInfo  info;
+};
+
+/**
+ * @brief      将 DisplayBuffer 包装为 AbstractPicture, 不拷贝, 不拥有内存
+ * @note       仅当各平面紧密排列 (跨距等于宽度且平面首尾相接) 时可以包装, 否则返回 nullptr;
+ *             返回的 picture 只在下一次 Present 之前有效
+ */
+AbstractPicture::ptr WrapDisplayBuffer(const DisplayBuffer& buffer);
+
+/**
+ * @brief  按缓冲地址缓存 WrapDisplayBuffer 的结果, 避免每帧重新包装 (两次 make_shared)
+ * @note   1 - 显示纹理在加锁时通常返回固定的一两块内存, 最多缓存 kMaxEntries 个, 超出时替换最早的一个
+ *         2 - 地址、跨距或像素信息任一变化时视为不同的缓冲
+ */
+class DisplayBufferCache
+{
+public:
+    DisplayBufferCache();
+public:
+    /**
+     * @return     无法包装时返回 nullptr (同 WrapDisplayBuffer)
+     */
+    AbstractPicture::ptr Wrap(const DisplayBuffer& buffer);
+private:
+    class Entry
+    {
+    public:
+        DisplayBuffer         buffer;
+        AbstractPicture::ptr  picture;
+    };
+    static constexpr size_t kMaxEntries = 4;
+private:
+    std::vector<Entry>  _entries;
+    size_t              _next;
+};
+
 /**
  * @brief  窗口创建器
  * @note   1 - CPU
@@ -54,6 +106,7 @@ public:
     /**
      * @brief      打开窗口
      * @param[in]  info : 像素描述信息
+     * @note       开启 SetFitToDisplay 时窗口及显示纹理可能小于 info, UpdateWindow 仍按 info 传入
      * @note       PixelFormat 仅做参考用途(即实际打开的画面并不一定是此颜色),但是一定打开成功, UpdateWindow
      *             一定支持此像素格式
      * @sa         PixelsInfo
@@ -71,6 +124,29 @@ public:
      *             (目前来看没有这个需求)
      */
     virtual void UpdateWindow(const uint32_t* frameBuffer, PixelsInfo info = {1920, 1080, 8, PixelFormat::RGBA8888}) = 0;
+    /**
+     * @brief      获取可直接写入的显示缓冲, 写入完成后调用 Present
+     * @note       1 - 读回、解码拷贝或颜色转换直接写入纹理内存, 省去 UpdateWindow 的一次整帧拷贝
+     *             2 - Acquire 与 Present 需成对调用, 且与 UpdateWindow 在同一线程
+     *             3 - 默认实现不支持, 返回 false, 调用者应回退至 UpdateWindow
+     */
+    virtual bool AcquireBuffer(DisplayBuffer& buffer);
+    /**
+     * @brief      显示 AcquireBuffer 获取的缓冲
+     */
+    virtual void Present();
+    /**
+     * @brief      放弃 AcquireBuffer 获取的缓冲, 不显示 (如缓冲无法作为写入目标时)
+     */
+    virtual void AbortBuffer();
+    /**
+     * @brief      画面大于屏幕时是否等比缩小窗口, 需在 Open 之前调用
+     * @param[in]  fit : 为 true 时 UpdateWindow 在上传前于 CPU 上缩放画面, 上传带宽随面积下降
+     *                   (4K 画面在 1080p 屏幕上为 1/4); 为 false 时窗口与画面等大
+     * @param[in]  filter : 缩放算法
+     * @note       默认实现忽略此设置; 缩小后 AcquireBuffer 得到的是窗口大小的缓冲
+     */
+    virtual void SetFitToDisplay(bool fit, ScaleFilter filter = ScaleFilter::AREA);
 };
 
 } // namespace Mmp
\ No newline at end of file
@@ -0,0 +1,62 @@
+//
+// AbstractPacketReader.h
+//
+// Library: Common
+// Package: Codec
+// Module:  PacketReader
+//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <cstdint>
+
+#include "Codec/StreamPack.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  码流包读取, 屏蔽输入的封装格式
+ * @note   1 - Annex-B 裸流 (H26XFileByteReader) 按 NAL 输出, MP4 / IVF 按帧 (sample) 输出
+ *         2 - 输出给 H.264 / H.265 解码器的包均为 Annex-B 格式
+ */
+class AbstractPacketReader
+{
+public:
+    using ptr = std::shared_ptr<AbstractPacketReader>;
+public:
+    virtual ~AbstractPacketReader() = default;
+public:
+    /**
+     * @brief      按文件头 (MP4 的 ftyp / IVF 的 DKIF) 及扩展名选择读取方式, 其余按 Annex-B 裸流读取
+     * @param[in]  codecType : 裸流的编码类型; MP4 / IVF 以文件中记录的为准
+     * @note       管道 / 套接字等非文件输入始终按 Annex-B 裸流读取
+     */
+    static AbstractPacketReader::ptr Create(const std::string& path, Codec::CodecType codecType = Codec::CodecType::H264);
+    /**
+     * @brief      Create 是否会按 Annex-B 裸流读取, 只探测不打开
+     */
+    static bool IsAnnexB(const std::string& path);
+public:
+    virtual bool IsOpen() = 0;
+    /**
+     * @return     结束或出错时返回 nullptr
+     */
+    virtual Codec::StreamPack::ptr GetPacket() = 0;
+    virtual Codec::CodecType GetCodecType() = 0;
+    /**
+     * @brief      pack 是否开始一帧新的图像 (参数集 / SEI 等返回 false), 用于统计送入解码器的帧数
+     * @param[in]  pack : GetPacket 的输出
+     */
+    virtual bool IsPictureStart(const Codec::StreamPack::ptr& pack) = 0;
+    /**
+     * @brief      定位到 frame 之前最近的关键帧
+     * @param[out] keyFrame : 实际定位到的帧序号
+     * @return     不支持按帧定位时返回 false (Annex-B 裸流通过 AnnexBIndex 定位)
+     */
+    virtual bool SeekToFrame(uint64_t frame, uint64_t& keyFrame) { return false; }
+};
+
+} // namespace Mmp
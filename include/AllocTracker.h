@@ -0,0 +1,93 @@
+//
+// AllocTracker.h
+//
+// Library: Common
+// Package: Profile
+// Module:  AllocTracker
+//
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace Mmp
+{
+
+/**
+ * @brief  堆分配统计
+ * @note   1 - 仅在定义 MMP_ENABLE_ALLOC_TRACKER 时 (CMake 选项 MMP_SAMPLE_ALLOC_TRACKER) 替换全局
+ *             operator new/delete, 否则所有接口均为空实现, 无额外开销
+ *         2 - 按线程计数, 只统计经过 operator new 的分配, MMP-Core 内部直接调用 malloc 的分配不在统计范围内
+ *         3 - 断言模式下, 当前线程发生分配时输出大小并 abort
+ */
+class AllocTracker
+{
+public:
+    static bool Enabled();
+    static uint64_t GetThreadAllocCount();
+    static uint64_t GetThreadAllocBytes();
+    /**
+     * @brief      开启/关闭当前线程的断言模式
+     */
+    static void SetThreadAssert(bool enable);
+    static bool GetThreadAssert();
+};
+
+/**
+ * @brief  某一处理阶段的分配统计, 以帧为单位累计
+ * @note   Begin/End 需在同一线程调用, 不同阶段可在不同线程
+ */
+class AllocStage
+{
+public:
+    explicit AllocStage(const std::string& name);
+public:
+    void Begin();
+    void End();
+    /**
+     * @brief      输出平均每帧分配次数及字节数, 以及 warmUp 帧之后是否存在分配
+     */
+    void Report();
+    /**
+     * @param[in]  frames : 前 frames 帧视为预热, 之后的分配单独统计
+     */
+    void SetWarmUp(uint64_t frames);
+    uint64_t GetSteadyAllocCount();
+private:
+    std::string  _name;
+    uint64_t     _warmUp;
+    uint64_t     _frames;
+    uint64_t     _allocs;
+    uint64_t     _bytes;
+    uint64_t     _steadyAllocs;
+    uint64_t     _maxAllocs;
+    uint64_t     _beginCount;
+    uint64_t     _beginBytes;
+};
+
+/**
+ * @brief  在作用域内断言当前线程不发生堆分配, armed 为 false 时不生效
+ */
+class AllocAssertScope
+{
+public:
+    explicit AllocAssertScope(bool armed);
+    ~AllocAssertScope();
+private:
+    bool _armed;
+};
+
+/**
+ * @brief  在 AllocAssertScope 内暂停断言, 用于包住 MMP-Core 等外部调用, 其分配仍计入统计
+ */
+class AllocAssertPause
+{
+public:
+    AllocAssertPause();
+    ~AllocAssertPause();
+private:
+    bool _paused;
+};
+
+} // namespace Mmp
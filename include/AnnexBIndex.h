@@ -0,0 +1,120 @@
+//
+// AnnexBIndex.h
+//
+// Library: Common
+// Package: Codec
+// Module:  AnnexBIndex
+//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include "Codec/CodecFactory.h"
+
+#include "H26XFileByteReader.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  Annex-B 码流随机访问点(H.264 IDR / H.265 IRAP)索引
+ * @note   1 - 偏移指向随机访问点所在访问单元的第一个 NAL (包括其前面的 AUD/SPS/PPS/VPS/SEI),
+ *             从该偏移开始送入一个刚 Flush 的解码器即可正常解码
+ *         2 - 帧序号按解码顺序计数, 每个图像的第一个 slice 计一帧
+ *         3 - 同时记录随机访问点之前最近的 VPS/SPS/PPS (每种只保留最近一个) 的偏移, 码流只在开头携带参数集时,
+ *             定位后需先送入这些参数集
+ */
+class AnnexBIndex
+{
+public:
+    using ptr = std::shared_ptr<AnnexBIndex>;
+public:
+    class Entry
+    {
+    public:
+        uint64_t               offset;
+        uint64_t               frame;
+        std::vector<uint64_t>  parameterSets;   // 位于 offset 之前, 需要重新送入的参数集 NAL 偏移
+    };
+    /**
+     * @brief  码流文件特征, 用于判断索引文件是否过期
+     * @note   只对文件首尾各 64 KiB 计算哈希, 不读取整个文件
+     */
+    class Signature
+    {
+    public:
+        uint64_t  fileSize;
+        int64_t   modified;   // 最后修改时间, 单位 us
+        uint64_t  hash;       // 首尾各 64 KiB 内容的 FNV-1a 哈希
+    };
+public:
+    explicit AnnexBIndex(Codec::CodecType codecType = Codec::CodecType::H264);
+public:
+    /**
+     * @brief      完整扫描一遍文件建立索引
+     */
+    bool Build(const std::string& path);
+    /**
+     * @brief      优先加载 path 对应的索引文件, 不存在或已过期时扫描并保存
+     */
+    bool LoadOrBuild(const std::string& path);
+    /**
+     * @param[in]  signature : 码流文件特征, 大小、修改时间或内容哈希任一与索引文件记录不一致时视为过期
+     */
+    bool Load(const std::string& indexPath, const Signature& signature);
+    bool Save(const std::string& indexPath, const Signature& signature);
+public:
+    /**
+     * @brief      查找帧序号不大于 frame 的最近一个随机访问点
+     */
+    const Entry* FindByFrame(uint64_t frame);
+    const Entry* FindByTime(double second, double fps);
+    const std::vector<Entry>& GetEntries();
+    uint64_t GetFrameCount();
+public:
+    /**
+     * @brief      将 reader 定位到随机访问点
+     * @return     随机访问点的帧序号
+     */
+    uint64_t SeekToFrame(H26XFileByteReader& reader, uint64_t frame);
+    /**
+     * @param[out] parameterSets : 需要在随机访问点之前送入的参数集 (Annex-B), 不需要时为 nullptr
+     */
+    uint64_t SeekToFrame(H26XFileByteReader& reader, uint64_t frame, Codec::StreamPack::ptr& parameterSets);
+public:
+    static std::string GetIndexPath(const std::string& path);
+    static bool GetSignature(const std::string& path, Signature& signature);
+    static bool IsRandomAccessPoint(Codec::CodecType codecType, const uint8_t* nal, size_t size);
+    static bool IsFirstSliceOfPicture(Codec::CodecType codecType, const uint8_t* nal, size_t size);
+private:
+    Codec::CodecType    _codecType;
+    std::vector<Entry>  _entries;
+    uint64_t            _frameCount;
+};
+
+/**
+ * @brief  根据解码器名称查找其编码类型, 未找到时返回 H264
+ */
+Codec::CodecType GetDecoderCodecType(const std::string& decoderClassName);
+
+/**
+ * @brief  解码器结束标记 (空 pack)
+ * @note   送入后解码器不再等待后续帧, 输出内部缓存的全部帧; 之后可从随机访问点开始送入新的码流, 不需要重新 Init
+ */
+Codec::StreamPack::ptr CreateEndOfStreamPack(Codec::CodecType codecType);
+
+/**
+ * @brief      送入结束标记并在当前线程取出解码器中剩余的帧
+ * @param[in]  expectFrames : 期望取出的帧数, 取满即返回
+ * @param[in]  idleTimeoutMs : 超过该时间没有新的输出时认为解码器已无更多输出, 仅用于异常兜底
+ * @return     取出的帧数
+ */
+uint64_t FlushDecoder(Codec::AbstractDecoder::ptr decoder, Codec::CodecType codecType, uint64_t expectFrames, uint32_t idleTimeoutMs,
+                      const std::function<void(AbstractFrame::ptr frame)>& callback);
+
+} // namespace Mmp
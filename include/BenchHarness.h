@@ -0,0 +1,89 @@
+//
+// BenchHarness.h
+//
+// Library: Common
+// Package: Bench
+// Module:  BenchHarness
+//
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <functional>
+
+#include <Poco/Timestamp.h>
+
+namespace Mmp
+{
+
+/**
+ * @brief  单次基准测试运行状态
+ * @note   用法与 Google Benchmark 相同: while (state.KeepRunning()) { ... }
+ */
+class BenchState
+{
+public:
+    explicit BenchState(uint64_t iterations);
+public:
+    bool KeepRunning();
+    /**
+     * @brief      暂停/恢复计时, 用于排除每次迭代的准备工作
+     */
+    void PauseTiming();
+    void ResumeTiming();
+    /**
+     * @brief      设置后输出 bytes_per_second / items_per_second
+     */
+    void SetBytesProcessed(uint64_t bytes);
+    void SetItemsProcessed(uint64_t items);
+    /**
+     * @brief      自定义指标, 原样输出
+     */
+    void SetCounter(const std::string& name, double value);
+    /**
+     * @brief      环境不满足时跳过, 结果中记录原因
+     */
+    void SkipWithError(const std::string& reason);
+public:
+    uint64_t                        iterations;
+    uint64_t                        elapsedNs;
+    uint64_t                        bytes;
+    uint64_t                        items;
+    std::map<std::string, double>   counters;
+    std::string                     error;
+private:
+    uint64_t        _remain;
+    bool            _started;
+    bool            _paused;
+    Poco::Timestamp _stamp;
+};
+
+/**
+ * @brief  进程内基准测试注册及运行, 结果以 JSON 输出便于在不同 MMP-Core 版本之间比较
+ */
+class BenchRegistry
+{
+public:
+    using BenchFunc = std::function<void(BenchState& state)>;
+public:
+    static BenchRegistry& Instance();
+public:
+    void Register(const std::string& name, const BenchFunc& func);
+    /**
+     * @param[in]  filter      : 名称包含该子串的用例才运行, 为空时运行全部
+     * @param[in]  minTimeMs   : 每次重复的最短计时, 迭代次数自动增长直到满足
+     * @param[in]  repetitions : 重复次数, 输出耗时中位数及最小值
+     * @param[in]  context     : 附加到 JSON context 中的键值
+     */
+    void Run(const std::string& filter, uint32_t minTimeMs, uint32_t repetitions,
+             const std::map<std::string, std::string>& context, std::ostream& json);
+    std::vector<std::string> GetNames();
+private:
+    std::vector<std::pair<std::string, BenchFunc>> _benches;
+};
+
+} // namespace Mmp
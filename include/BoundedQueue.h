@@ -0,0 +1,106 @@
+//
+// BoundedQueue.h
+//
+// Library: Common
+// Package: Pipeline
+// Module:  BoundedQueue
+//
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <cstddef>
+#include <condition_variable>
+
+namespace Mmp
+{
+
+/**
+ * @brief  有界阻塞队列, 用于流水线各级之间传递数据
+ * @note   Close 之后 Push 失败, Pop 取完剩余数据后失败
+ */
+template<typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity)
+    {
+        _capacity = capacity == 0 ? 1 : capacity;
+        _closed   = false;
+    }
+public:
+    bool Push(T value)
+    {
+        std::unique_lock<std::mutex> lock(_mtx);
+        _notFull.wait(lock, [this]() { return _closed || _queue.size() < _capacity; });
+        if (_closed)
+        {
+            return false;
+        }
+        _queue.push_back(std::move(value));
+        _notEmpty.notify_one();
+        return true;
+    }
+    bool TryPush(T value)
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_closed || _queue.size() >= _capacity)
+        {
+            return false;
+        }
+        _queue.push_back(std::move(value));
+        _notEmpty.notify_one();
+        return true;
+    }
+    bool Pop(T& value)
+    {
+        std::unique_lock<std::mutex> lock(_mtx);
+        _notEmpty.wait(lock, [this]() { return _closed || !_queue.empty(); });
+        if (_queue.empty())
+        {
+            return false;
+        }
+        value = std::move(_queue.front());
+        _queue.pop_front();
+        _notFull.notify_one();
+        return true;
+    }
+    bool TryPop(T& value)
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_queue.empty())
+        {
+            return false;
+        }
+        value = std::move(_queue.front());
+        _queue.pop_front();
+        _notFull.notify_one();
+        return true;
+    }
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _closed = true;
+        _notEmpty.notify_all();
+        _notFull.notify_all();
+    }
+    size_t Size()
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        return _queue.size();
+    }
+    size_t Capacity()
+    {
+        return _capacity;
+    }
+private:
+    std::mutex               _mtx;
+    std::condition_variable  _notEmpty;
+    std::condition_variable  _notFull;
+    std::deque<T>            _queue;
+    size_t                   _capacity;
+    bool                     _closed;
+};
+
+} // namespace Mmp
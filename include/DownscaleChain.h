@@ -0,0 +1,67 @@
+//
+// DownscaleChain.h
+//
+// Library: Common
+// Package: PG
+// Module:  DownscaleChain
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "Common/PixelsInfo.h"
+#include "GPU/GL/GLCommon.h"
+#include "GPU/PG/AbstractSceneItem.h"
+#include "GPU/PG/AbstractSceneLayer.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  单个画面的预缩放链 (类似 mipmap)
+ * @note   1 - level 0 为原始纹理, level n 的宽高为 level n-1 的一半, 直到小于 minSize
+ *         2 - 每一级由上一级通过一次 2:1 的双线性采样生成, 等效于 2x2 box filter
+ *         3 - 原始纹理内容变化后需要调用 Build 重新生成
+ *         4 - 常驻的只有各级纹理; 绘制所需的 canvas 及 layer/item 只在 Build 期间存在, 逐级创建后随即释放
+ */
+class DownscaleChain
+{
+public:
+    using ptr = std::shared_ptr<DownscaleChain>;
+public:
+    explicit DownscaleChain(const PixelsInfo& info, uint32_t minSize = 64);
+public:
+    /**
+     * @brief      根据 source 生成所有缩放级别
+     */
+    void Build(Texture::ptr source);
+    /**
+     * @brief      选择最接近且不小于目标尺寸的级别
+     * @param[in]  width  : 屏幕上显示的宽度(像素)
+     * @param[in]  height : 屏幕上显示的高度(像素)
+     */
+    size_t Select(uint32_t width, uint32_t height);
+public:
+    size_t GetLevelCount();
+    Texture::ptr GetLevel(size_t level);
+    const PixelsInfo& GetLevelInfo(size_t level);
+    /**
+     * @brief      level 1 及以上常驻纹理的字节数
+     */
+    uint64_t GetResidentBytes();
+private:
+    class Level
+    {
+    public:
+        PixelsInfo    info;
+        Texture::ptr  texture;
+    };
+private:
+    std::vector<Level>  _levels;
+};
+
+} // namespace Mmp
@@ -0,0 +1,112 @@
+//
+// FrameScaler.h
+//
+// Library: Common
+// Package: Display
+// Module:  FrameScaler
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "Common/PixelsInfo.h"
+#include "Common/AbstractPicture.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  缩放算法
+ */
+enum class ScaleFilter
+{
+    AREA = 0,    // 按覆盖面积加权平均, 缩小时不混叠, 适合大倍率缩小
+    BILINEAR,    // 双线性, 缩小超过 2 倍时会混叠
+};
+
+/**
+ * @brief      在 maxWidth x maxHeight 内按比例缩小, 宽高向下取偶数
+ * @note       info 本身在范围内时原样返回, 不放大
+ */
+PixelsInfo FitToDisplay(const PixelsInfo& info, uint32_t maxWidth, uint32_t maxHeight);
+
+/**
+ * @brief  CPU 画面缩放, 支持 RGBA8888 / BGRA8888 / NV12 / YUV420P, 源与目标像素格式相同
+ * @note   1 - 可分离滤波: 先纵向 (SSE2 / NEON, 每次 16 字节) 累加到 16 位中间行, 再横向加权输出;
+ *             系数为 14 位定点, 构造时按源/目标尺寸一次性算好
+ *         2 - 横向同样为 SSE2 / NEON: 四通道每次一个像素的 4 个通道; 单通道每次 4 个输出像素, 双通道 (NV12 的 UV)
+ *             每次 2 个输出像素, 系数按 4 / 2 个一组补零对齐, 中间行末尾留有对应的余量
+ *         3 - 按目标行分段, 在 WorkStealingPool 上并行, 第一段在调用线程处理; 中间行缓冲按段预先分配,
+ *             Scale 过程中除提交任务外不发生堆分配
+ *         4 - 线程安全性与 ConvertRGBAToNV12 相同: 同一个 FrameScaler 不能同时在多个线程上 Scale
+ *         5 - 像素格式不支持、源与目标格式不同或宽高小于 2 时构造不失败, IsValid 返回 false, Scale 不做任何处理
+ */
+class FrameScaler
+{
+public:
+    using ptr = std::shared_ptr<FrameScaler>;
+public:
+    /**
+     * @param[in]  bands : 分段数, 0 表示按 CPU 核数分段
+     */
+    FrameScaler(const PixelsInfo& src, const PixelsInfo& dst, ScaleFilter filter = ScaleFilter::AREA, uint32_t bands = 0);
+public:
+    static bool IsSupported(PixelFormat format);
+    bool IsValid();
+    /**
+     * @brief      按平面缩放, 可直接写入加锁的纹理内存
+     * @param[in]  src/srcStride : 各平面地址及跨距 (字节), 平面数由像素格式决定
+     * @param[in]  dst/dstStride : 同上
+     */
+    void Scale(const uint8_t* const src[3], const int32_t srcStride[3], uint8_t* const dst[3], const int32_t dstStride[3]);
+    /**
+     * @brief      缩放紧密排列的画面
+     * @param[in]  dst : 为空时内部新建
+     * @return     IsValid 为 false 时返回 nullptr
+     */
+    AbstractPicture::ptr Scale(AbstractPicture::ptr src, AbstractPicture::ptr dst = nullptr);
+public:
+    const PixelsInfo& GetSrcInfo();
+    const PixelsInfo& GetDstInfo();
+private:
+    /**
+     * @brief  一个方向上的定点滤波系数, 每个输出位置固定 taps 个输入
+     */
+    class FilterTable
+    {
+    public:
+        uint32_t              taps;
+        std::vector<int32_t>  offset;   // 第一个输入的位置 (像素)
+        std::vector<int16_t>  weight;   // offset.size() * taps, 每组之和为 1 << 14
+        // 单/双通道横向 SIMD 使用: 每组补零至 simdTaps 个, 并按通道展开 (w0 w0 w1 w1 ...), 每组 simdTaps * channels 个
+        uint32_t              simdTaps;
+        std::vector<int16_t>  simdWeight;
+    };
+    class Plane
+    {
+    public:
+        uint32_t     srcWidth;
+        uint32_t     srcHeight;
+        uint32_t     dstWidth;
+        uint32_t     dstHeight;
+        uint32_t     channels;
+        FilterTable  horizontal;
+        FilterTable  vertical;
+    };
+private:
+    static void BuildTable(FilterTable& table, uint32_t srcSize, uint32_t dstSize, ScaleFilter filter);
+    static void BuildSimdTable(FilterTable& table, uint32_t channels);
+    void ScaleRows(size_t band, const uint8_t* const src[3], const int32_t srcStride[3], uint8_t* const dst[3], const int32_t dstStride[3]);
+private:
+    PixelsInfo                           _srcInfo;
+    PixelsInfo                           _dstInfo;
+    ScaleFilter                          _filter;
+    bool                                 _valid;
+    std::vector<Plane>                   _planes;
+    std::vector<std::vector<uint16_t>>   _rowBuffers;   // 每段一行纵向结果
+};
+
+} // namespace Mmp
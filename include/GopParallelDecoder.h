@@ -0,0 +1,86 @@
+//
+// GopParallelDecoder.h
+//
+// Library: Common
+// Package: Codec
+// Module:  GopParallelDecoder
+//
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <string>
+#include <functional>
+#include <condition_variable>
+
+#include "Common/AbstractFrame.h"
+#include "Codec/CodecFactory.h"
+
+#include "AnnexBIndex.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  按 GOP 切分的多解码器并行解码
+ * @note   1 - 以 AnnexBIndex 的随机访问点将输入切分为若干段, 每个工作线程持有独立的
+ *             AbstractDecoder 实例, 依次领取段进行解码
+ *         2 - 每个工作线程只 Init 一次解码器; 每段送完后送入结束标记 (CreateEndOfStreamPack) 取出全部缓存帧,
+ *             下一段从 IDR 开始送入, 不受前一段影响
+ *         3 - 解码结果进入重排缓冲, 按段序号顺序回调, 即整体按显示顺序输出
+ *         4 - 解码领先输出的段数不超过 maxPendingSegments, 限制重排缓冲占用的内存
+ *         5 - 仅适用于离线处理, 要求以 IDR 切分的段可以独立解码 (H.265 CRA 之后的 RASL 帧会被丢弃)
+ */
+class GopParallelDecoder
+{
+public:
+    using ptr = std::shared_ptr<GopParallelDecoder>;
+    using FrameCallback = std::function<void(AbstractFrame::ptr frame)>;
+public:
+    GopParallelDecoder(const std::string& decoderClassName, Codec::CodecType codecType, size_t workers);
+    ~GopParallelDecoder();
+public:
+    /**
+     * @brief      阻塞解码整个文件
+     * @param[in]  callback : 按显示顺序在调用线程上回调
+     * @return     输出帧数, 建立索引或创建解码器失败时返回 0 (即使失败前已有部分帧回调)
+     */
+    uint64_t Run(const std::string& path, const FrameCallback& callback);
+    void SetMaxPendingSegments(size_t segments);
+    /**
+     * @brief      送入结束标记后的等待超时时间, 默认 2000 ms; 段内帧全部取出即返回, 超时仅用于解码器异常时兜底
+     */
+    void SetFrameTimeout(uint32_t ms);
+private:
+    class Segment
+    {
+    public:
+        uint64_t               begin;
+        uint64_t               end;
+        uint64_t               frames;
+        std::vector<uint64_t>  parameterSets;
+    };
+    void WorkerProc(size_t id, const std::string& path);
+    void DecodeSegment(Codec::AbstractDecoder::ptr decoder, H26XFileByteReader& reader, size_t index, std::vector<AbstractFrame::ptr>& frames);
+private:
+    std::string                      _decoderClassName;
+    Codec::CodecType                 _codecType;
+    size_t                           _workers;
+    size_t                           _maxPendingSegments;
+    uint32_t                         _frameTimeoutMs;
+    std::vector<Segment>             _segments;
+    std::atomic<size_t>              _nextSegment;
+private: /* reorder buffer */
+    std::mutex                                          _mtx;
+    std::condition_variable                             _cond;
+    std::map<size_t, std::vector<AbstractFrame::ptr>>   _reorder;
+    size_t                                              _nextOutput;
+    bool                                                _abort;
+};
+
+} // namespace Mmp
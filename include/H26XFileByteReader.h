@@ -0,0 +1,77 @@
+//
+// H26XFileByteReader.h
+//
+// Library: Common
+// Package: Codec
+// Module:  H26XFileByteReader
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Codec/StreamPack.h"
+
+#include "AbstractByteSource.h"
+#include "AbstractPacketReader.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  Annex-B (H.264/H.265) 裸流读取, 按 NAL 输出
+ * @note   输入可以是文件, 管道或套接字 (见 AbstractByteSource), 仅文件支持任意位置 Seek
+ */
+class H26XFileByteReader : public AbstractPacketReader
+{
+public:
+    /**
+     * @param[in]  path : 文件路径或 AbstractByteSource 支持的 url
+     */
+    explicit H26XFileByteReader(const std::string& path, Codec::CodecType codecType = Codec::CodecType::H264);
+    explicit H26XFileByteReader(AbstractByteSource::ptr source, Codec::CodecType codecType = Codec::CodecType::H264);
+    ~H26XFileByteReader();
+public:
+    /**
+     * @brief 输入源是否打开成功, 失败时 GetNalUint 始终返回 nullptr
+     */
+    bool IsOpen() override;
+    Codec::StreamPack::ptr GetNalUint();
+    /**
+     * @brief 同 GetNalUint
+     */
+    Codec::StreamPack::ptr GetPacket() override;
+    Codec::CodecType GetCodecType() override;
+    /**
+     * @brief 图像的第一个 slice 返回 true
+     */
+    bool IsPictureStart(const Codec::StreamPack::ptr& pack) override;
+    /**
+     * @brief 上一次 GetNalUint 返回的 NAL 起始码在文件中的偏移
+     */
+    size_t GetLastNalOffset();
+public:
+    size_t Read(void* data, size_t bytes);
+    bool Seek(size_t offset);
+    size_t Tell();
+    bool eof();
+private:
+    bool Fill();
+private:
+    AbstractByteSource::ptr _source;
+    Codec::CodecType _codecType;
+private:
+    uint8_t* _buf;
+    size_t _offset;
+    uint32_t _cur;
+    uint32_t _len;
+    size_t _lastNalOffset;
+    /**
+     * @note 组帧用的缓冲, 组帧完成后交给输出的 pack, 并按上一个 NAL 的容量重新预留
+     */
+    std::vector<uint8_t> _scratch;
+};
+
+} // namespace Mmp
@@ -0,0 +1,66 @@
+//
+// IvfDemuxer.h
+//
+// Library: Common
+// Package: Codec
+// Module:  IvfDemuxer
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "AbstractPacketReader.h"
+#include "MappedFile.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  IVF 解封装 (VP8 / VP9 / AV1), 按帧输出
+ * @note   1 - 布局 (小端): 32 字节文件头 (DKIF, 版本, 头大小, fourcc, 宽高, 帧率, 帧数),
+ *             之后每帧为 12 字节帧头 (大小 + pts) 加帧数据
+ *         2 - 文件以 MAP_PRIVATE 映射, pack 直接引用映射中的帧数据, 不拷贝也不改写
+ *         3 - 打开时只遍历帧头建立索引; 关键帧判断: VP8 / VP9 取未压缩头中的 frame_type,
+ *             AV1 以时间单元中含 sequence header OBU 视为随机访问点
+ */
+class IvfDemuxer : public AbstractPacketReader
+{
+public:
+    using ptr = std::shared_ptr<IvfDemuxer>;
+public:
+    IvfDemuxer();
+public:
+    bool Open(const std::string& path);
+public:
+    bool IsOpen() override;
+    Codec::StreamPack::ptr GetPacket() override;
+    Codec::CodecType GetCodecType() override;
+    bool IsPictureStart(const Codec::StreamPack::ptr& pack) override;
+    bool SeekToFrame(uint64_t frame, uint64_t& keyFrame) override;
+public:
+    uint64_t GetFrameCount();
+    uint32_t GetWidth();
+    uint32_t GetHeight();
+public:
+    static bool IsKeyFrame(Codec::CodecType codecType, const uint8_t* data, size_t size);
+private:
+    class Frame
+    {
+    public:
+        uint64_t  offset;
+        uint32_t  size;
+        bool      keyFrame;
+    };
+private:
+    MappedFile::ptr     _file;
+    Codec::CodecType    _codecType;
+    uint32_t            _width;
+    uint32_t            _height;
+    std::vector<Frame>  _frames;
+    size_t              _cur;
+};
+
+} // namespace Mmp
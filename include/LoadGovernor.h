@@ -0,0 +1,107 @@
+//
+// LoadGovernor.h
+//
+// Library: Common
+// Package: Profile
+// Module:  LoadGovernor
+//
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+namespace Mmp
+{
+
+/**
+ * @brief  降级等级, 逐级叠加
+ */
+enum class GovernorLevel
+{
+    NORMAL = 0,
+    SKIP_READBACK,      // 隔帧读回, 未读回的帧也不显示
+    DROP_DISPLAY,       // 显示线程忙时直接丢弃本帧, 不再等待
+    LOWER_RESOLUTION,   // 合成时采样低一级分辨率的画面
+    REDUCE_FPS,         // 输出帧率减半
+    COUNT
+};
+
+const std::string& GovernorLevelToStr(GovernorLevel level);
+
+/**
+ * @brief  过载降级控制
+ * @note   1 - 每帧调用 Update 传入本帧处理耗时 (不含等待), 按窗口内平均耗时与正常帧间隔 (不随 REDUCE_FPS 加倍) 的比值判断负载
+ *         2 - 超过 overload 比例时升一级, 低于 recover 比例时降一级; 每次变化后至少观察一个窗口,
+ *             两个阈值之间不变化, 避免来回抖动
+ *         3 - WaitNextFrame 按绝对截止时间节拍, 落后超过一帧时重置节拍而不是连续追赶
+ *         4 - 所有决策以计数器形式在 Report 中输出 (同时以 PERF 行导出)
+ */
+class LoadGovernor
+{
+public:
+    using ptr = std::shared_ptr<LoadGovernor>;
+public:
+    explicit LoadGovernor(uint32_t fps);
+public:
+    /**
+     * @param[in]  enable : 为 false 时只做节拍, 不降级
+     */
+    void SetEnable(bool enable);
+    void SetWindow(uint32_t frames);
+    void SetThresholds(double overload, double recover);
+    /**
+     * @brief      禁止某一级降级 (如转场没有可降低的分辨率), 升降级时跳过该级
+     */
+    void SetLevelEnabled(GovernorLevel level, bool enable);
+    GovernorLevel Update(int64_t costUs);
+    GovernorLevel GetLevel();
+public:
+    /**
+     * @brief      本帧是否读回, 返回 false 时计入 skipped readbacks
+     */
+    bool ShouldReadback(uint64_t frameIndex);
+    /**
+     * @brief      显示线程忙时是否丢弃本帧而不是等待
+     */
+    bool ShouldDropBusyDisplay();
+    void RecordDroppedDisplay();
+    /**
+     * @brief      分辨率降低的级数, 0 表示不降低
+     */
+    uint32_t GetResolutionShift();
+    int64_t GetFrameIntervalUs();
+    /**
+     * @brief      等待至下一帧的截止时间
+     */
+    void WaitNextFrame();
+    void Report(const std::string& prefix);
+private:
+    bool IsLevelEnabled(size_t level);
+private:
+    uint32_t   _fps;
+    bool       _enable;
+    uint32_t   _window;
+    double     _overload;
+    double     _recover;
+    bool       _levelEnabled[(size_t)GovernorLevel::COUNT];
+    size_t     _level;
+private:
+    uint32_t   _windowFrames;
+    int64_t    _windowCostUs;
+    std::chrono::steady_clock::time_point _deadline;
+    bool       _started;
+private: /* counters */
+    uint64_t   _frames;
+    uint64_t   _overloadFrames;
+    uint64_t   _escalations;
+    uint64_t   _recoveries;
+    uint64_t   _skippedReadbacks;
+    uint64_t   _droppedDisplays;
+    uint64_t   _lateFrames;
+    uint64_t   _framesAtLevel[(size_t)GovernorLevel::COUNT];
+};
+
+} // namespace Mmp
@@ -0,0 +1,71 @@
+//
+// MappedFile.h
+//
+// Library: Common
+// Package: Stream
+// Module:  MappedFile
+//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Common/AbstractAllocateMethod.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  只读文件的私有映射 (MAP_PRIVATE), 写入时按页复制, 不写回文件
+ * @note   Windows 下退化为整体读入内存
+ */
+class MappedFile
+{
+public:
+    using ptr = std::shared_ptr<MappedFile>;
+public:
+    MappedFile();
+    ~MappedFile();
+public:
+    bool Open(const std::string& path);
+    /**
+     * @brief      提示内核预读 [offset, offset + size), 不阻塞
+     */
+    void WillNeed(size_t offset, size_t size);
+    /**
+     * @brief      提示内核按顺序访问, 加大预读窗口
+     */
+    void Sequential();
+    uint8_t* GetData();
+    size_t GetSize();
+private:
+    uint8_t*              _data;
+    size_t                _size;
+#ifdef _WIN32
+    std::vector<uint8_t>  _buffer;
+#endif
+};
+
+/**
+ * @brief  以映射中的一段作为 picture / pack 的内存, 持有映射直至使用者释放
+ * @note   不分配也不拷贝, Malloc 只返回映射中的地址; 请求大小超出映射范围时返回 nullptr
+ */
+class MappedFileAllocateMethod : public AbstractAllocateMethod
+{
+public:
+    MappedFileAllocateMethod(MappedFile::ptr file, uint64_t offset, uint64_t size);
+public:
+    void* Malloc(size_t size) override;
+    void* Resize(void* data, size_t size) override;
+    void* GetAddress(uint64_t offset) override;
+    const std::string& Tag() override;
+private:
+    MappedFile::ptr  _file;
+    uint64_t         _offset;
+    uint64_t         _size;
+};
+
+} // namespace Mmp
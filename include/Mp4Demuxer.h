@@ -0,0 +1,102 @@
+//
+// Mp4Demuxer.h
+//
+// Library: Common
+// Package: Codec
+// Module:  Mp4Demuxer
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "AbstractPacketReader.h"
+#include "MappedFile.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  MP4 / MOV 解封装, 按 sample 输出第一条视频轨道
+ * @note   1 - 支持 avc1/avc3 (H.264), hvc1/hev1 (H.265), vp09 (VP9), av01 (AV1); 不支持分片 MP4 (moof)
+ *         2 - 文件以 MAP_PRIVATE 映射, pack 直接引用映射中的 sample, 不拷贝
+ *         3 - H.264 / H.265 的 sample 为长度前缀格式, 长度字段为 4 字节时首次输出前原地改写为起始码 00 00 00 01,
+ *             仅被写到的页发生写时复制; 长度字段为 1/2/3 字节时无法原地改写, 拷贝为 Annex-B (计入 GetCopiedSamples)
+ *         4 - avcC / hvcC 中的参数集在打开及 Seek 后作为一个单独的 Annex-B pack 先行输出
+ *         5 - 关键帧取自 stss, 没有 stss 时所有 sample 均为关键帧
+ */
+class Mp4Demuxer : public AbstractPacketReader
+{
+public:
+    using ptr = std::shared_ptr<Mp4Demuxer>;
+public:
+    Mp4Demuxer();
+public:
+    bool Open(const std::string& path);
+public:
+    bool IsOpen() override;
+    Codec::StreamPack::ptr GetPacket() override;
+    Codec::CodecType GetCodecType() override;
+    bool IsPictureStart(const Codec::StreamPack::ptr& pack) override;
+    bool SeekToFrame(uint64_t frame, uint64_t& keyFrame) override;
+public:
+    uint64_t GetSampleCount();
+    /**
+     * @brief      无法原地转换而拷贝输出的 sample 数
+     */
+    uint64_t GetCopiedSamples();
+    uint32_t GetWidth();
+    uint32_t GetHeight();
+private:
+    class Sample
+    {
+    public:
+        uint64_t  offset;
+        uint32_t  size;
+        bool      keyFrame;
+        bool      converted;   // 长度前缀已改写为起始码
+    };
+    class Track
+    {
+    public:
+        Track();
+    public:
+        bool                   video;
+        bool                   supported;
+        Codec::CodecType       codecType;
+        uint32_t               width;
+        uint32_t               height;
+        uint32_t               lengthSize;     // 0 表示 sample 不是长度前缀格式 (VP9 / AV1)
+        std::vector<uint8_t>   parameterSets;  // Annex-B
+        uint32_t               defaultSize;
+        std::vector<uint32_t>  sizes;
+        std::vector<uint32_t>  stscFirstChunk;
+        std::vector<uint32_t>  stscSamplesPerChunk;
+        std::vector<uint64_t>  chunkOffsets;
+        std::vector<uint32_t>  syncSamples;    // 从 1 开始
+        bool                   hasSyncTable;
+    };
+private:
+    /**
+     * @param[in]  parent : 当前层级所在的 box 类型
+     */
+    bool ParseTrack(uint64_t begin, uint64_t end, uint32_t parent, Track& track);
+    bool ParseSampleEntry(uint64_t begin, uint64_t end, Track& track);
+    bool BuildSamples(const Track& track);
+    Codec::StreamPack::ptr ConvertSample(Sample& sample);
+private:
+    MappedFile::ptr                _file;
+    Codec::CodecType               _codecType;
+    uint32_t                       _width;
+    uint32_t                       _height;
+    uint32_t                       _lengthSize;
+    std::vector<Sample>            _samples;
+    Codec::StreamPack::ptr         _parameterSetPack;
+    size_t                         _cur;
+    bool                           _sendParameterSets;
+    uint64_t                       _copiedSamples;
+};
+
+} // namespace Mmp
@@ -0,0 +1,53 @@
+//
+// NV12Converter.h
+//
+// Library: Common
+// Package: PG
+// Module:  NV12Converter
+//
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include "Common/AbstractPicture.h"
+#include "GPU/GL/GLCommon.h"
+
+#include "YUVColor.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  RGBA8888 -> NV12 (Y 平面 + UV 交错平面), 按行分段并行转换
+ * @param[in] bands : 分段数, 0 表示按 CPU 核数分段
+ * @note   宽高需为偶数, UV 取 2x2 像素的均值
+ */
+void ConvertRGBAToNV12(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* nv12, const RGBToYUVCoeff& coeff, uint32_t bands = 0);
+
+/**
+ * @brief  将 RGBA 渲染结果读回后在 CPU 上转换为 NV12 画面, 供编码等下游直接使用
+ * @note   读回的仍是整帧 RGBA (4 字节/像素), 不减少 GPU -> CPU 的传输量, 只省去下游自行转换
+ */
+class NV12Converter
+{
+public:
+    using ptr = std::shared_ptr<NV12Converter>;
+public:
+    NV12Converter(const PixelsInfo& info, YUVColorSpace space = YUVColorSpace::BT709, YUVColorRange range = YUVColorRange::LIMITED);
+public:
+    /**
+     * @brief      以 RGBA 读回 framebuffer 并转换到 picture
+     * @param[in]  picture : NV12 画面, 为空时内部新建
+     */
+    AbstractPicture::ptr ReadbackAndConvert(Texture::ptr framebuffer, AbstractPicture::ptr picture = nullptr);
+public:
+    const PixelsInfo& GetNV12Info();
+private:
+    PixelsInfo            _nv12Info;
+    RGBToYUVCoeff         _coeff;
+    AbstractPicture::ptr  _rgba;
+};
+
+} // namespace Mmp
@@ -0,0 +1,56 @@
+//
+// PacketReplayCache.h
+//
+// Library: Common
+// Package: Codec
+// Module:  PacketReplayCache
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "Codec/StreamPack.h"
+
+#include "AbstractPacketReader.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  码流包内存回放缓存
+ * @note   1 - 一次性将 reader 剩余的所有包 (Annex-B 为 NAL, MP4 / IVF 为帧) 读入一块连续内存, 之后回放不再有文件读取及解析开销
+ *         2 - GetPack 返回的 StreamPack 直接引用缓存内存, 不发生拷贝; 缓存内存由 StreamPack 共享持有,
+ *             解码器异步持有 pack 期间缓存对象可以安全析构
+ *         3 - StreamPack 在 Load 时一次性创建, 回放期间重复送入同一个对象, GetPack 不发生堆分配;
+ *             因此调用方不应修改返回 pack 的属性 (如 pts)
+ */
+class PacketReplayCache
+{
+public:
+    using ptr = std::shared_ptr<PacketReplayCache>;
+public:
+    explicit PacketReplayCache(Codec::CodecType codecType = Codec::CodecType::H264);
+public:
+    /**
+     * @brief      从 reader 当前位置读取至文件结束, 替换之前缓存的内容
+     * @return     读取的包数
+     */
+    size_t Load(AbstractPacketReader& reader);
+    Codec::StreamPack::ptr GetPack(size_t index);
+    size_t GetPackCount();
+    /**
+     * @brief      缓存中的帧数 (按 IsPictureStart 计数), 用于回放结束后等待解码器输出全部帧
+     */
+    uint64_t GetPictureCount();
+    uint64_t GetBytes();
+private:
+    Codec::CodecType                        _codecType;
+    uint64_t                                _pictures;
+    std::shared_ptr<std::vector<uint8_t>>   _arena;
+    std::vector<Codec::StreamPack::ptr>     _packs;
+};
+
+} // namespace Mmp
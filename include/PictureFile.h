@@ -0,0 +1,59 @@
+//
+// PictureFile.h
+//
+// Library: Common
+// Package: Utility
+// Module:  PictureFile
+//
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include "Common/PixelsInfo.h"
+#include "Common/AbstractPicture.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  PictureFile 的负载压缩方式
+ */
+enum class PictureCompression
+{
+    RAW = 0,   // 不压缩, 加载时 mmap 后直接作为 picture 的内存, 不拷贝
+    LZ4 = 1,   // LZ4 块格式, 按 1 MiB 分块独立压缩, 加载时在 WorkStealingPool 上并行解压
+};
+
+/**
+ * @brief  预解码的图片文件 (.mpic), 替代每次启动时解码内嵌的 PNG
+ * @note   1 - 布局 (小端):
+ *               [0, 64)   头: magic "MPIC", 版本, 压缩方式, PixelsInfo, 负载大小, 负载偏移, 分块大小及分块数
+ *               [64, ...) LZ4 时为各分块压缩后的大小 (uint32)
+ *               负载      从 4096 字节对齐处开始, 按 NormalPicture 的内存布局依次存放各平面,
+ *                         mmap 后负载首地址页对齐, 可直接用于纹理上传
+ *         2 - 像素格式以文件内固定的编号保存, 与 MMP-Core 中 PixelFormat 的取值无关
+ *         3 - RAW 加载为 MAP_PRIVATE 映射, 修改 picture 不会写回文件; Windows 下退化为整体读取
+ *         4 - 失败时输出日志并返回 nullptr / false, 不抛异常
+ */
+class PictureFile
+{
+public:
+    /**
+     * @brief      将 picture 保存为 .mpic
+     * @note       picture 的内存需按 NormalPicture 布局连续存放
+     */
+    static bool Save(const std::string& path, AbstractPicture::ptr picture, PictureCompression compression = PictureCompression::RAW);
+    /**
+     * @brief      加载 .mpic
+     * @return     RAW 时返回的 picture 持有文件映射, 释放 picture 时解除映射
+     */
+    static AbstractPicture::ptr Load(const std::string& path);
+    /**
+     * @brief      只读取头部信息
+     */
+    static bool ReadInfo(const std::string& path, PixelsInfo& info, PictureCompression& compression);
+};
+
+} // namespace Mmp
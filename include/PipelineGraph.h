@@ -0,0 +1,202 @@
+//
+// PipelineGraph.h
+//
+// Library: Common
+// Package: Pipeline
+// Module:  PipelineGraph
+//
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <typeinfo>
+#include <functional>
+
+#include <Poco/Timestamp.h>
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include "BoundedQueue.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  流水线中在节点之间传递的数据
+ * @note   payload 为任意 shared_ptr (StreamPack / StreamFrame / Texture / AbstractPicture ...),
+ *         Get<T> 在类型不一致时返回 nullptr; index 与 born 由源节点输出时填写, 下游沿用同一个 item 时保留
+ */
+class PipelineItem
+{
+public:
+    PipelineItem();
+public:
+    template<typename T>
+    void Set(std::shared_ptr<T> value)
+    {
+        payload = value;
+        type = value ? &typeid(T) : nullptr;
+    }
+    template<typename T>
+    std::shared_ptr<T> Get() const
+    {
+        if (!type || *type != typeid(T))
+        {
+            return nullptr;
+        }
+        return std::static_pointer_cast<T>(payload);
+    }
+public:
+    uint64_t               index;
+    Poco::Timestamp        born;      // 源节点产生的时间, 用于统计到达各节点的延迟
+    std::shared_ptr<void>  payload;
+    const std::type_info*  type;
+};
+
+class PipelineEmitter;
+
+/**
+ * @brief  流水线节点, 节点类型由使用方注册 (目前只有 test_decoder 的 reader / decode / display) 或为内置的 rate / null
+ * @note   1 - 没有输入的节点为源节点, Process 被反复调用 (item 为空), 返回 false 表示数据结束
+ *         2 - 有输入的节点每取到一个 item 调用一次 Process, 可以输出任意个 item;
+ *             返回 false 表示停止整个流水线 (出错或已处理足够的数据)
+ *         3 - 输入结束后调用一次 Flush, 用于输出内部缓存的数据 (如解码器中尚未取出的帧)
+ *         4 - 每个节点只在一个线程上被调用, 节点内部不需要加锁
+ */
+class PipelineNode
+{
+public:
+    using ptr = std::shared_ptr<PipelineNode>;
+    using ProcessFunc = std::function<bool(PipelineItem& item, PipelineEmitter& emitter)>;
+    using FlushFunc = std::function<void(PipelineEmitter& emitter)>;
+public:
+    virtual ~PipelineNode() = default;
+public:
+    /**
+     * @brief      以函数构造节点, 用于捕获 sample 内的状态
+     */
+    static PipelineNode::ptr Create(ProcessFunc process, FlushFunc flush = nullptr);
+public:
+    /**
+     * @param[in]  config : pipeline.<name> 下的配置视图, 节点自定义的参数从这里读取
+     */
+    virtual bool Init(const Poco::Util::AbstractConfiguration& config);
+    virtual bool Process(PipelineItem& item, PipelineEmitter& emitter) = 0;
+    virtual void Flush(PipelineEmitter& emitter);
+};
+
+/**
+ * @brief  单个节点的运行统计
+ */
+class PipelineNodeStats
+{
+public:
+    PipelineNodeStats();
+public:
+    std::string  name;
+    std::string  type;
+    uint64_t     itemsIn;
+    uint64_t     itemsOut;
+    int64_t      busyUs;        // Process / Flush 耗时, 不含阻塞在下游队列上的时间
+    int64_t      inputWaitUs;   // 等待输入 (上游慢)
+    int64_t      outputWaitUs;  // 等待下游队列空位 (下游慢)
+    int64_t      latencyUs;     // item 到达本节点时距离 born 的累计时间
+    size_t       queueDepth;    // 输入队列容量, 源节点为 0
+    size_t       queueHighWater;
+};
+
+/**
+ * @brief  声明式流水线: 节点通过有界队列连接, 每个节点运行在 WorkStealingPool 的一个常驻线程槽上
+ * @note   1 - 配置项 (Poco config key, 与 ThreadPlacement 的 placement.* 相同, 可写在 .properties 中):
+ *               pipeline.nodes                 : 节点名列表, 逗号分隔, 如 "reader,decode,rate,display"
+ *               pipeline.<name>.type           : 节点类型, 默认与节点名相同
+ *               pipeline.<name>.inputs         : 上游节点名列表, 默认为列表中的前一个节点; 配置为空表示源节点
+ *               pipeline.<name>.queue_depth    : 输入队列容量, 默认 2
+ *               pipeline.<name>.thread         : pool (默认) 或 caller, caller 表示在调用 Run 的线程上执行
+ *                                                (需要 GL 上下文的节点), 最多一个
+ *               pipeline.<name>.placement      : 运行前调用 ThreadPlacement::Apply 的阶段, 如 decode / display
+ *             其余 pipeline.<name>.* 由节点的 Init 读取
+ *         2 - 一个节点有多个下游时每个 item 复制给所有下游 (payload 共享); 有多个上游时共用一个输入队列,
+ *             所有上游结束后输入队列才关闭
+ *         3 - 内置类型: rate (按 fps 节拍转发, 参数 fps), null (丢弃所有输入)
+ *         4 - Stop 关闭所有队列, 阻塞在队列上的节点随之退出, 此时不调用 Flush
+ */
+class PipelineGraph
+{
+public:
+    using ptr = std::shared_ptr<PipelineGraph>;
+    using NodeCreator = std::function<PipelineNode::ptr()>;
+public:
+    PipelineGraph();
+    ~PipelineGraph();
+public:
+    void RegisterType(const std::string& type, NodeCreator creator);
+    /**
+     * @brief      按 pipeline.* 配置创建节点并连接
+     * @return     节点类型未注册、上游不存在、存在环或节点 Init 失败时返回 false
+     */
+    bool Build(Poco::Util::AbstractConfiguration& config);
+    /**
+     * @brief      运行直到所有节点结束
+     */
+    void Run();
+    /**
+     * @brief      可在任意线程调用
+     */
+    void Stop();
+public:
+    std::vector<PipelineNodeStats> GetStats();
+    /**
+     * @brief      输出各节点统计, 同时以 PERF 行导出
+     */
+    void Report();
+private:
+    friend class PipelineEmitter;
+    class Node
+    {
+    public:
+        PipelineNode::ptr                           node;
+        std::vector<std::string>                    inputNames;
+        std::shared_ptr<BoundedQueue<PipelineItem>> input;
+        std::vector<Node*>                          outputs;
+        std::atomic<uint32_t>                       runningProducers;
+        bool                                        onCaller;
+        int                                         placement;
+        PipelineNodeStats                           stats;
+    };
+private:
+    void RunNode(Node& node);
+    bool Emit(Node& node, PipelineItem& item);
+private:
+    std::map<std::string, NodeCreator>     _creators;
+    std::vector<std::unique_ptr<Node>>     _nodes;      // 按拓扑序
+    std::atomic<bool>                      _stopped;
+    std::string                            _stopBy;
+    std::mutex                             _mtx;
+    int64_t                                _elapsedUs;
+};
+
+/**
+ * @brief  节点向下游输出 item
+ */
+class PipelineEmitter
+{
+public:
+    /**
+     * @return     流水线已停止时返回 false, 节点应尽快从 Process 返回
+     */
+    bool Emit(PipelineItem& item);
+private:
+    friend class PipelineGraph;
+    PipelineEmitter(PipelineGraph& graph, PipelineGraph::Node& node);
+private:
+    PipelineGraph&        _graph;
+    PipelineGraph::Node&  _node;
+};
+
+} // namespace Mmp
@@ -0,0 +1,85 @@
+//
+// PresentThread.h
+//
+// Library: Common
+// Package: Display
+// Module:  PresentThread
+//
+
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <cstdint>
+#include <condition_variable>
+
+#include "Common/PixelsInfo.h"
+#include "Common/AbstractPicture.h"
+
+#include "AbstractDisplay.h"
+#include "AllocTracker.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  常驻显示线程, 最新帧信箱 (mailbox) 语义
+ * @note   1 - 内部持有 3 块画面: 生产者写入的 back, 等待显示的 ready, 正在显示的 present;
+ *             生产者与显示线程只交换下标, 持锁时间极短, 显示耗时不会阻塞生产者
+ *         2 - Publish 时若上一帧 ready 还未被显示, 直接被新帧替换并计入丢帧; 显示线程总是显示最新的完整帧
+ *         3 - 发布过程不发生堆分配; 画面内存按 ThreadPlacement 的 memory 节点放置
+ */
+class PresentThread
+{
+public:
+    using ptr = std::shared_ptr<PresentThread>;
+public:
+    PresentThread(AbstractDisplay::ptr display, const PixelsInfo& info);
+    ~PresentThread();
+public:
+    void Start();
+    /**
+     * @brief      显示完最后一次发布的画面后退出
+     */
+    void Stop();
+    /**
+     * @brief      生产者当前可以写入的画面, Publish 之前保持不变
+     */
+    AbstractPicture::ptr GetBackBuffer();
+    /**
+     * @brief      发布 back 画面, 不阻塞
+     */
+    void Publish();
+    /**
+     * @brief      是否没有等待显示的画面 (上一次发布的画面已被显示线程取走)
+     */
+    bool IsIdle();
+public:
+    uint64_t GetPublishedCount();
+    uint64_t GetPresentedCount();
+    uint64_t GetDroppedCount();
+private:
+    void ThreadProc();
+private:
+    static constexpr size_t kSlotNum = 3;
+private:
+    AbstractDisplay::ptr     _display;
+    PixelsInfo               _info;
+    AbstractPicture::ptr     _slots[kSlotNum];
+    std::thread              _thread;
+    std::mutex               _mtx;
+    std::condition_variable  _cond;
+    bool                     _running;
+    size_t                   _back;
+    size_t                   _ready;
+    size_t                   _present;
+    bool                     _fresh;
+    AllocStage               _allocStage;
+private: /* statistics */
+    uint64_t                 _published;
+    uint64_t                 _presented;
+    uint64_t                 _dropped;
+};
+
+} // namespace Mmp
@@ -0,0 +1,93 @@
+//
+// RenderThread.h
+//
+// Library: Common
+// Package: GPU
+// Module:  RenderThread
+//
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <cstdint>
+#include <condition_variable>
+
+#include "GPU/GL/GLCommon.h"
+#include "GPU/GL/GLDrawContex.h"
+#include "GPU/Windows/AbstractWindows.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  GPU 渲染线程
+ * @note   1 - 创建窗口并驱动 GLDrawContex::ThreadFrame
+ *         2 - 连续空转(ThreadFrame 很快返回且无需 present)时先 yield, 之后在条件变量上
+ *             指数退避等待, 最长 maxIdleWait; Wake 可立即唤醒
+ *         3 - 有任务时不等待, 一次唤醒内连续执行 ThreadFrame 直到再次空闲
+ */
+class RenderThread
+{
+public:
+    using ptr = std::shared_ptr<RenderThread>;
+public:
+    /**
+     * @brief  同步 GPU 调用 (Update2DTextures / Copy2DTexturesToMemory 等调用方阻塞等待结果的接口) 期间持有
+     * @note   持有期间渲染线程空转时只 yield, 不进入条件变量等待, 避免同步调用额外等待一个退避周期
+     */
+    class SyncScope
+    {
+    public:
+        explicit SyncScope(RenderThread& thread);
+        ~SyncScope();
+    private:
+        RenderThread& _thread;
+    };
+public:
+    explicit RenderThread(GPUBackend backend);
+    ~RenderThread();
+public:
+    /**
+     * @brief      启动渲染线程
+     * @param[in]  waitReady : 是否阻塞直到 GLDrawContex 可用, 为 false 时可在其他初始化
+     *                         完成之后再调用 WaitReady
+     */
+    bool Start(bool waitReady = true);
+    bool WaitReady();
+    /**
+     * @note       未就绪时先等待渲染线程完成初始化
+     */
+    void Stop();
+    /**
+     * @brief      提交 GPU 任务后调用, 结束空闲等待
+     */
+    void Wake();
+    /**
+     * @param[in]  us : 空闲时单次最长等待时间, 默认 1000 us
+     */
+    void SetMaxIdleWait(uint32_t us);
+private:
+    void ThreadProc();
+    void IdleWait(uint32_t us);
+private:
+    GPUBackend               _backend;
+    std::thread              _thread;
+    AbstractWindows::ptr     _window;
+    GLDrawContex::ptr        _draw;
+private:
+    std::mutex               _mtx;
+    std::condition_variable  _cond;
+    bool                     _inited;
+    bool                     _wake;
+    std::atomic<uint32_t>    _maxIdleWaitUs;
+    std::atomic<uint32_t>    _syncCalls;
+private: /* statistics */
+    uint64_t                 _loops;
+    uint64_t                 _idleWaits;
+    uint64_t                 _idleWaitUs;
+};
+
+} // namespace Mmp
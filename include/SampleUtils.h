@@ -8,10 +8,35 @@
 namespace Mmp
 {
 
+/**
+ * @brief 内置画面, 资源目录下存在 A.mpic / B.mpic 时直接 mmap 加载, 否则解码内嵌的 PNG
+ */
 AbstractPicture::ptr GetFrame1920x1080A();
 
 AbstractPicture::ptr GetFrame1920x1080B();
 
+/**
+ * @brief PNG 解码为 RGBA8888
+ */
+AbstractPicture::ptr DecodePng(const uint8_t* data, size_t size);
+
+/**
+ * @brief 预解码资源 (.mpic, 见 PictureFile.h) 所在目录
+ * @note  默认取环境变量 MMP_SAMPLE_ASSET_DIR, 未设置时为编译时生成资源的目录, 为空表示不使用资源
+ */
+void SetAssetDirectory(const std::string& dir);
+const std::string& GetAssetDirectory();
+
+/**
+ * @brief 加载资源目录下的 <name>.mpic, 不存在时返回 nullptr
+ */
+AbstractPicture::ptr LoadAsset(const std::string& name);
+
 GPUBackend GetGPUBackend(const std::string& str);
 
+/**
+ * @brief 输出性能指标, 格式为 "PERF <name> <value>", 供 cmake/PerfCheck.cmake 解析
+ */
+void ReportPerfMetric(const std::string& name, double value);
+
 } // namespace Mmp
\ No newline at end of file
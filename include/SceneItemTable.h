@@ -0,0 +1,87 @@
+//
+// SceneItemTable.h
+//
+// Library: Common
+// Package: PG
+// Module:  SceneItemTable
+//
+
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "GPU/PG/AbstractSceneItem.h"
+#include "GPU/PG/AbstractSceneLayer.h"
+
+namespace Mmp
+{
+
+using SceneItemHandle = uint32_t;
+
+constexpr SceneItemHandle kInvalidSceneItemHandle = UINT32_MAX;
+
+/**
+ * @brief  以 handle 为索引的 Item 表, 管理某一个 Layer 下的所有 Item
+ * @note   1 - 参数按 handle 连续存储, 整墙重排只需要线性写一次; SetParams 保存完整的 SceneItemParam
+ *             (location/area/透明度/旋转等所有字段), 提交时原样传给 Item
+ *         2 - SetParams 只写暂存区, 在下一次 Draw 时一次性(同一把锁内)生效,
+ *             不会出现同一帧内一半 Item 为新布局一半为旧布局的情况
+ *         3 - Item 的 tag 在 Add 时生成一次, 运行过程中不再拼接字符串
+ */
+class SceneItemTable
+{
+public:
+    using ptr = std::shared_ptr<SceneItemTable>;
+public:
+    explicit SceneItemTable(Gpu::AbstractSceneLayer::ptr layer);
+    ~SceneItemTable();
+public:
+    /**
+     * @brief      添加 Item
+     * @return     Item 对应的 handle, 在 Remove 之前保持不变
+     */
+    SceneItemHandle Add(Gpu::AbstractSceneItem::ptr item, const Gpu::SceneItemParam& param);
+    /**
+     * @brief      移除 Item, handle 会被后续的 Add 复用
+     */
+    bool Remove(SceneItemHandle handle);
+    /**
+     * @brief      批量更新参数
+     * @param[in]  first  : 第一个 Item 的 handle
+     * @param[in]  params : 参数数组, params[i] 对应 handle (first + i)
+     * @param[in]  count  : 参数个数
+     * @note       仅写入暂存区, 下一次 Draw 时生效
+     */
+    bool SetParams(SceneItemHandle first, const Gpu::SceneItemParam* params, size_t count);
+    /**
+     * @brief      更新单个 Item 参数
+     * @sa         SetParams
+     */
+    bool SetParam(SceneItemHandle handle, const Gpu::SceneItemParam& param);
+    /**
+     * @brief      提交暂存区的参数后绘制整个 Layer
+     */
+    void Draw(Texture::ptr framebuffer);
+public:
+    size_t Size();
+    Gpu::AbstractSceneItem::ptr GetItem(SceneItemHandle handle);
+private:
+    void Commit();
+private:
+    std::mutex                                 _mtx;
+    Gpu::AbstractSceneLayer::ptr               _layer;
+    std::vector<Gpu::AbstractSceneItem::ptr>   _items;
+    std::vector<std::string>                   _tags;
+    std::vector<Gpu::SceneItemParam>           _params;    // 暂存区, Commit 时生效
+    std::vector<uint8_t>                       _dirty;
+    std::vector<SceneItemHandle>               _freeHandles;
+    size_t                                     _dirtyCount;
+    size_t                                     _size;
+};
+
+} // namespace Mmp
@@ -0,0 +1,89 @@
+//
+// SpscByteRing.h
+//
+// Library: Common
+// Package: Stream
+// Module:  SpscByteRing
+//
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+namespace Mmp
+{
+
+/**
+ * @brief  单生产者单消费者无锁字节环形缓冲
+ * @note   1 - 容量向上取整为 2 的幂
+ *         2 - Write 只能在一个线程调用, Read 只能在另一个线程调用
+ *         3 - 不阻塞, 返回实际写入/读出的字节数
+ */
+class SpscByteRing
+{
+public:
+    explicit SpscByteRing(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        _buf.resize(size);
+        _mask = size - 1;
+        _head = 0;
+        _tail = 0;
+    }
+public:
+    size_t Write(const void* data, size_t bytes)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t tail = _tail.load(std::memory_order_acquire);
+        size_t n = std::min(bytes, _buf.size() - (head - tail));
+        Copy(_buf.data(), head & _mask, (const uint8_t*)data, n);
+        _head.store(head + n, std::memory_order_release);
+        return n;
+    }
+    size_t Read(void* data, size_t bytes)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t head = _head.load(std::memory_order_acquire);
+        size_t n = std::min(bytes, head - tail);
+        size_t pos = tail & _mask;
+        size_t first = std::min(n, _buf.size() - pos);
+        memcpy(data, _buf.data() + pos, first);
+        memcpy((uint8_t*)data + first, _buf.data(), n - first);
+        _tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+    size_t Size()
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+    size_t Free()
+    {
+        return _buf.size() - Size();
+    }
+    size_t Capacity()
+    {
+        return _buf.size();
+    }
+private:
+    void Copy(uint8_t* dst, size_t pos, const uint8_t* src, size_t n)
+    {
+        size_t first = std::min(n, _buf.size() - pos);
+        memcpy(dst + pos, src, first);
+        memcpy(dst, src + first, n - first);
+    }
+private:
+    std::vector<uint8_t>  _buf;
+    size_t                _mask;
+    std::atomic<size_t>   _head;
+    std::atomic<size_t>   _tail;
+};
+
+} // namespace Mmp
@@ -0,0 +1,53 @@
+//
+// StartupTimeline.h
+//
+// Library: Common
+// Package: Profile
+// Module:  StartupTimeline
+//
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <Poco/Timestamp.h>
+
+namespace Mmp
+{
+
+/**
+ * @brief  启动耗时时间线
+ * @note   线程安全, 各步骤可在不同线程上记录
+ */
+class StartupTimeline
+{
+public:
+    StartupTimeline();
+public:
+    /**
+     * @brief      记录一个步骤, 结束时间为调用时刻
+     * @param[in]  begin : 步骤开始时刻
+     */
+    void Record(const std::string& step, const Poco::Timestamp& begin);
+    /**
+     * @brief      按开始时间顺序输出所有步骤, 以及首帧时间
+     */
+    void Dump();
+private:
+    class Step
+    {
+    public:
+        std::string  name;
+        int64_t      beginUs;
+        int64_t      endUs;
+    };
+private:
+    std::mutex         _mtx;
+    Poco::Timestamp    _origin;
+    std::vector<Step>  _steps;
+};
+
+} // namespace Mmp
@@ -0,0 +1,144 @@
+//
+// ThreadPlacement.h
+//
+// Library: Common
+// Package: Profile
+// Module:  ThreadPlacement
+//
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+namespace Mmp
+{
+
+/**
+ * @brief  流水线中的各个线程
+ */
+enum class PipelineStage
+{
+    RENDER = 0,  // RenderThread
+    POOL,        // ThreadPool 工作线程
+    DECODE,      // 送包 (解码输入) 线程
+    DISPLAY,     // 显示线程
+    MAIN,        // 合成/转场主循环
+    COUNT
+};
+
+const std::string& PipelineStageToStr(PipelineStage stage);
+
+/**
+ * @brief  线程绑核及 NUMA 放置
+ * @note   1 - 配置项 (Poco config key, 命令行 --placement <stage>=<spec> 写入同名 key):
+ *               placement.render / placement.pool / placement.decode / placement.display / placement.main
+ *               placement.memory : 帧缓冲所在的 NUMA 节点, 未配置时跟随 placement.display 的节点
+ *             spec 格式: "cpu:0-3,8" 绑定到指定核, "node:1" 绑定到 NUMA 节点的所有核, 为空或 "none" 不绑定
+ *         2 - 各线程启动时调用 Apply 绑定自身, 未配置的阶段保持原有调度
+ *         3 - 统计每个阶段的耗时方差, 以及阶段线程所在节点与访问的帧缓冲所在节点不一致的次数 (跨节点访问);
+ *             Sample 写入当前线程自己的计数, 不加锁; 仅每个线程第一次 Sample 时分配一次计数
+ *             (线程退出时并入总计), Report 时汇总
+ *         4 - 仅 Linux 支持 NUMA 相关功能, 其他平台只支持 cpu 绑定 (Windows 最多 64 核)
+ */
+class ThreadPlacement
+{
+public:
+    static ThreadPlacement& Instance();
+public:
+    /**
+     * @brief      从配置读取所有 placement.* key, 解析失败的 spec 输出警告并忽略
+     */
+    void Load(const Poco::Util::AbstractConfiguration& config);
+    bool Set(PipelineStage stage, const std::string& spec);
+    /**
+     * @brief      将当前线程绑定到 stage 配置的核上
+     * @return     stage 未配置或绑定失败时返回 false
+     */
+    bool Apply(PipelineStage stage);
+    /**
+     * @brief      绑定 ThreadPool 的工作线程
+     * @param[in]  workers : 工作线程数上限
+     * @note       MMP-Core 的 ThreadPool 不暴露工作线程, 通过提交 workers 个互相等待的任务,
+     *             使每个工作线程各执行一次 Apply; 等待有超时, 线程数少于 workers 时不会死锁,
+     *             超时后输出未赶上屏障的任务序号及实际绑定的工作线程数
+     */
+    void ApplyThreadPool(uint32_t workers);
+    /**
+     * @brief      帧缓冲应放置的 NUMA 节点, -1 表示不指定
+     */
+    int GetMemoryNode();
+    /**
+     * @brief      将 [data, data + size) 迁移并绑定到 GetMemoryNode 返回的节点 (按页对齐, 首尾不足一页的部分不处理)
+     */
+    bool BindMemory(void* data, size_t size);
+public:
+    /**
+     * @brief      记录一次阶段耗时
+     * @param[in]  buffer : 本次访问的帧缓冲, 用于判断是否跨节点, 可以为空
+     */
+    void Sample(PipelineStage stage, const void* buffer, int64_t costUs);
+    /**
+     * @brief      输出各阶段的绑定配置、耗时均值/标准差/最大值以及跨节点访问比例
+     */
+    void Report();
+public:
+    static int GetNodeCount();
+    static int GetCurrentNode();
+    static int GetNodeOfAddress(const void* data);
+private:
+    ThreadPlacement();
+    bool ParseSpec(const std::string& spec, std::vector<int>& cpus, int& node);
+private:
+    /**
+     * @note 只由所属线程写入, Report 时由其他线程读取, 因此使用 relaxed 原子变量
+     */
+    class StageCounter
+    {
+    public:
+        StageCounter();
+    public:
+        std::atomic<uint64_t>  samples;
+        std::atomic<uint64_t>  crossNode;
+        std::atomic<uint64_t>  nodeKnown;
+        std::atomic<double>    sumUs;
+        std::atomic<double>    sumSqUs;
+        std::atomic<int64_t>   maxUs;
+    };
+    class ThreadCounters
+    {
+    public:
+        StageCounter  stages[(size_t)PipelineStage::COUNT];
+    };
+    class StageInfo
+    {
+    public:
+        std::string       spec;
+        std::vector<int>  cpus;
+        int               node;
+        // 已退出线程的计数总和
+        uint64_t          samples;
+        uint64_t          crossNode;
+        uint64_t          nodeKnown;
+        double            sumUs;
+        double            sumSqUs;
+        int64_t           maxUs;
+    };
+private:
+    static ThreadCounters& GetThreadCounters();
+    ThreadCounters* AcquireCounters();
+    void ReleaseCounters(ThreadCounters* counters);
+private:
+    std::mutex                       _mtx;
+    StageInfo                        _stages[(size_t)PipelineStage::COUNT];
+    std::vector<ThreadCounters*>     _threadCounters;
+    int                              _memoryNode;
+    std::vector<std::vector<int>>    _nodeCpus;
+};
+
+} // namespace Mmp
@@ -0,0 +1,222 @@
+//
+// WorkStealingPool.h
+//
+// Library: Common
+// Package: Pipeline
+// Module:  WorkStealingPool
+//
+
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+namespace Mmp
+{
+
+/**
+ * @brief  任务优先级
+ */
+enum class TaskPriority
+{
+    REALTIME = 0,   // 每帧的显示/读回等, 截止时间以帧为单位
+    NORMAL,         // 一般并行计算 (资源加载等)
+    BACKGROUND,     // 可延后的后台任务, 至少保留一个工作线程不被后台任务占用
+    COUNT
+};
+
+const std::string& TaskPriorityToStr(TaskPriority priority);
+
+/**
+ * @brief  一组任务的完成计数
+ * @note   Wait 在工作线程上调用时会执行队列中的其他任务, 嵌套并行不会因工作线程耗尽而死锁
+ */
+class TaskGroup
+{
+public:
+    using ptr = std::shared_ptr<TaskGroup>;
+public:
+    TaskGroup();
+public:
+    void Wait();
+    bool Done();
+private:
+    friend class WorkStealingPool;
+    void Add(uint32_t count);
+    void Finish();
+private:
+    std::atomic<uint32_t>    _pending;
+    std::mutex               _mtx;
+    std::condition_variable  _cond;
+};
+
+/**
+ * @brief  单个优先级的调度统计
+ */
+class TaskPriorityStats
+{
+public:
+    TaskPriorityStats();
+public:
+    uint64_t  committed;
+    uint64_t  executed;
+    uint64_t  dispatchNsSum;   // 提交到开始执行的累计时间
+    uint64_t  dispatchNsMax;
+};
+
+/**
+ * @brief  单个工作线程的统计
+ */
+class TaskWorkerStats
+{
+public:
+    TaskWorkerStats();
+public:
+    uint64_t  executed;
+    uint64_t  steals;          // 从其他工作线程队列取得的任务数
+    uint64_t  queueHighWater;  // 本线程队列 (所有优先级之和) 的最大深度
+    uint64_t  queueDepth;      // 当前深度
+};
+
+/**
+ * @brief  带优先级的 work-stealing 线程池, 用于每帧的短任务; 长时间运行的循环使用独立的常驻线程槽
+ * @note   1 - 每个工作线程每个优先级各一个双端队列: 本线程提交的任务压入自己队列尾部并从尾部取 (LIFO, 缓存友好),
+ *             空闲线程从其他队列头部窃取 (FIFO); 外部线程提交的任务轮流分配到各工作线程
+ *         2 - 取任务时按 REALTIME -> NORMAL -> BACKGROUND 的顺序, 每个优先级先查本线程队列再窃取;
+ *             同时运行的 BACKGROUND 任务数不超过工作线程数 - 1, 保证 REALTIME 任务总有线程可用
+ *         3 - CommitLongRunning 的任务运行在独立线程上, 不占用工作线程; 任务结束后线程保留在槽中供下次复用,
+ *             替代提交到 ThreadPool 后长期不返回的显示/读回/编码循环
+ *         4 - ParallelFor 的各段不经过 std::function 复制, 除队列扩容外不发生堆分配
+ *         5 - 工作线程启动时应用 ThreadPlacement 中 pool 阶段的绑核配置 (需先 Load 配置)
+ *         6 - 未 Init 时 Commit / ParallelFor 在当前线程直接执行
+ *         7 - 空闲的工作线程无超时地等待, 只在提交任务或归还后台任务名额 (且仍有排队任务) 时被唤醒
+ */
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void()>;
+    using RangeTask = std::function<void(size_t index)>;
+public:
+    static WorkStealingPool& Instance();
+public:
+    /**
+     * @param[in]  workers : 工作线程数, 0 表示 CPU 核数 - 1 (至少 1)
+     */
+    void Init(uint32_t workers = 0);
+    /**
+     * @brief      等待队列中的任务执行完毕后退出所有线程 (包括常驻线程槽)
+     * @note       仍在运行的常驻任务先调用其 stop, 每个槽最多等待 1 s; 超时的槽记录错误后放弃 (线程分离, 槽不释放),
+     *             避免卡住退出流程
+     */
+    void Uninit();
+    bool IsRunning();
+    uint32_t GetWorkerCount();
+public:
+    /**
+     * @param[in]  group : 可以为空, 不为空时任务完成后计数减一
+     */
+    void Commit(Task task, TaskPriority priority = TaskPriority::NORMAL, TaskGroup* group = nullptr);
+    /**
+     * @brief      func(0 ... count - 1), 第 0 项在当前线程执行, 返回时全部完成
+     */
+    void ParallelFor(size_t count, const RangeTask& func, TaskPriority priority = TaskPriority::REALTIME);
+    /**
+     * @brief      在常驻线程槽上运行长时间的循环
+     * @param[in]  stop : 可以为空, Uninit 时任务仍未结束则调用, 应使 task 尽快返回 (如关闭 task 阻塞的队列)
+     * @return     用于等待任务结束
+     */
+    TaskGroup::ptr CommitLongRunning(const std::string& name, Task task, Task stop = nullptr);
+public:
+    std::vector<TaskPriorityStats> GetPriorityStats();
+    std::vector<TaskWorkerStats> GetWorkerStats();
+    void ResetStats();
+    /**
+     * @brief      输出各优先级的调度延迟、各工作线程的执行/窃取次数及队列深度, 同时以 PERF 行导出
+     */
+    void Report();
+private:
+    WorkStealingPool();
+    ~WorkStealingPool();
+private:
+    class TaskItem
+    {
+    public:
+        Task              task;
+        const RangeTask*  range;      // 不为空时执行 (*range)(index), 不使用 task
+        size_t            index;
+        TaskGroup*        group;
+        uint64_t          commitNs;
+    };
+    class Worker
+    {
+    public:
+        std::mutex                mtx;
+        std::deque<TaskItem>      queues[(size_t)TaskPriority::COUNT];
+        std::atomic<uint32_t>     sizes[(size_t)TaskPriority::COUNT];
+        std::thread               thread;
+        std::atomic<uint64_t>     executed;
+        std::atomic<uint64_t>     steals;
+        std::atomic<uint64_t>     queueHighWater;
+    };
+    class Slot
+    {
+    public:
+        std::string              name;
+        std::thread              thread;
+        std::mutex               mtx;
+        std::condition_variable  cond;
+        Task                     task;
+        Task                     stop;
+        TaskGroup::ptr           group;
+        bool                     busy;
+        bool                     exit;
+    };
+    class PriorityCounter
+    {
+    public:
+        std::atomic<uint64_t>  committed;
+        std::atomic<uint64_t>  executed;
+        std::atomic<uint64_t>  dispatchNsSum;
+        std::atomic<uint64_t>  dispatchNsMax;
+    };
+private:
+    void Push(TaskItem&& item, TaskPriority priority);
+    /**
+     * @param[in]  lowest : 只取不低于该优先级的任务
+     */
+    bool TryPop(int self, TaskPriority lowest, TaskItem& item, TaskPriority& priority);
+    void Execute(int self, TaskItem& item, TaskPriority priority);
+    /**
+     * @brief      归还后台任务名额, 仍有排队任务时唤醒一个空闲的工作线程
+     */
+    void ReleaseBackground();
+    void WakeOne();
+    bool RunOne();
+    void WorkerLoop(int self);
+    void SlotLoop(Slot* slot);
+private:
+    friend class TaskGroup;
+    std::mutex                          _mtx;
+    std::condition_variable             _cond;
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::vector<std::unique_ptr<Slot>>  _slots;
+    std::mutex                          _slotMtx;
+    std::atomic<bool>                   _running;
+    std::atomic<bool>                   _exit;
+    std::atomic<uint32_t>               _queued;
+    std::atomic<uint64_t>               _wakeups;   // 提交任务及归还后台名额的次数, 空闲线程据此判断是否需要重试
+    std::atomic<uint32_t>               _sleeping;
+    std::atomic<uint32_t>               _backgroundRunning;
+    std::atomic<uint32_t>               _nextWorker;
+    PriorityCounter                     _counters[(size_t)TaskPriority::COUNT];
+};
+
+} // namespace Mmp
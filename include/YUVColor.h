@@ -0,0 +1,44 @@
+//
+// YUVColor.h
+//
+// Library: Common
+// Package: PG
+// Module:  YUVColor
+//
+
+#pragma once
+
+#include <cstdint>
+
+namespace Mmp
+{
+
+enum class YUVColorSpace
+{
+    BT601,
+    BT709
+};
+
+enum class YUVColorRange
+{
+    LIMITED,  // Y : 16~235, UV : 16~240
+    FULL      // Y/UV : 0~255
+};
+
+/**
+ * @brief  RGB -> YUV 定点转换系数 (Q8)
+ * @note   y = (yCoeff . rgb + 128) >> 8 + yOffset, u/v 同理, 输入输出均为 0~255
+ */
+class RGBToYUVCoeff
+{
+public:
+    int32_t yCoeff[3];
+    int32_t uCoeff[3];
+    int32_t vCoeff[3];
+    int32_t yOffset;
+    int32_t uvOffset;
+};
+
+RGBToYUVCoeff GetRGBToYUVCoeff(YUVColorSpace space, YUVColorRange range);
+
+} // namespace Mmp
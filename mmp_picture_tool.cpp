@@ -0,0 +1,268 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+
+#include <Poco/Stopwatch.h>
+#include <Poco/Util/Application.h>
+#include <Poco/Util/HelpFormatter.h>
+
+#include "Common/AbstractLogger.h"
+#include "Common/LogMessage.h"
+#include "Common/ThreadPool.h"
+#include "Common/NormalPicture.h"
+#include "Codec/CodecConfig.h"
+
+#include "SampleUtils.h"
+#include "PictureFile.h"
+#include "NV12Converter.h"
+#include "PngA.h"
+#include "PngB.h"
+#include "WorkStealingPool.h"
+
+using namespace Mmp;
+using namespace Poco::Util;
+
+/**
+ * @sa Core/Extension/poco/Util/samples/SampleApp/src/SampleApp.cpp
+ */
+class App : public Application
+{
+public:
+    App();
+public:
+    void defineOptions(OptionSet& options) override;
+protected:
+    void initialize(Application& self);
+    void uninitialize();
+    void defineProperty(const std::string& def);
+    int main(const ArgVec& args);
+private:
+    void HandleHelp(const std::string& name, const std::string& value);
+    void HandleInput(const std::string& name, const std::string& value);
+    void HandleBuiltin(const std::string& name, const std::string& value);
+    void HandleOutput(const std::string& name, const std::string& value);
+    void HandleCompression(const std::string& name, const std::string& value);
+    void HandleFormat(const std::string& name, const std::string& value);
+    void displayHelp();
+public:
+    std::string         inputFile;
+    std::string         builtin;
+    std::string         outputFile;
+    PictureCompression  compression;
+    PixelFormat         format;
+};
+
+App::App()
+{
+    compression = PictureCompression::RAW;
+    format = PixelFormat::RGBA8888;
+}
+
+void App::displayHelp()
+{
+    AbstractLogger::LoggerSingleton()->Enable(AbstractLogger::Direction::CONSLOE);
+    std::stringstream ss;
+    HelpFormatter helpFormatter(options());
+    helpFormatter.setWidth(1024);
+    helpFormatter.setCommand(commandName());
+    helpFormatter.setUsage("OPTIONS");
+    helpFormatter.setHeader("Convert PNG (or the built-in A/B frames) to the pre-decoded .mpic format, or inspect an existing .mpic file.");
+    helpFormatter.format(ss);
+    MMP_LOG_INFO << ss.str();
+    exit(0);
+}
+
+void App::HandleHelp(const std::string& name, const std::string& value)
+{
+    displayHelp();
+}
+
+void App::HandleInput(const std::string& name, const std::string& value)
+{
+    inputFile = value;
+}
+
+void App::HandleBuiltin(const std::string& name, const std::string& value)
+{
+    builtin = value;
+}
+
+void App::HandleOutput(const std::string& name, const std::string& value)
+{
+    outputFile = value;
+}
+
+void App::HandleCompression(const std::string& name, const std::string& value)
+{
+    if (value == "lz4")
+    {
+        compression = PictureCompression::LZ4;
+    }
+}
+
+void App::HandleFormat(const std::string& name, const std::string& value)
+{
+    if (value == "NV12")
+    {
+        format = PixelFormat::NV12;
+    }
+}
+
+void App::initialize(Application& self)
+{
+    ThreadPool::ThreadPoolSingleton()->Init();
+    WorkStealingPool::Instance().Init();
+    Application::initialize(self);
+    Codec::CodecConfig::Instance()->Init();
+    AbstractLogger::LoggerSingleton()->Enable(AbstractLogger::Direction::CONSLOE);
+}
+
+void App::uninitialize()
+{
+    Codec::CodecConfig::Instance()->Uninit();
+    Application::uninitialize();
+    WorkStealingPool::Instance().Uninit();
+    ThreadPool::ThreadPoolSingleton()->Uninit();
+}
+
+void App::defineOptions(OptionSet& options)
+{
+    Application::defineOptions(options);
+
+    options.addOption(Option("help", "h", "")
+        .required(false)
+        .repeatable(false)
+        .callback(OptionCallback<App>(this, &App::HandleHelp))
+    );
+    options.addOption(Option("input", "i", "png file to convert, or .mpic file to inspect")
+        .required(false)
+        .repeatable(false)
+        .argument("[filepath]")
+        .callback(OptionCallback<App>(this, &App::HandleInput))
+    );
+    options.addOption(Option("builtin", "b", "A or B, convert the frame embedded in the samples")
+        .required(false)
+        .repeatable(false)
+        .argument("[name]")
+        .callback(OptionCallback<App>(this, &App::HandleBuiltin))
+    );
+    options.addOption(Option("output", "o", ".mpic file to write")
+        .required(false)
+        .repeatable(false)
+        .argument("[filepath]")
+        .callback(OptionCallback<App>(this, &App::HandleOutput))
+    );
+    options.addOption(Option("compression", "c", "default(raw), raw or lz4; raw is mapped without copy, lz4 is about half the size and decompressed in parallel")
+        .required(false)
+        .repeatable(false)
+        .argument("[compression]")
+        .callback(OptionCallback<App>(this, &App::HandleCompression))
+    );
+    options.addOption(Option("format", "f", "default(RGBA8888), RGBA8888 or NV12 (BT709 limited)")
+        .required(false)
+        .repeatable(false)
+        .argument("[format]")
+        .callback(OptionCallback<App>(this, &App::HandleFormat))
+    );
+}
+
+void App::defineProperty(const std::string& def)
+{
+    std::string name;
+    std::string value;
+    std::string::size_type pos = def.find('=');
+    if (pos != std::string::npos)
+    {
+        name.assign(def, 0, pos);
+        value.assign(def, pos + 1, def.length() - pos);
+    }
+    else name = def;
+    config().setString(name, value);
+}
+
+/********************************************************* TEST(BEGIN) *****************************************************/
+
+int App::main(const ArgVec& args)
+{
+    // Hint : 输入为 .mpic 时只加载并输出信息, 用于检查文件及测量加载耗时
+    if (inputFile.size() > 5 && inputFile.compare(inputFile.size() - 5, 5, ".mpic") == 0)
+    {
+        Poco::Stopwatch sw;
+        sw.start();
+        AbstractPicture::ptr picture = PictureFile::Load(inputFile);
+        sw.stop();
+        PixelsInfo info;
+        PictureCompression fileCompression;
+        if (!picture || !PictureFile::ReadInfo(inputFile, info, fileCompression))
+        {
+            return 255;
+        }
+        MMP_LOG_INFO << "Picture file info";
+        MMP_LOG_INFO << "-- size : " << info.width << "x" << info.height;
+        MMP_LOG_INFO << "-- format : " << info.format;
+        MMP_LOG_INFO << "-- compression : " << (fileCompression == PictureCompression::LZ4 ? "lz4" : "raw");
+        MMP_LOG_INFO << "-- bytes : " << picture->GetSize();
+        MMP_LOG_INFO << "-- load : " << sw.elapsed() << " us";
+        ReportPerfMetric("picture_load_us", (double)sw.elapsed());
+        return 0;
+    }
+
+    if (outputFile.empty())
+    {
+        MMP_LOG_ERROR << "Output file is required";
+        displayHelp();
+        return 255;
+    }
+    AbstractPicture::ptr picture;
+    if (builtin == "A")
+    {
+        picture = DecodePng(bin2c_A_png, sizeof(bin2c_A_png));
+    }
+    else if (builtin == "B")
+    {
+        picture = DecodePng(bin2c_B_png, sizeof(bin2c_B_png));
+    }
+    else if (!inputFile.empty())
+    {
+        std::vector<uint8_t> data;
+        std::ifstream ifs(inputFile, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!ifs.is_open())
+        {
+            MMP_LOG_ERROR << "Open input fail, path is: " << inputFile;
+            return 255;
+        }
+        data.resize((size_t)ifs.tellg());
+        ifs.seekg(0);
+        ifs.read((char*)data.data(), data.size());
+        picture = DecodePng(data.data(), data.size());
+    }
+    else
+    {
+        MMP_LOG_ERROR << "Either input or builtin is required";
+        displayHelp();
+        return 255;
+    }
+    if (!picture)
+    {
+        MMP_LOG_ERROR << "Decode png fail";
+        return 255;
+    }
+    if (format == PixelFormat::NV12)
+    {
+        if (picture->info.width % 2 || picture->info.height % 2)
+        {
+            MMP_LOG_ERROR << "NV12 needs even width and height";
+            return 255;
+        }
+        PixelsInfo info(picture->info.width, picture->info.height, 8, PixelFormat::NV12);
+        AbstractPicture::ptr nv12 = std::make_shared<NormalPicture>(info);
+        ConvertRGBAToNV12((const uint8_t*)picture->GetData(), info.width, info.height, (uint8_t*)nv12->GetData(), GetRGBToYUVCoeff(YUVColorSpace::BT709, YUVColorRange::LIMITED));
+        picture = nv12;
+    }
+    return PictureFile::Save(outputFile, picture, compression) ? 0 : 255;
+}
+
+/********************************************************* TEST(END) *****************************************************/
+
+POCO_APP_MAIN(App)
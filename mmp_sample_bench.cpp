@@ -0,0 +1,925 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <random>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+
+#include <Poco/Timestamp.h>
+#include <Poco/DateTime.h>
+#include <Poco/DateTimeFormat.h>
+#include <Poco/DateTimeFormatter.h>
+#include <Poco/TemporaryFile.h>
+#include <Poco/Util/Application.h>
+#include <Poco/Util/HelpFormatter.h>
+
+#include "Common/Promise.h"
+#include "Common/AbstractLogger.h"
+#include "Common/LogMessage.h"
+#include "Common/ThreadPool.h"
+#include "Common/NormalPicture.h"
+#include "GPU/GL/GLCommon.h"
+#include "GPU/GL/GLDrawContex.h"
+#include "GPU/PG/Utility/CommonUtility.h"
+#include "Codec/CodecConfig.h"
+
+#include "SampleUtils.h"
+#include "RenderThread.h"
+#include "BenchHarness.h"
+#include "FrameScaler.h"
+#include "PictureFile.h"
+#include "PngA.h"
+#include "AbstractDisplay.h"
+#include "H26XFileByteReader.h"
+#include "Mp4Demuxer.h"
+#include "IvfDemuxer.h"
+#include "WorkStealingPool.h"
+
+#ifndef MMP_CORE_REVISION
+#define MMP_CORE_REVISION "unknown"
+#endif
+
+using namespace Mmp;
+using namespace Poco::Util;
+
+/**
+ * @sa Core/Extension/poco/Util/samples/SampleApp/src/SampleApp.cpp
+ */
+class App : public Application
+{
+public:
+    App();
+public:
+    void defineOptions(OptionSet& options) override;
+protected:
+    void Initialize();
+    void Uninitialize();
+    void defineProperty(const std::string& def);
+    int main(const ArgVec& args);
+private:
+    void HandleHelp(const std::string& name, const std::string& value);
+    void HandleBackend(const std::string& name, const std::string& value);
+    void HandleFilter(const std::string& name, const std::string& value);
+    void HandleMinTime(const std::string& name, const std::string& value);
+    void HandleRepetitions(const std::string& name, const std::string& value);
+    void HandleOutput(const std::string& name, const std::string& value);
+    void HandleList(const std::string& name, const std::string& value);
+    void displayHelp();
+    void RegisterBenches();
+public:
+    GPUBackend   backend;
+    std::string  filter;
+    uint32_t     minTimeMs;
+    uint32_t     repetitions;
+    std::string  outputFile;
+    bool         listOnly;
+private:
+    RenderThread::ptr    _renderThread;
+    Poco::TemporaryFile  _annexbFile;
+    Poco::TemporaryFile  _mp4File[2];
+    Poco::TemporaryFile  _ivfFile;
+};
+
+App::App()
+{
+    backend = GPUBackend::OPENGL;
+    minTimeMs = 500;
+    repetitions = 3;
+    listOnly = false;
+    outputFile = "mmp_sample_bench.json";
+}
+
+void App::displayHelp()
+{
+    AbstractLogger::LoggerSingleton()->Enable(AbstractLogger::Direction::CONSLOE);
+    std::stringstream ss;
+    HelpFormatter helpFormatter(options());
+    helpFormatter.setWidth(1024);
+    helpFormatter.setCommand(commandName());
+    helpFormatter.setUsage("OPTIONS");
+    helpFormatter.setHeader("Microbenchmarks for the sample-side hot paths, results are written as JSON.");
+    helpFormatter.format(ss);
+    MMP_LOG_INFO << ss.str();
+    exit(0);
+}
+
+void App::HandleHelp(const std::string& name, const std::string& value)
+{
+    displayHelp();
+}
+
+void App::HandleBackend(const std::string& name, const std::string& value)
+{
+    backend = GetGPUBackend(value);
+}
+
+void App::HandleFilter(const std::string& name, const std::string& value)
+{
+    filter = value;
+}
+
+void App::HandleMinTime(const std::string& name, const std::string& value)
+{
+    minTimeMs = std::max(std::stoi(value), 1);
+}
+
+void App::HandleRepetitions(const std::string& name, const std::string& value)
+{
+    repetitions = std::max(std::stoi(value), 1);
+}
+
+void App::HandleOutput(const std::string& name, const std::string& value)
+{
+    outputFile = value;
+}
+
+void App::HandleList(const std::string& name, const std::string& value)
+{
+    listOnly = true;
+}
+
+void App::Initialize()
+{
+    ThreadPool::ThreadPoolSingleton()->Init();
+    WorkStealingPool::Instance().Init();
+    Codec::CodecConfig::Instance()->Init();
+    _renderThread = std::make_shared<RenderThread>(backend);
+    _renderThread->Start();
+}
+
+void App::Uninitialize()
+{
+    Application::uninitialize();
+    _renderThread->Stop();
+    Codec::CodecConfig::Instance()->Uninit();
+    WorkStealingPool::Instance().Uninit();
+    ThreadPool::ThreadPoolSingleton()->Uninit();
+}
+
+void App::defineOptions(OptionSet& options)
+{
+    Application::defineOptions(options);
+
+    options.addOption(Option("help", "h", "")
+        .required(false)
+        .repeatable(false)
+        .callback(OptionCallback<App>(this, &App::HandleHelp))
+    );
+    options.addOption(Option("backend", "b", "default(OPENGL), gpu backend for texture benchmarks")
+        .required(false)
+        .repeatable(false)
+        .argument("[type]")
+        .callback(OptionCallback<App>(this, &App::HandleBackend))
+    );
+    options.addOption(Option("filter", "f", "run benchmarks whose name contains [str]")
+        .required(false)
+        .repeatable(false)
+        .argument("[str]")
+        .callback(OptionCallback<App>(this, &App::HandleFilter))
+    );
+    options.addOption(Option("min_time", "mt", "default(500), minimum measured time per repetition in ms")
+        .required(false)
+        .repeatable(false)
+        .argument("[ms]")
+        .callback(OptionCallback<App>(this, &App::HandleMinTime))
+    );
+    options.addOption(Option("repetitions", "r", "default(3), repetitions per benchmark, median is reported")
+        .required(false)
+        .repeatable(false)
+        .argument("[num]")
+        .callback(OptionCallback<App>(this, &App::HandleRepetitions))
+    );
+    options.addOption(Option("output", "o", "default(mmp_sample_bench.json), json output file")
+        .required(false)
+        .repeatable(false)
+        .argument("[filepath]")
+        .callback(OptionCallback<App>(this, &App::HandleOutput))
+    );
+    options.addOption(Option("list", "l", "list benchmark names")
+        .required(false)
+        .repeatable(false)
+        .callback(OptionCallback<App>(this, &App::HandleList))
+    );
+}
+
+void App::defineProperty(const std::string& def)
+{
+    std::string name;
+    std::string value;
+    std::string::size_type pos = def.find('=');
+    if (pos != std::string::npos)
+    {
+        name.assign(def, 0, pos);
+        value.assign(def, pos + 1, def.length() - pos);
+    }
+    else name = def;
+    config().setString(name, value);
+}
+
+/**
+ * @brief 生成 Annex-B 码流, NAL 长度及负载随机, 负载中不包含起始码
+ */
+static uint64_t WriteSyntheticAnnexB(const std::string& path, uint64_t bytes)
+{
+    std::mt19937 rng(2024);
+    std::vector<uint8_t> data;
+    data.reserve((size_t)bytes + 64 * 1024);
+    uint64_t nals = 0;
+    while (data.size() < bytes)
+    {
+        const uint8_t startCode[] = {0x00, 0x00, 0x00, 0x01, 0x41, 0x88};
+        data.insert(data.end(), startCode, startCode + sizeof(startCode));
+        size_t payload = 512 + rng() % (32 * 1024);
+        for (size_t i = 0; i < payload; i++)
+        {
+            data.push_back((uint8_t)(rng() % 255 + 1));
+        }
+        nals++;
+    }
+    std::ofstream ofs(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    ofs.write((const char*)data.data(), data.size());
+    return nals;
+}
+
+static void PutBE16(std::vector<uint8_t>& data, uint16_t value)
+{
+    data.push_back((uint8_t)(value >> 8));
+    data.push_back((uint8_t)value);
+}
+
+static void PutBE32(std::vector<uint8_t>& data, uint32_t value)
+{
+    PutBE16(data, (uint16_t)(value >> 16));
+    PutBE16(data, (uint16_t)value);
+}
+
+static void PutLE32(std::vector<uint8_t>& data, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        data.push_back((uint8_t)(value >> (i * 8)));
+    }
+}
+
+/**
+ * @brief 写入盒子头, 大小在 EndBox 时回填
+ */
+static size_t BeginBox(std::vector<uint8_t>& data, const char* type)
+{
+    size_t pos = data.size();
+    PutBE32(data, 0);
+    data.insert(data.end(), type, type + 4);
+    return pos;
+}
+
+static void EndBox(std::vector<uint8_t>& data, size_t pos)
+{
+    uint32_t size = (uint32_t)(data.size() - pos);
+    data[pos] = (uint8_t)(size >> 24);
+    data[pos + 1] = (uint8_t)(size >> 16);
+    data[pos + 2] = (uint8_t)(size >> 8);
+    data[pos + 3] = (uint8_t)size;
+}
+
+/**
+ * @brief 生成只含一条 H.264 轨道的 MP4, 每个 sample 含 1 ~ 3 个长度前缀的 NAL, 每 30 个 sample 一个关键帧
+ * @return sample 数
+ */
+static uint64_t WriteSyntheticMp4(const std::string& path, uint64_t bytes, uint32_t lengthSize)
+{
+    std::mt19937 rng(2024);
+    std::vector<uint8_t> data;
+    data.reserve((size_t)bytes + 256 * 1024);
+    size_t ftyp = BeginBox(data, "ftyp");
+    data.insert(data.end(), {'i', 's', 'o', 'm', 0, 0, 2, 0, 'i', 's', 'o', 'm', 'a', 'v', 'c', '1'});
+    EndBox(data, ftyp);
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> sizes;
+    size_t mdat = BeginBox(data, "mdat");
+    while (data.size() < bytes)
+    {
+        size_t begin = data.size();
+        size_t nals = 1 + rng() % 3;
+        for (size_t i = 0; i < nals; i++)
+        {
+            // Hint : 长度字段为 1/2 字节时 NAL 大小受限
+            uint32_t payload = lengthSize >= 3 ? 512 + rng() % (16 * 1024) : 16 + rng() % 200;
+            uint32_t nalSize = payload + 1;
+            for (uint32_t j = lengthSize; j > 0; j--)
+            {
+                data.push_back((uint8_t)(nalSize >> ((j - 1) * 8)));
+            }
+            data.push_back(offsets.size() % 30 == 0 && i == 0 ? 0x65 : 0x41);
+            for (uint32_t j = 0; j < payload; j++)
+            {
+                data.push_back((uint8_t)(rng() % 255 + 1));
+            }
+        }
+        offsets.push_back((uint32_t)begin);
+        sizes.push_back((uint32_t)(data.size() - begin));
+    }
+    EndBox(data, mdat);
+    const uint8_t sps[] = {0x67, 0x64, 0x00, 0x28, 0xAC, 0xD9, 0x40, 0x78, 0x02, 0x27, 0xE5, 0x84};
+    const uint8_t pps[] = {0x68, 0xEB, 0xE3, 0xCB, 0x22, 0xC0};
+    size_t moov = BeginBox(data, "moov");
+    size_t trak = BeginBox(data, "trak");
+    size_t mdia = BeginBox(data, "mdia");
+    size_t hdlr = BeginBox(data, "hdlr");
+    PutBE32(data, 0);
+    PutBE32(data, 0);
+    data.insert(data.end(), {'v', 'i', 'd', 'e'});
+    data.insert(data.end(), 13, 0);
+    EndBox(data, hdlr);
+    size_t minf = BeginBox(data, "minf");
+    size_t stbl = BeginBox(data, "stbl");
+    size_t stsd = BeginBox(data, "stsd");
+    PutBE32(data, 0);
+    PutBE32(data, 1);
+    size_t avc1 = BeginBox(data, "avc1");
+    data.insert(data.end(), 6, 0);
+    PutBE16(data, 1);
+    data.insert(data.end(), 16, 0);
+    PutBE16(data, 1920);
+    PutBE16(data, 1080);
+    PutBE32(data, 0x00480000);
+    PutBE32(data, 0x00480000);
+    PutBE32(data, 0);
+    PutBE16(data, 1);
+    data.insert(data.end(), 32, 0);
+    PutBE16(data, 0x0018);
+    PutBE16(data, 0xFFFF);
+    size_t avcC = BeginBox(data, "avcC");
+    data.insert(data.end(), {0x01, 0x64, 0x00, 0x28, (uint8_t)(0xFC | (lengthSize - 1)), 0xE1});
+    PutBE16(data, sizeof(sps));
+    data.insert(data.end(), sps, sps + sizeof(sps));
+    data.push_back(1);
+    PutBE16(data, sizeof(pps));
+    data.insert(data.end(), pps, pps + sizeof(pps));
+    EndBox(data, avcC);
+    EndBox(data, avc1);
+    EndBox(data, stsd);
+    size_t stsz = BeginBox(data, "stsz");
+    PutBE32(data, 0);
+    PutBE32(data, 0);
+    PutBE32(data, (uint32_t)sizes.size());
+    for (uint32_t size : sizes)
+    {
+        PutBE32(data, size);
+    }
+    EndBox(data, stsz);
+    size_t stsc = BeginBox(data, "stsc");
+    PutBE32(data, 0);
+    PutBE32(data, 1);
+    PutBE32(data, 1);
+    PutBE32(data, 1);
+    PutBE32(data, 1);
+    EndBox(data, stsc);
+    size_t stco = BeginBox(data, "stco");
+    PutBE32(data, 0);
+    PutBE32(data, (uint32_t)offsets.size());
+    for (uint32_t offset : offsets)
+    {
+        PutBE32(data, offset);
+    }
+    EndBox(data, stco);
+    size_t stss = BeginBox(data, "stss");
+    PutBE32(data, 0);
+    PutBE32(data, (uint32_t)((offsets.size() + 29) / 30));
+    for (uint32_t i = 0; i < offsets.size(); i += 30)
+    {
+        PutBE32(data, i + 1);
+    }
+    EndBox(data, stss);
+    EndBox(data, stbl);
+    EndBox(data, minf);
+    EndBox(data, mdia);
+    EndBox(data, trak);
+    EndBox(data, moov);
+    std::ofstream ofs(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    ofs.write((const char*)data.data(), data.size());
+    return sizes.size();
+}
+
+/**
+ * @brief 生成 VP9 IVF, 帧数据随机, 只有首字节为合法的未压缩头, 每 30 帧一个关键帧
+ * @return 帧数
+ */
+static uint64_t WriteSyntheticIvf(const std::string& path, uint64_t bytes)
+{
+    std::mt19937 rng(2024);
+    std::vector<uint8_t> data;
+    data.reserve((size_t)bytes + 64 * 1024);
+    data.insert(data.end(), {'D', 'K', 'I', 'F', 0, 0, 32, 0, 'V', 'P', '9', '0', 0x80, 0x07, 0x38, 0x04});
+    PutLE32(data, 30);
+    PutLE32(data, 1);
+    size_t frameCountPos = data.size();
+    PutLE32(data, 0);
+    PutLE32(data, 0);
+    uint32_t frames = 0;
+    while (data.size() < bytes)
+    {
+        uint32_t size = 512 + rng() % (32 * 1024);
+        PutLE32(data, size);
+        PutLE32(data, frames);
+        PutLE32(data, 0);
+        // Hint : frame_marker 10, profile 0, show_existing_frame 0, frame_type (0 为关键帧), show_frame 1
+        data.push_back(frames % 30 == 0 ? 0x82 : 0x86);
+        for (uint32_t i = 1; i < size; i++)
+        {
+            data.push_back((uint8_t)rng());
+        }
+        frames++;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        data[frameCountPos + i] = (uint8_t)(frames >> (i * 8));
+    }
+    std::ofstream ofs(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    ofs.write((const char*)data.data(), data.size());
+    return frames;
+}
+
+/**
+ * @brief 忙等 us 微秒, 模拟占用工作线程的计算任务
+ */
+static void SpinFor(int64_t us)
+{
+    Poco::Timestamp stamp;
+    while (stamp.elapsed() < us)
+    {
+    }
+}
+
+/**
+ * @brief 在后台持续保持 inflight 个忙等任务, 用于测量竞争下的调度延迟
+ */
+class ContentionLoad
+{
+public:
+    ContentionLoad(std::function<void(size_t inflight)> round, size_t inflight)
+    {
+        _stop = false;
+        _thread = std::thread([this, round, inflight]()
+        {
+            while (!_stop)
+            {
+                round(inflight);
+            }
+        });
+    }
+    ~ContentionLoad()
+    {
+        _stop = true;
+        _thread.join();
+    }
+private:
+    std::atomic<bool>  _stop;
+    std::thread        _thread;
+};
+
+void App::RegisterBenches()
+{
+    BenchRegistry& registry = BenchRegistry::Instance();
+
+    // H26XFileByteReader::GetNalUint
+    {
+        std::string path = _annexbFile.path();
+        uint64_t fileSize = 16 * 1024 * 1024;
+        uint64_t nals = WriteSyntheticAnnexB(path, fileSize);
+        registry.Register("H26XFileByteReader/GetNalUint/16MiB", [path, fileSize, nals](BenchState& state)
+        {
+            while (state.KeepRunning())
+            {
+                H26XFileByteReader reader(path);
+                while (reader.GetNalUint())
+                {
+                }
+            }
+            state.SetBytesProcessed(fileSize * state.iterations);
+            state.SetItemsProcessed(nals * state.iterations);
+        });
+    }
+
+    // Mp4Demuxer / IvfDemuxer, 每次迭代重新打开 (映射), 包含长度前缀改写引起的写时复制
+    {
+        const std::vector<std::pair<std::string, uint32_t>> lengthSizes =
+        {
+            {"4B", 4},   // 原地改写为起始码
+            {"2B", 2}    // 拷贝为 Annex-B
+        };
+        uint64_t fileSize = 16 * 1024 * 1024;
+        for (size_t i = 0; i < lengthSizes.size(); i++)
+        {
+            std::string path = _mp4File[i].path();
+            uint64_t samples = WriteSyntheticMp4(path, fileSize, lengthSizes[i].second);
+            registry.Register("Demux/Mp4/AVC/" + lengthSizes[i].first + "/16MiB", [path, fileSize, samples](BenchState& state)
+            {
+                uint64_t copied = 0;
+                while (state.KeepRunning())
+                {
+                    Mp4Demuxer demuxer;
+                    if (!demuxer.Open(path))
+                    {
+                        state.SkipWithError("open mp4 fail");
+                        return;
+                    }
+                    while (demuxer.GetPacket())
+                    {
+                    }
+                    copied = demuxer.GetCopiedSamples();
+                }
+                state.SetBytesProcessed(fileSize * state.iterations);
+                state.SetItemsProcessed(samples * state.iterations);
+                state.SetCounter("copied_samples", (double)copied);
+            });
+        }
+        std::string path = _ivfFile.path();
+        uint64_t frames = WriteSyntheticIvf(path, fileSize);
+        registry.Register("Demux/Ivf/VP9/16MiB", [path, fileSize, frames](BenchState& state)
+        {
+            while (state.KeepRunning())
+            {
+                IvfDemuxer demuxer;
+                if (!demuxer.Open(path))
+                {
+                    state.SkipWithError("open ivf fail");
+                    return;
+                }
+                while (demuxer.GetPacket())
+                {
+                }
+            }
+            state.SetBytesProcessed(fileSize * state.iterations);
+            state.SetItemsProcessed(frames * state.iterations);
+        });
+    }
+
+    // DisplaySDL::UpdateWindow
+    {
+        const std::vector<std::pair<std::string, PixelFormat>> formats =
+        {
+            {"RGBA8888", PixelFormat::RGBA8888},
+            {"BGRA8888", PixelFormat::BGRA8888},
+            {"NV12",     PixelFormat::NV12},
+            {"YUV420P",  PixelFormat::YUV420P}
+        };
+        for (const auto& format : formats)
+        {
+            PixelFormat pixelFormat = format.second;
+            registry.Register("DisplaySDL/UpdateWindow/" + format.first + "/1920x1080", [pixelFormat](BenchState& state)
+            {
+                PixelsInfo info(1920, 1080, 8, pixelFormat);
+                AbstractDisplay::ptr display = AbstractDisplay::Create("DisplaySDL");
+                if (!display || !display->Init())
+                {
+                    state.SkipWithError("display unavailable");
+                    return;
+                }
+                display->Open(info);
+                AbstractPicture::ptr picture = std::make_shared<NormalPicture>(info);
+                memset(picture->GetData(), 0x80, picture->GetSize());
+                while (state.KeepRunning())
+                {
+                    display->UpdateWindow((const uint32_t*)picture->GetData(), info);
+                }
+                state.SetBytesProcessed(picture->GetSize() * state.iterations);
+                display->Close();
+                display->UnInit();
+            });
+            // Hint : 与 UpdateWindow 对比, 差值即省去的整帧拷贝
+            registry.Register("DisplaySDL/AcquirePresent/" + format.first + "/1920x1080", [pixelFormat](BenchState& state)
+            {
+                PixelsInfo info(1920, 1080, 8, pixelFormat);
+                AbstractDisplay::ptr display = AbstractDisplay::Create("DisplaySDL");
+                if (!display || !display->Init())
+                {
+                    state.SkipWithError("display unavailable");
+                    return;
+                }
+                display->Open(info);
+                DisplayBuffer buffer;
+                while (state.KeepRunning())
+                {
+                    if (!display->AcquireBuffer(buffer))
+                    {
+                        state.SkipWithError("AcquireBuffer unsupported");
+                        break;
+                    }
+                    display->Present();
+                }
+                display->Close();
+                display->UnInit();
+            });
+        }
+    }
+
+    // FrameScaler 4K -> 1080p (DisplaySDL fit to display)
+    {
+        const std::vector<std::pair<std::string, PixelFormat>> formats =
+        {
+            {"RGBA8888", PixelFormat::RGBA8888},
+            {"NV12",     PixelFormat::NV12}
+        };
+        const std::vector<std::pair<std::string, ScaleFilter>> filters =
+        {
+            {"Area",     ScaleFilter::AREA},
+            {"Bilinear", ScaleFilter::BILINEAR}
+        };
+        for (const auto& format : formats)
+        {
+            for (const auto& filter : filters)
+            {
+                PixelFormat pixelFormat = format.second;
+                ScaleFilter scaleFilter = filter.second;
+                registry.Register("FrameScaler/" + filter.first + "/" + format.first + "/3840x2160->1920x1080", [pixelFormat, scaleFilter](BenchState& state)
+                {
+                    PixelsInfo srcInfo(3840, 2160, 8, pixelFormat);
+                    PixelsInfo dstInfo(1920, 1080, 8, pixelFormat);
+                    FrameScaler::ptr scaler = std::make_shared<FrameScaler>(srcInfo, dstInfo, scaleFilter);
+                    if (!scaler->IsValid())
+                    {
+                        state.SkipWithError("frame scaler unsupported");
+                        return;
+                    }
+                    AbstractPicture::ptr src = std::make_shared<NormalPicture>(srcInfo);
+                    AbstractPicture::ptr dst = std::make_shared<NormalPicture>(dstInfo);
+                    memset(src->GetData(), 0x80, src->GetSize());
+                    while (state.KeepRunning())
+                    {
+                        scaler->Scale(src, dst);
+                    }
+                    state.SetBytesProcessed(src->GetSize() * state.iterations);
+                });
+            }
+        }
+    }
+
+    // SampleUtils built-in frames, PictureFile
+    // Hint : GetFrame1920x1080A/B 在资源存在时为 mmap 加载, DecodePng 始终为 PNG 解码, 两者对比即启动时省去的耗时
+    {
+        registry.Register("SampleUtils/DecodePng/1920x1080A", [](BenchState& state)
+        {
+            while (state.KeepRunning())
+            {
+                AbstractPicture::ptr picture = DecodePng(bin2c_A_png, sizeof(bin2c_A_png));
+            }
+            state.SetItemsProcessed(state.iterations);
+        });
+        const std::vector<std::pair<std::string, PictureCompression>> compressions =
+        {
+            {"Raw", PictureCompression::RAW},
+            {"LZ4", PictureCompression::LZ4}
+        };
+        for (const auto& compression : compressions)
+        {
+            PictureCompression pictureCompression = compression.second;
+            registry.Register("PictureFile/Load/" + compression.first + "/1920x1080A", [pictureCompression](BenchState& state)
+            {
+                Poco::TemporaryFile file;
+                if (!PictureFile::Save(file.path(), DecodePng(bin2c_A_png, sizeof(bin2c_A_png)), pictureCompression))
+                {
+                    state.SkipWithError("save picture fail");
+                    return;
+                }
+                volatile uint8_t sink = 0;
+                while (state.KeepRunning())
+                {
+                    AbstractPicture::ptr picture = PictureFile::Load(file.path());
+                    // Hint : 逐页读一次, 把 mmap 推迟的缺页开销也计算在内
+                    const uint8_t* data = (const uint8_t*)picture->GetData();
+                    for (size_t offset = 0; offset < picture->GetSize(); offset += 4096)
+                    {
+                        sink = data[offset];
+                    }
+                }
+                state.SetItemsProcessed(state.iterations);
+                (void)sink;
+            });
+        }
+        registry.Register("SampleUtils/GetFrame1920x1080A", [](BenchState& state)
+        {
+            while (state.KeepRunning())
+            {
+                AbstractPicture::ptr picture = GetFrame1920x1080A();
+            }
+            state.SetItemsProcessed(state.iterations);
+        });
+        registry.Register("SampleUtils/GetFrame1920x1080B", [](BenchState& state)
+        {
+            while (state.KeepRunning())
+            {
+                AbstractPicture::ptr picture = GetFrame1920x1080B();
+            }
+            state.SetItemsProcessed(state.iterations);
+        });
+    }
+
+    // Gpu::Update2DTextures / Gpu::Copy2DTexturesToMemory
+    {
+        const std::vector<std::pair<uint32_t, uint32_t>> resolutions = {{640, 360}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+        for (const auto& resolution : resolutions)
+        {
+            PixelsInfo info((int32_t)resolution.first, (int32_t)resolution.second, 8, PixelFormat::RGBA8888);
+            std::string suffix = std::to_string(resolution.first) + "x" + std::to_string(resolution.second);
+            RenderThread::ptr renderThread = _renderThread;
+            registry.Register("Gpu/Update2DTextures/" + suffix, [info, renderThread](BenchState& state)
+            {
+                AbstractPicture::ptr picture = std::make_shared<NormalPicture>(info);
+                memset(picture->GetData(), 0x40, picture->GetSize());
+                Texture::ptr texture = Gpu::Create2DTextures(GLDrawContex::Instance(), info)[0];
+                while (state.KeepRunning())
+                {
+                    RenderThread::SyncScope sync(*renderThread);
+                    Gpu::Update2DTextures(GLDrawContex::Instance(), std::vector<Texture::ptr>({texture}), picture);
+                }
+                state.SetBytesProcessed(picture->GetSize() * state.iterations);
+            });
+            registry.Register("Gpu/Copy2DTexturesToMemory/" + suffix, [info, renderThread](BenchState& state)
+            {
+                AbstractPicture::ptr picture = std::make_shared<NormalPicture>(info);
+                Texture::ptr texture = Gpu::Create2DTextures(GLDrawContex::Instance(), info, "Framebuffer", GlTextureFlags::TEXTURE_USE_FOR_RENDER)[0];
+                while (state.KeepRunning())
+                {
+                    RenderThread::SyncScope sync(*renderThread);
+                    Gpu::Copy2DTexturesToMemory(GLDrawContex::Instance(), std::vector<Texture::ptr>({texture}), picture);
+                }
+                state.SetBytesProcessed(picture->GetSize() * state.iterations);
+            });
+        }
+    }
+
+    // ThreadPool Promise commit
+    {
+        registry.Register("ThreadPool/CommitWait", [](BenchState& state)
+        {
+            uint64_t dispatchUs = 0;
+            while (state.KeepRunning())
+            {
+                Poco::Timestamp commit;
+                std::atomic<int64_t> startUs(0);
+                Promise<void>::ptr task = std::make_shared<Promise<void>>([&]()
+                {
+                    startUs = commit.elapsed();
+                });
+                ThreadPool::ThreadPoolSingleton()->Commit(task);
+                task->Wait();
+                dispatchUs += (uint64_t)startUs.load();
+            }
+            state.SetItemsProcessed(state.iterations);
+            state.SetCounter("dispatch_latency_ns", state.iterations ? dispatchUs * 1000.0 / state.iterations : 0);
+        });
+        // Hint : 所有工作线程被 200 us 的计算任务占满时, 新提交的任务要等到其中一个结束
+        registry.Register("ThreadPool/CommitWait/Contended", [](BenchState& state)
+        {
+            ContentionLoad load([](size_t inflight)
+            {
+                std::vector<Promise<void>::ptr> tasks;
+                for (size_t i = 0; i < inflight; i++)
+                {
+                    Promise<void>::ptr task = std::make_shared<Promise<void>>([]()
+                    {
+                        SpinFor(200);
+                    });
+                    ThreadPool::ThreadPoolSingleton()->Commit(task);
+                    tasks.push_back(task);
+                }
+                for (auto& task : tasks)
+                {
+                    task->Wait();
+                }
+            }, std::max(std::thread::hardware_concurrency(), 1u) * 2);
+            uint64_t dispatchUs = 0;
+            while (state.KeepRunning())
+            {
+                Poco::Timestamp commit;
+                std::atomic<int64_t> startUs(0);
+                Promise<void>::ptr task = std::make_shared<Promise<void>>([&]()
+                {
+                    startUs = commit.elapsed();
+                });
+                ThreadPool::ThreadPoolSingleton()->Commit(task);
+                task->Wait();
+                dispatchUs += (uint64_t)startUs.load();
+            }
+            state.SetItemsProcessed(state.iterations);
+            state.SetCounter("dispatch_latency_ns", state.iterations ? dispatchUs * 1000.0 / state.iterations : 0);
+        });
+    }
+
+    // WorkStealingPool dispatch
+    {
+        const std::vector<std::pair<std::string, TaskPriority>> priorities =
+        {
+            {"Realtime", TaskPriority::REALTIME},
+            {"Normal", TaskPriority::NORMAL},
+        };
+        for (const auto& priority : priorities)
+        {
+            for (bool contended : {false, true})
+            {
+                TaskPriority taskPriority = priority.second;
+                registry.Register("WorkStealingPool/CommitWait/" + priority.first + (contended ? "/Contended" : "/Idle"), [taskPriority, contended](BenchState& state)
+                {
+                    WorkStealingPool& pool = WorkStealingPool::Instance();
+                    if (!pool.IsRunning())
+                    {
+                        state.SkipWithError("WorkStealingPool is not running");
+                        return;
+                    }
+                    // Hint : 竞争负载以 BACKGROUND 提交, 与 ThreadPool/CommitWait/Contended 的负载相同
+                    std::unique_ptr<ContentionLoad> load;
+                    if (contended)
+                    {
+                        load.reset(new ContentionLoad([&pool](size_t inflight)
+                        {
+                            TaskGroup group;
+                            for (size_t i = 0; i < inflight; i++)
+                            {
+                                pool.Commit([]()
+                                {
+                                    SpinFor(200);
+                                }, TaskPriority::BACKGROUND, &group);
+                            }
+                            group.Wait();
+                        }, std::max(std::thread::hardware_concurrency(), 1u) * 2));
+                    }
+                    pool.ResetStats();
+                    uint64_t dispatchUs = 0;
+                    while (state.KeepRunning())
+                    {
+                        Poco::Timestamp commit;
+                        std::atomic<int64_t> startUs(0);
+                        TaskGroup group;
+                        pool.Commit([&]()
+                        {
+                            startUs = commit.elapsed();
+                        }, taskPriority, &group);
+                        group.Wait();
+                        dispatchUs += (uint64_t)startUs.load();
+                    }
+                    load.reset();
+                    uint64_t steals = 0;
+                    for (const TaskWorkerStats& stats : pool.GetWorkerStats())
+                    {
+                        steals += stats.steals;
+                    }
+                    std::vector<TaskPriorityStats> stats = pool.GetPriorityStats();
+                    state.SetItemsProcessed(state.iterations);
+                    state.SetCounter("dispatch_latency_ns", state.iterations ? dispatchUs * 1000.0 / state.iterations : 0);
+                    state.SetCounter("dispatch_max_ns", (double)stats[(size_t)taskPriority].dispatchNsMax);
+                    state.SetCounter("steals", (double)steals);
+                });
+            }
+        }
+        registry.Register("WorkStealingPool/ParallelFor/16", [](BenchState& state)
+        {
+            std::atomic<uint64_t> sum(0);
+            while (state.KeepRunning())
+            {
+                WorkStealingPool::Instance().ParallelFor(16, [&sum](size_t index)
+                {
+                    sum += index;
+                });
+            }
+            state.SetItemsProcessed(state.iterations * 16);
+        });
+    }
+}
+
+/********************************************************* TEST(BEGIN) *****************************************************/
+
+int App::main(const ArgVec& args)
+{
+    AbstractLogger::LoggerSingleton()->Enable(AbstractLogger::Direction::CONSLOE);
+    Initialize();
+    RegisterBenches();
+    if (listOnly)
+    {
+        for (const auto& name : BenchRegistry::Instance().GetNames())
+        {
+            std::cout << name << std::endl;
+        }
+        Uninitialize();
+        return 0;
+    }
+    std::map<std::string, std::string> context;
+    context["date"] = Poco::DateTimeFormatter::format(Poco::DateTime(), Poco::DateTimeFormat::ISO8601_FORMAT);
+    context["mmp_core_revision"] = MMP_CORE_REVISION;
+    context["backend"] = GPUBackendToStr(backend);
+    context["hardware_concurrency"] = std::to_string(std::thread::hardware_concurrency());
+    context["min_time_ms"] = std::to_string(minTimeMs);
+    // Hint : 日志输出至控制台, 结果单独写入文件, 避免两者混杂
+    std::ofstream ofs(outputFile, std::ios::out | std::ios::trunc);
+    BenchRegistry::Instance().Run(filter, minTimeMs, repetitions, context, ofs);
+    MMP_LOG_INFO << "Bench result : " << outputFile;
+    Uninitialize();
+    return 0;
+}
+
+/********************************************************* TEST(END) *****************************************************/
+
+POCO_APP_MAIN(App)
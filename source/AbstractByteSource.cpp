@@ -0,0 +1,30 @@
+#include "AbstractByteSource.h"
+
+#include "Common/LogMessage.h"
+
+#include "FileByteSource.h"
+#include "StreamByteSource.h"
+
+namespace Mmp
+{
+
+AbstractByteSource::ptr AbstractByteSource::Create(const std::string& url)
+{
+    AbstractByteSource::ptr source;
+    if (url == "-" || url == "stdin" || url.rfind("pipe://", 0) == 0 || url.rfind("udp://", 0) == 0 || url.rfind("unix://", 0) == 0)
+    {
+        source = std::make_shared<StreamByteSource>();
+    }
+    else
+    {
+        source = std::make_shared<FileByteSource>();
+    }
+    if (!source->Open(url))
+    {
+        MMP_LOG_ERROR << "Open byte source fail, url is: " << url;
+        return nullptr;
+    }
+    return source;
+}
+
+} // namespace Mmp
@@ -1,12 +1,152 @@
 #include "AbstractDisplay.h"
 
 #include <vector>
+#include <cassert>
+#include <algorithm>
+
+#include "Common/NormalPicture.h"
+#include "Common/AbstractAllocateMethod.h"
 
 #include "DisplaySDL.h"
 
 namespace Mmp
 {
 
+/**
+ * @brief 引用外部内存的分配器, 不拥有也不分配内存
+ */
+class ExternalAllocateMethod : public AbstractAllocateMethod
+{
+public:
+    ExternalAllocateMethod(uint8_t* data, size_t size)
+        : _data(data), _size(size)
+    {
+    }
+public:
+    void* Malloc(size_t size) override
+    {
+        assert(size <= _size);
+        return _data;
+    }
+    void* Resize(void* data, size_t size) override
+    {
+        assert(size <= _size);
+        return data;
+    }
+    void* GetAddress(uint64_t offset) override
+    {
+        return _data + offset;
+    }
+    const std::string& Tag() override
+    {
+        static const std::string tag = "ExternalAllocateMethod";
+        return tag;
+    }
+private:
+    uint8_t* _data;
+    size_t   _size;
+};
+
+DisplayBuffer::DisplayBuffer()
+{
+    for (size_t i = 0; i < 3; i++)
+    {
+        data[i]   = nullptr;
+        stride[i] = 0;
+    }
+}
+
+AbstractPicture::ptr WrapDisplayBuffer(const DisplayBuffer& buffer)
+{
+    const PixelsInfo& info = buffer.info;
+    size_t size = 0;
+    switch (info.format)
+    {
+        case PixelFormat::RGBA8888:
+        case PixelFormat::BGRA8888:
+        {
+            if (buffer.stride[0] != info.width * 4)
+            {
+                return nullptr;
+            }
+            size = (size_t)info.width * info.height * 4;
+            break;
+        }
+        case PixelFormat::NV12:
+        {
+            if (buffer.stride[0] != info.width || buffer.stride[1] != info.width || buffer.data[1] != buffer.data[0] + (size_t)info.width * info.height)
+            {
+                return nullptr;
+            }
+            size = (size_t)info.width * info.height * 3 / 2;
+            break;
+        }
+        default:
+        {
+            return nullptr;
+        }
+    }
+    if (!buffer.data[0])
+    {
+        return nullptr;
+    }
+    return std::make_shared<NormalPicture>(info, std::make_shared<ExternalAllocateMethod>(buffer.data[0], size));
+}
+
+DisplayBufferCache::DisplayBufferCache()
+{
+    _next = 0;
+    _entries.reserve(kMaxEntries);
+}
+
+AbstractPicture::ptr DisplayBufferCache::Wrap(const DisplayBuffer& buffer)
+{
+    for (const Entry& entry : _entries)
+    {
+        const DisplayBuffer& cached = entry.buffer;
+        if (std::equal(cached.data, cached.data + 3, buffer.data) && std::equal(cached.stride, cached.stride + 3, buffer.stride) &&
+            cached.info.width == buffer.info.width && cached.info.height == buffer.info.height && cached.info.format == buffer.info.format)
+        {
+            return entry.picture;
+        }
+    }
+    AbstractPicture::ptr picture = WrapDisplayBuffer(buffer);
+    if (!picture)
+    {
+        return nullptr;
+    }
+    Entry entry;
+    entry.buffer  = buffer;
+    entry.picture = picture;
+    if (_entries.size() < kMaxEntries)
+    {
+        _entries.push_back(entry);
+    }
+    else
+    {
+        _entries[_next] = entry;
+        _next = (_next + 1) % kMaxEntries;
+    }
+    return picture;
+}
+
+bool AbstractDisplay::AcquireBuffer(DisplayBuffer& /* buffer */)
+{
+    return false;
+}
+
+void AbstractDisplay::Present()
+{
+}
+
+void AbstractDisplay::AbortBuffer()
+{
+}
+
+void AbstractDisplay::SetFitToDisplay(bool /* fit */, ScaleFilter /* filter */)
+{
+}
+
 AbstractDisplay::ptr AbstractDisplay::Create(const std::string& className)
 {
     static std::vector<std::string> kClassNames = 
@@ -0,0 +1,88 @@
+#include "AbstractPacketReader.h"
+
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+#include "Common/LogMessage.h"
+
+#include "H26XFileByteReader.h"
+#include "Mp4Demuxer.h"
+#include "IvfDemuxer.h"
+
+namespace Mmp
+{
+
+static bool HasExtension(const std::string& path, const std::string& extension)
+{
+    if (path.size() < extension.size())
+    {
+        return false;
+    }
+    std::string tail = path.substr(path.size() - extension.size());
+    std::transform(tail.begin(), tail.end(), tail.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return tail == extension;
+}
+
+enum class ContainerType
+{
+    ANNEXB,
+    MP4,
+    IVF
+};
+
+static ContainerType ProbeContainer(const std::string& path)
+{
+    // Hint : 与 AbstractByteSource::Create 一致, 非文件输入无法映射, 只能按 Annex-B 裸流读取
+    if (path == "-" || path == "stdin" || path.rfind("pipe://", 0) == 0 || path.rfind("udp://", 0) == 0 || path.rfind("unix://", 0) == 0)
+    {
+        return ContainerType::ANNEXB;
+    }
+    char magic[8] = {0};
+    {
+        std::ifstream ifs(path, std::ios::in | std::ios::binary);
+        ifs.read(magic, sizeof(magic));
+    }
+    if (memcmp(magic + 4, "ftyp", 4) == 0 || HasExtension(path, ".mp4") || HasExtension(path, ".mov") || HasExtension(path, ".m4v"))
+    {
+        return ContainerType::MP4;
+    }
+    else if (memcmp(magic, "DKIF", 4) == 0 || HasExtension(path, ".ivf"))
+    {
+        return ContainerType::IVF;
+    }
+    else
+    {
+        return ContainerType::ANNEXB;
+    }
+}
+
+AbstractPacketReader::ptr AbstractPacketReader::Create(const std::string& path, Codec::CodecType codecType)
+{
+    std::string filePath = path.rfind("file://", 0) == 0 ? path.substr(7) : path;
+    switch (ProbeContainer(filePath))
+    {
+        case ContainerType::MP4:
+        {
+            std::shared_ptr<Mp4Demuxer> demuxer = std::make_shared<Mp4Demuxer>();
+            demuxer->Open(filePath);
+            return demuxer;
+        }
+        case ContainerType::IVF:
+        {
+            std::shared_ptr<IvfDemuxer> demuxer = std::make_shared<IvfDemuxer>();
+            demuxer->Open(filePath);
+            return demuxer;
+        }
+        default:
+            return std::make_shared<H26XFileByteReader>(path, codecType);
+    }
+}
+
+bool AbstractPacketReader::IsAnnexB(const std::string& path)
+{
+    return ProbeContainer(path.rfind("file://", 0) == 0 ? path.substr(7) : path) == ContainerType::ANNEXB;
+}
+
+} // namespace Mmp
@@ -0,0 +1,280 @@
+#include "AllocTracker.h"
+
+#include <new>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Common/LogMessage.h"
+
+#ifdef MMP_ENABLE_ALLOC_TRACKER
+
+// Hint : 只使用平凡类型的 thread_local, 保证 operator new 中访问时无需动态初始化
+static thread_local uint64_t gThreadAllocCount  = 0;
+static thread_local uint64_t gThreadAllocBytes  = 0;
+static thread_local bool     gThreadAssert      = false;
+
+static void* TrackedAlloc(std::size_t size, std::size_t alignment)
+{
+    if (gThreadAssert)
+    {
+        gThreadAssert = false;
+        std::fprintf(stderr, "AllocTracker: unexpected allocation of %zu bytes in no-allocation scope\n", size);
+        std::abort();
+    }
+    gThreadAllocCount++;
+    gThreadAllocBytes += size;
+    size = size == 0 ? 1 : size;
+    void* ptr = nullptr;
+    if (alignment <= alignof(std::max_align_t))
+    {
+        ptr = std::malloc(size);
+    }
+    else
+    {
+#ifdef _WIN32
+        ptr = _aligned_malloc(size, alignment);
+#else
+        if (posix_memalign(&ptr, alignment, size) != 0)
+        {
+            ptr = nullptr;
+        }
+#endif
+    }
+    return ptr;
+}
+
+static void TrackedFree(void* ptr, std::size_t alignment)
+{
+#ifdef _WIN32
+    if (alignment > alignof(std::max_align_t))
+    {
+        _aligned_free(ptr);
+        return;
+    }
+#endif
+    (void)alignment;
+    std::free(ptr);
+}
+
+void* operator new(std::size_t size)
+{
+    void* ptr = TrackedAlloc(size, 0);
+    if (!ptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return TrackedAlloc(size, 0);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return TrackedAlloc(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    void* ptr = TrackedAlloc(size, (std::size_t)alignment);
+    if (!ptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    TrackedFree(ptr, 0);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    TrackedFree(ptr, 0);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    TrackedFree(ptr, 0);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    TrackedFree(ptr, 0);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment) noexcept
+{
+    TrackedFree(ptr, (std::size_t)alignment);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept
+{
+    TrackedFree(ptr, (std::size_t)alignment);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept
+{
+    TrackedFree(ptr, (std::size_t)alignment);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t alignment) noexcept
+{
+    TrackedFree(ptr, (std::size_t)alignment);
+}
+
+#endif /* MMP_ENABLE_ALLOC_TRACKER */
+
+namespace Mmp
+{
+
+bool AllocTracker::Enabled()
+{
+#ifdef MMP_ENABLE_ALLOC_TRACKER
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t AllocTracker::GetThreadAllocCount()
+{
+#ifdef MMP_ENABLE_ALLOC_TRACKER
+    return gThreadAllocCount;
+#else
+    return 0;
+#endif
+}
+
+uint64_t AllocTracker::GetThreadAllocBytes()
+{
+#ifdef MMP_ENABLE_ALLOC_TRACKER
+    return gThreadAllocBytes;
+#else
+    return 0;
+#endif
+}
+
+void AllocTracker::SetThreadAssert(bool enable)
+{
+#ifdef MMP_ENABLE_ALLOC_TRACKER
+    gThreadAssert = enable;
+#else
+    (void)enable;
+#endif
+}
+
+bool AllocTracker::GetThreadAssert()
+{
+#ifdef MMP_ENABLE_ALLOC_TRACKER
+    return gThreadAssert;
+#else
+    return false;
+#endif
+}
+
+AllocStage::AllocStage(const std::string& name)
+{
+    _name         = name;
+    _warmUp       = 0;
+    _frames       = 0;
+    _allocs       = 0;
+    _bytes        = 0;
+    _steadyAllocs = 0;
+    _maxAllocs    = 0;
+    _beginCount   = 0;
+    _beginBytes   = 0;
+}
+
+void AllocStage::SetWarmUp(uint64_t frames)
+{
+    _warmUp = frames;
+}
+
+void AllocStage::Begin()
+{
+    _beginCount = AllocTracker::GetThreadAllocCount();
+    _beginBytes = AllocTracker::GetThreadAllocBytes();
+}
+
+void AllocStage::End()
+{
+    uint64_t allocs = AllocTracker::GetThreadAllocCount() - _beginCount;
+    _allocs += allocs;
+    _bytes  += AllocTracker::GetThreadAllocBytes() - _beginBytes;
+    _maxAllocs = std::max(_maxAllocs, allocs);
+    if (_frames >= _warmUp)
+    {
+        _steadyAllocs += allocs;
+    }
+    _frames++;
+}
+
+uint64_t AllocStage::GetSteadyAllocCount()
+{
+    return _steadyAllocs;
+}
+
+void AllocStage::Report()
+{
+    if (!AllocTracker::Enabled() || _frames == 0)
+    {
+        return;
+    }
+    MMP_LOG_INFO << "Alloc stage (" << _name << ") frames : " << _frames
+                 << ", allocs/frame : " << (double)_allocs / _frames
+                 << ", bytes/frame : " << _bytes / _frames
+                 << ", max allocs in one frame : " << _maxAllocs
+                 << ", allocs after warm-up(" << _warmUp << ") : " << _steadyAllocs;
+}
+
+AllocAssertScope::AllocAssertScope(bool armed)
+{
+    _armed = armed && AllocTracker::Enabled();
+    if (_armed)
+    {
+        AllocTracker::SetThreadAssert(true);
+    }
+}
+
+AllocAssertScope::~AllocAssertScope()
+{
+    if (_armed)
+    {
+        AllocTracker::SetThreadAssert(false);
+    }
+}
+
+AllocAssertPause::AllocAssertPause()
+{
+    _paused = AllocTracker::GetThreadAssert();
+    if (_paused)
+    {
+        AllocTracker::SetThreadAssert(false);
+    }
+}
+
+AllocAssertPause::~AllocAssertPause()
+{
+    if (_paused)
+    {
+        AllocTracker::SetThreadAssert(true);
+    }
+}
+
+} // namespace Mmp
\ No newline at end of file
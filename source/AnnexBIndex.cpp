@@ -0,0 +1,411 @@
+#include "AnnexBIndex.h"
+
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+
+#include <Poco/File.h>
+#include <Poco/Timestamp.h>
+
+#include "Common/LogMessage.h"
+#include "Common/ImmutableVectorAllocateMethod.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief 跳过起始码, 返回 NAL header 位置
+ */
+static const uint8_t* SkipStartCode(const uint8_t* nal, size_t size, size_t& remain)
+{
+    size_t pos = 0;
+    while (pos + 1 < size && nal[pos] == 0)
+    {
+        pos++;
+    }
+    if (pos >= 2 && nal[pos] == 1)
+    {
+        pos++;
+    }
+    remain = size > pos ? size - pos : 0;
+    return nal + pos;
+}
+
+/**
+ * @brief 是否为 VCL NAL (slice)
+ */
+static bool IsVcl(Codec::CodecType codecType, const uint8_t* header, size_t remain)
+{
+    if (codecType == Codec::CodecType::H265)
+    {
+        uint8_t type = (header[0] >> 1) & 0x3F;
+        return remain >= 3 && type <= 31;
+    }
+    else
+    {
+        uint8_t type = header[0] & 0x1F;
+        return remain >= 2 && type >= 1 && type <= 5;
+    }
+}
+
+constexpr size_t kParameterSetKinds = 3;
+
+/**
+ * @brief 参数集种类, VPS/SPS/PPS 分别为 0/1/2, 不是参数集时返回 -1
+ */
+static int GetParameterSetKind(Codec::CodecType codecType, const uint8_t* header)
+{
+    if (codecType == Codec::CodecType::H265)
+    {
+        uint8_t type = (header[0] >> 1) & 0x3F;
+        return type >= 32 && type <= 34 ? type - 32 : -1;
+    }
+    else
+    {
+        uint8_t type = header[0] & 0x1F;
+        return type == 7 ? 1 : (type == 8 ? 2 : -1);
+    }
+}
+
+bool AnnexBIndex::IsRandomAccessPoint(Codec::CodecType codecType, const uint8_t* nal, size_t size)
+{
+    size_t remain = 0;
+    const uint8_t* header = SkipStartCode(nal, size, remain);
+    if (remain == 0)
+    {
+        return false;
+    }
+    if (codecType == Codec::CodecType::H265)
+    {
+        uint8_t type = (header[0] >> 1) & 0x3F;
+        return type >= 16 && type <= 23; // BLA/IDR/CRA
+    }
+    else
+    {
+        return (header[0] & 0x1F) == 5; // IDR
+    }
+}
+
+bool AnnexBIndex::IsFirstSliceOfPicture(Codec::CodecType codecType, const uint8_t* nal, size_t size)
+{
+    size_t remain = 0;
+    const uint8_t* header = SkipStartCode(nal, size, remain);
+    if (remain == 0 || !IsVcl(codecType, header, remain))
+    {
+        return false;
+    }
+    if (codecType == Codec::CodecType::H265)
+    {
+        return (header[2] & 0x80) != 0; // first_slice_segment_in_pic_flag
+    }
+    else
+    {
+        return (header[1] & 0x80) != 0; // first_mb_in_slice == 0 (ue(v) 编码为单个 bit 1)
+    }
+}
+
+AnnexBIndex::AnnexBIndex(Codec::CodecType codecType)
+{
+    _codecType  = codecType;
+    _frameCount = 0;
+}
+
+bool AnnexBIndex::Build(const std::string& path)
+{
+    _entries.clear();
+    _frameCount = 0;
+    H26XFileByteReader reader(path, _codecType);
+    uint64_t auPrefixOffset = 0;
+    bool     hasAuPrefix = false;
+    uint64_t parameterSetOffsets[kParameterSetKinds] = {0};
+    bool     hasParameterSet[kParameterSetKinds] = {false};
+    Codec::StreamPack::ptr pack;
+    while ((pack = reader.GetNalUint()))
+    {
+        const uint8_t* nal = (const uint8_t*)pack->GetData();
+        size_t size = pack->GetSize();
+        size_t remain = 0;
+        const uint8_t* header = SkipStartCode(nal, size, remain);
+        if (remain == 0)
+        {
+            continue;
+        }
+        if (!IsVcl(_codecType, header, remain))
+        {
+            int kind = GetParameterSetKind(_codecType, header);
+            if (kind >= 0)
+            {
+                parameterSetOffsets[kind] = reader.GetLastNalOffset();
+                hasParameterSet[kind] = true;
+            }
+            // Hint : 记录访问单元中第一个非 VCL NAL, 随机访问点需从这里开始送入
+            if (!hasAuPrefix)
+            {
+                auPrefixOffset = reader.GetLastNalOffset();
+                hasAuPrefix = true;
+            }
+            continue;
+        }
+        if (IsFirstSliceOfPicture(_codecType, nal, size))
+        {
+            if (IsRandomAccessPoint(_codecType, nal, size))
+            {
+                Entry entry = {hasAuPrefix ? auPrefixOffset : reader.GetLastNalOffset(), _frameCount, {}};
+                // Hint : 访问单元内自带的参数集会随随机访问点一起送入, 只记录之前的
+                for (size_t kind = 0; kind < kParameterSetKinds; kind++)
+                {
+                    if (hasParameterSet[kind] && parameterSetOffsets[kind] < entry.offset)
+                    {
+                        entry.parameterSets.push_back(parameterSetOffsets[kind]);
+                    }
+                }
+                _entries.push_back(entry);
+            }
+            _frameCount++;
+        }
+        hasAuPrefix = false;
+    }
+    MMP_LOG_INFO << "AnnexBIndex build, frames : " << _frameCount << ", random access points : " << _entries.size();
+    return !_entries.empty();
+}
+
+std::string AnnexBIndex::GetIndexPath(const std::string& path)
+{
+    return path + ".idx";
+}
+
+bool AnnexBIndex::GetSignature(const std::string& path, Signature& signature)
+{
+    constexpr uint64_t kHashBytes = 64 * 1024;
+    std::ifstream ifs(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!ifs.is_open())
+    {
+        return false;
+    }
+    signature.fileSize = (uint64_t)ifs.tellg();
+    signature.hash = 0xcbf29ce484222325ULL;
+    std::vector<char> buf(kHashBytes);
+    auto hashRange = [&](uint64_t offset, uint64_t size) -> bool
+    {
+        ifs.seekg((std::streamoff)offset, std::ios::beg);
+        ifs.read(buf.data(), (std::streamsize)size);
+        if ((uint64_t)ifs.gcount() != size)
+        {
+            return false;
+        }
+        for (uint64_t i = 0; i < size; i++)
+        {
+            signature.hash ^= (uint8_t)buf[i];
+            signature.hash *= 0x100000001b3ULL;
+        }
+        return true;
+    };
+    // Hint : 文件不足 128 KiB 时首尾区间重叠, 只哈希一次
+    uint64_t headSize = std::min(signature.fileSize, kHashBytes);
+    uint64_t tailOffset = std::max(signature.fileSize - std::min(signature.fileSize, kHashBytes), headSize);
+    if (!hashRange(0, headSize) || !hashRange(tailOffset, signature.fileSize - tailOffset))
+    {
+        return false;
+    }
+    try
+    {
+        signature.modified = Poco::File(path).getLastModified().epochMicroseconds();
+    }
+    catch (...)
+    {
+        return false;
+    }
+    return true;
+}
+
+bool AnnexBIndex::Load(const std::string& indexPath, const Signature& signature)
+{
+    std::ifstream ifs(indexPath);
+    if (!ifs.is_open())
+    {
+        return false;
+    }
+    std::string magic;
+    int version = 0;
+    Signature indexed = {};
+    size_t count = 0;
+    ifs >> magic >> version >> indexed.fileSize >> indexed.modified >> indexed.hash >> _frameCount >> count;
+    if (ifs.fail() || magic != "mmp-annexb-index" || version != 3 ||
+        indexed.fileSize != signature.fileSize || indexed.modified != signature.modified || indexed.hash != signature.hash)
+    {
+        return false;
+    }
+    _entries.resize(count);
+    for (auto& entry : _entries)
+    {
+        size_t parameterSets = 0;
+        ifs >> entry.offset >> entry.frame >> parameterSets;
+        if (ifs.fail() || parameterSets > kParameterSetKinds)
+        {
+            return false;
+        }
+        entry.parameterSets.resize(parameterSets);
+        for (auto& offset : entry.parameterSets)
+        {
+            ifs >> offset;
+        }
+    }
+    return !ifs.fail();
+}
+
+bool AnnexBIndex::Save(const std::string& indexPath, const Signature& signature)
+{
+    std::ofstream ofs(indexPath, std::ios::out | std::ios::trunc);
+    if (!ofs.is_open())
+    {
+        return false;
+    }
+    ofs << "mmp-annexb-index " << 3 << " " << signature.fileSize << " " << signature.modified << " " << signature.hash << " " << _frameCount << " " << _entries.size() << "\n";
+    for (const auto& entry : _entries)
+    {
+        ofs << entry.offset << " " << entry.frame << " " << entry.parameterSets.size();
+        for (const auto& offset : entry.parameterSets)
+        {
+            ofs << " " << offset;
+        }
+        ofs << "\n";
+    }
+    return ofs.good();
+}
+
+bool AnnexBIndex::LoadOrBuild(const std::string& path)
+{
+    Signature signature = {};
+    if (!GetSignature(path, signature))
+    {
+        return false;
+    }
+    std::string indexPath = GetIndexPath(path);
+    if (Load(indexPath, signature))
+    {
+        MMP_LOG_INFO << "AnnexBIndex load from " << indexPath << ", random access points : " << _entries.size();
+        return true;
+    }
+    if (!Build(path))
+    {
+        return false;
+    }
+    if (!Save(indexPath, signature))
+    {
+        MMP_LOG_WARN << "AnnexBIndex save fail, path is: " << indexPath;
+    }
+    return true;
+}
+
+const AnnexBIndex::Entry* AnnexBIndex::FindByFrame(uint64_t frame)
+{
+    auto it = std::upper_bound(_entries.begin(), _entries.end(), frame, [](uint64_t value, const Entry& entry)
+    {
+        return value < entry.frame;
+    });
+    if (it == _entries.begin())
+    {
+        return nullptr;
+    }
+    return &(*(it - 1));
+}
+
+const AnnexBIndex::Entry* AnnexBIndex::FindByTime(double second, double fps)
+{
+    return FindByFrame(second <= 0 ? 0 : (uint64_t)(second * fps));
+}
+
+const std::vector<AnnexBIndex::Entry>& AnnexBIndex::GetEntries()
+{
+    return _entries;
+}
+
+uint64_t AnnexBIndex::GetFrameCount()
+{
+    return _frameCount;
+}
+
+uint64_t AnnexBIndex::SeekToFrame(H26XFileByteReader& reader, uint64_t frame)
+{
+    const Entry* entry = FindByFrame(frame);
+    if (!entry)
+    {
+        reader.Seek(0);
+        return 0;
+    }
+    reader.Seek((size_t)entry->offset);
+    return entry->frame;
+}
+
+uint64_t AnnexBIndex::SeekToFrame(H26XFileByteReader& reader, uint64_t frame, Codec::StreamPack::ptr& parameterSets)
+{
+    parameterSets = nullptr;
+    const Entry* entry = FindByFrame(frame);
+    if (!entry)
+    {
+        reader.Seek(0);
+        return 0;
+    }
+    if (!entry->parameterSets.empty())
+    {
+        std::shared_ptr<ImmutableVectorAllocateMethod<uint8_t>> alloc = std::make_shared<ImmutableVectorAllocateMethod<uint8_t>>();
+        for (const auto& offset : entry->parameterSets)
+        {
+            reader.Seek((size_t)offset);
+            Codec::StreamPack::ptr pack = reader.GetNalUint();
+            if (pack)
+            {
+                const uint8_t* data = (const uint8_t*)pack->GetData();
+                alloc->container.insert(alloc->container.end(), data, data + pack->GetSize());
+            }
+        }
+        parameterSets = std::make_shared<Codec::StreamPack>(_codecType, alloc->container.size(), alloc);
+    }
+    reader.Seek((size_t)entry->offset);
+    return entry->frame;
+}
+
+Codec::CodecType GetDecoderCodecType(const std::string& decoderClassName)
+{
+    std::vector<Codec::CodecDescription> descriptions = Codec::DecoderFactory::DefaultFactory().GetDecoderDescriptions();
+    for (const auto& description : descriptions)
+    {
+        if (description.name == decoderClassName)
+        {
+            return description.codecType;
+        }
+    }
+    return Codec::CodecType::H264;
+}
+
+Codec::StreamPack::ptr CreateEndOfStreamPack(Codec::CodecType codecType)
+{
+    return std::make_shared<Codec::StreamPack>(codecType, 0, std::make_shared<ImmutableVectorAllocateMethod<uint8_t>>());
+}
+
+uint64_t FlushDecoder(Codec::AbstractDecoder::ptr decoder, Codec::CodecType codecType, uint64_t expectFrames, uint32_t idleTimeoutMs,
+                      const std::function<void(AbstractFrame::ptr frame)>& callback)
+{
+    decoder->Push(CreateEndOfStreamPack(codecType));
+    uint64_t frames = 0;
+    Poco::Timestamp lastOutput;
+    while (frames < expectFrames && lastOutput.elapsed() < (int64_t)idleTimeoutMs * 1000)
+    {
+        AbstractFrame::ptr frame;
+        if (decoder->Pop(frame))
+        {
+            callback(frame);
+            frames++;
+            lastOutput.update();
+        }
+        else
+        {
+            // Hint : 异步解码器 (硬件) 送入结束标记后仍需时间输出
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    }
+    return frames;
+}
+
+} // namespace Mmp
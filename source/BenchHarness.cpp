@@ -0,0 +1,222 @@
+#include "BenchHarness.h"
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+#include "Common/LogMessage.h"
+
+namespace Mmp
+{
+
+constexpr uint64_t kMaxIterations = 1000000000;
+
+BenchState::BenchState(uint64_t iterations)
+{
+    this->iterations = iterations;
+    elapsedNs = 0;
+    bytes     = 0;
+    items     = 0;
+    _remain   = iterations;
+    _started  = false;
+    _paused   = false;
+}
+
+bool BenchState::KeepRunning()
+{
+    if (!_started)
+    {
+        _started = true;
+        _stamp.update();
+    }
+    if (_remain != 0 && error.empty())
+    {
+        _remain--;
+        return true;
+    }
+    if (!_paused)
+    {
+        elapsedNs += (uint64_t)_stamp.elapsed() * 1000;
+        _paused = true;
+    }
+    return false;
+}
+
+void BenchState::PauseTiming()
+{
+    if (!_paused)
+    {
+        elapsedNs += (uint64_t)_stamp.elapsed() * 1000;
+        _paused = true;
+    }
+}
+
+void BenchState::ResumeTiming()
+{
+    if (_paused)
+    {
+        _paused = false;
+        _stamp.update();
+    }
+}
+
+void BenchState::SetBytesProcessed(uint64_t bytes)
+{
+    this->bytes = bytes;
+}
+
+void BenchState::SetItemsProcessed(uint64_t items)
+{
+    this->items = items;
+}
+
+void BenchState::SetCounter(const std::string& name, double value)
+{
+    counters[name] = value;
+}
+
+void BenchState::SkipWithError(const std::string& reason)
+{
+    error = reason;
+}
+
+BenchRegistry& BenchRegistry::Instance()
+{
+    static BenchRegistry registry;
+    return registry;
+}
+
+void BenchRegistry::Register(const std::string& name, const BenchFunc& func)
+{
+    _benches.push_back({name, func});
+}
+
+std::vector<std::string> BenchRegistry::GetNames()
+{
+    std::vector<std::string> names;
+    for (const auto& bench : _benches)
+    {
+        names.push_back(bench.first);
+    }
+    return names;
+}
+
+static std::string JsonEscape(const std::string& str)
+{
+    std::stringstream ss;
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            ss << '\\' << c;
+        }
+        else if ((unsigned char)c < 0x20)
+        {
+            ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec;
+        }
+        else
+        {
+            ss << c;
+        }
+    }
+    return ss.str();
+}
+
+/**
+ * @brief 迭代次数从 1 开始按耗时估算增长, 直到单次运行耗时不小于 minTimeMs
+ */
+static BenchState RunOnce(const BenchRegistry::BenchFunc& func, uint32_t minTimeMs)
+{
+    uint64_t iterations = 1;
+    while (true)
+    {
+        BenchState state(iterations);
+        func(state);
+        uint64_t minTimeNs = (uint64_t)minTimeMs * 1000000;
+        if (!state.error.empty() || state.elapsedNs >= minTimeNs || iterations >= kMaxIterations)
+        {
+            return state;
+        }
+        double scale = state.elapsedNs == 0 ? 100.0 : std::min(100.0, std::max(1.5, 1.4 * minTimeNs / state.elapsedNs));
+        iterations = std::min(kMaxIterations, (uint64_t)std::ceil(iterations * scale));
+    }
+}
+
+void BenchRegistry::Run(const std::string& filter, uint32_t minTimeMs, uint32_t repetitions,
+                        const std::map<std::string, std::string>& context, std::ostream& json)
+{
+    repetitions = std::max(repetitions, (uint32_t)1);
+    json << "{\n  \"context\": {";
+    {
+        bool first = true;
+        for (const auto& kv : context)
+        {
+            json << (first ? "\n" : ",\n") << "    \"" << JsonEscape(kv.first) << "\": \"" << JsonEscape(kv.second) << "\"";
+            first = false;
+        }
+    }
+    json << "\n  },\n  \"benchmarks\": [";
+    bool firstBench = true;
+    for (const auto& bench : _benches)
+    {
+        if (!filter.empty() && bench.first.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        std::vector<BenchState> runs;
+        for (uint32_t i = 0; i < repetitions; i++)
+        {
+            runs.push_back(RunOnce(bench.second, minTimeMs));
+            if (!runs.back().error.empty())
+            {
+                break;
+            }
+        }
+        std::vector<double> nsPerOp;
+        for (const auto& run : runs)
+        {
+            nsPerOp.push_back(run.iterations ? (double)run.elapsedNs / run.iterations : 0);
+        }
+        std::vector<double> sorted = nsPerOp;
+        std::sort(sorted.begin(), sorted.end());
+        double median = sorted[sorted.size() / 2];
+        // Hint : 吞吐量及自定义指标取耗时为中位数的那一次
+        const BenchState& run = runs[std::find(nsPerOp.begin(), nsPerOp.end(), median) - nsPerOp.begin()];
+
+        json << (firstBench ? "\n" : ",\n") << "    {\n";
+        json << "      \"name\": \"" << JsonEscape(bench.first) << "\",\n";
+        if (!run.error.empty())
+        {
+            json << "      \"error\": \"" << JsonEscape(run.error) << "\"\n    }";
+            MMP_LOG_WARN << "Bench " << bench.first << " skipped : " << run.error;
+            firstBench = false;
+            continue;
+        }
+        json << std::fixed << std::setprecision(3);
+        json << "      \"repetitions\": " << runs.size() << ",\n";
+        json << "      \"iterations\": " << run.iterations << ",\n";
+        json << "      \"ns_per_op\": " << median << ",\n";
+        json << "      \"ns_per_op_min\": " << sorted.front();
+        double second = run.elapsedNs / 1e9;
+        if (run.bytes && second > 0)
+        {
+            json << ",\n      \"bytes_per_second\": " << run.bytes / second;
+        }
+        if (run.items && second > 0)
+        {
+            json << ",\n      \"items_per_second\": " << run.items / second;
+        }
+        for (const auto& counter : run.counters)
+        {
+            json << ",\n      \"" << JsonEscape(counter.first) << "\": " << counter.second;
+        }
+        json << "\n    }";
+        json.unsetf(std::ios::floatfield);
+        MMP_LOG_INFO << "Bench " << bench.first << " : " << median << " ns/op (" << run.iterations << " iterations)";
+        firstBench = false;
+    }
+    json << "\n  ]\n}\n";
+}
+
+} // namespace Mmp
@@ -18,6 +18,9 @@ DisplaySDL::DisplaySDL()
     _window         = nullptr;
     _render         = nullptr;
     _texture        = nullptr;
+    _frameBuffer    = nullptr;
+    _fitToDisplay   = true;
+    _scaleFilter    = ScaleFilter::AREA;
     _title          = "MMP";
     _selfInit       = true;
 }
@@ -104,8 +107,10 @@ bool DisplaySDL::Open(PixelsInfo info)
     }
     DISPLAY_LOG_INFO << "Try to open SDL window";
     std::string windowTitle = _title.empty() ? "SDL Window" : _title;
-    _windowWidth = info.width;
-    _windowHeight = info.height;
+    // Hint : 窗口不超过主屏幕, 超出时等比缩小, 由 UpdateWindow 在上传前缩放, 而不是交给 SDL 渲染器
+    PixelsInfo windowInfo = _fitToDisplay ? FitToDisplay(info, _displayWidth, _displayHeight) : info;
+    _windowWidth = windowInfo.width;
+    _windowHeight = windowInfo.height;
     uint32_t format = 0;
     if (info.format == PixelFormat::BGRA8888)
     {
@@ -161,6 +166,17 @@ bool DisplaySDL::Open(PixelsInfo info)
         return false;
     }
     SDL_SetTextureBlendMode(_texture, SDL_BLENDMODE_BLEND); // 支持透明度
+    if (windowInfo.width != info.width || windowInfo.height != info.height)
+    {
+        _scaler = std::make_shared<FrameScaler>(info, windowInfo, _scaleFilter);
+        if (!_scaler->IsValid())
+        {
+            DISPLAY_LOG_ERROR << "Create frame scaler fail";
+            _scaler = nullptr;
+            return false;
+        }
+        DISPLAY_LOG_INFO << "Fit (" << info.width << "x" << info.height << ") to display, window is (" << _windowWidth << "x" << _windowHeight << ")";
+    }
 
     DISPLAY_LOG_INFO << "Open SDL window successfully";
 
@@ -170,6 +186,12 @@ bool DisplaySDL::Open(PixelsInfo info)
 bool DisplaySDL::Close()
 {
     DISPLAY_LOG_INFO << "Try to close SDL window";
+    if (_texture && _frameBuffer)
+    {
+        SDL_UnlockTexture(_texture);
+        _frameBuffer = nullptr;
+    }
+    _scaler = nullptr;
     if (_texture)
     {
         SDL_DestroyTexture(_texture);
@@ -194,6 +216,46 @@ bool DisplaySDL::Close()
 
 void DisplaySDL::UpdateWindow(const uint32_t* frameBuffer, PixelsInfo info)
 {
+    if (_scaler)
+    {
+        const uint8_t* src[3] = {(const uint8_t*)frameBuffer, nullptr, nullptr};
+        int32_t srcStride[3] = {info.width, 0, 0};
+        switch (info.format)
+        {
+            case PixelFormat::RGBA8888:
+            case PixelFormat::BGRA8888:
+            {
+                srcStride[0] = info.width * 4;
+                break;
+            }
+            case PixelFormat::NV12:
+            {
+                src[1]       = src[0] + info.width * info.height;
+                srcStride[1] = info.width;
+                break;
+            }
+            case PixelFormat::YUV420P:
+            {
+                src[1]       = src[0] + (info.virStride * info.horStride);
+                src[2]       = src[1] + (info.virStride * info.horStride / 4);
+                srcStride[0] = info.horStride;
+                srcStride[1] = info.horStride / 2;
+                srcStride[2] = info.horStride / 2;
+                break;
+            }
+            default:
+            {
+                return;
+            }
+        }
+        DisplayBuffer buffer;
+        if (AcquireBuffer(buffer))
+        {
+            _scaler->Scale(src, srcStride, buffer.data, buffer.stride);
+            Present();
+        }
+        return;
+    }
     switch (info.format)
     {
         case PixelFormat::RGBA8888:
@@ -238,4 +300,78 @@ void DisplaySDL::UpdateWindow(const uint32_t* frameBuffer, PixelsInfo info)
     SDL_RenderPresent(_render);
 }
 
+bool DisplaySDL::AcquireBuffer(DisplayBuffer& buffer)
+{
+    if (!_texture)
+    {
+        return false;
+    }
+    if (_frameBuffer)
+    {
+        DISPLAY_LOG_WARN << "AcquireBuffer is called again before Present";
+        return false;
+    }
+    void* pixels = nullptr;
+    int pitch = 0;
+    if (SDL_LockTexture(_texture, NULL, &pixels, &pitch) != 0)
+    {
+        DISPLAY_LOG_ERROR << "Lock SDL texture fail, error is: " << SDL_GetError();
+        return false;
+    }
+    _frameBuffer = reinterpret_cast<uint32_t*>(pixels);
+    buffer = DisplayBuffer();
+    buffer.info = PixelsInfo(_windowWidth, _windowHeight, 8, _format);
+    buffer.data[0] = reinterpret_cast<uint8_t*>(pixels);
+    buffer.stride[0] = pitch;
+    // Hint : 锁定 YUV 纹理时 SDL 返回的各平面首尾相接
+    switch (_format)
+    {
+        case PixelFormat::NV12:
+        {
+            buffer.data[1]   = buffer.data[0] + pitch * _windowHeight;
+            buffer.stride[1] = pitch;
+            break;
+        }
+        case PixelFormat::YUV420P:
+        {
+            buffer.data[1]   = buffer.data[0] + pitch * _windowHeight;
+            buffer.stride[1] = pitch / 2;
+            buffer.data[2]   = buffer.data[1] + (pitch / 2) * (_windowHeight / 2);
+            buffer.stride[2] = pitch / 2;
+            break;
+        }
+        default:
+            break;
+    }
+    return true;
+}
+
+void DisplaySDL::Present()
+{
+    if (!_frameBuffer)
+    {
+        return;
+    }
+    SDL_UnlockTexture(_texture);
+    _frameBuffer = nullptr;
+    SDL_RenderCopy(_render, _texture, NULL, NULL);
+    SDL_RenderPresent(_render);
+}
+
+void DisplaySDL::AbortBuffer()
+{
+    if (!_frameBuffer)
+    {
+        return;
+    }
+    SDL_UnlockTexture(_texture);
+    _frameBuffer = nullptr;
+}
+
+void DisplaySDL::SetFitToDisplay(bool fit, ScaleFilter filter)
+{
+    _fitToDisplay = fit;
+    _scaleFilter  = filter;
+}
+
 } // namespace Mmp
\ No newline at end of file
@@ -34,6 +34,10 @@ public:
     bool Open(PixelsInfo info) override;
     bool Close() override;
     void UpdateWindow(const uint32_t* frameBuffer, PixelsInfo info) override;
+    bool AcquireBuffer(DisplayBuffer& buffer) override;
+    void Present() override;
+    void AbortBuffer() override;
+    void SetFitToDisplay(bool fit, ScaleFilter filter) override;
 private:
     uint32_t     _displayWidth;
     uint32_t     _displayHeight;
@@ -42,11 +46,15 @@ private:
     uint32_t     _windowHeight;
     PixelFormat  _format;
     std::string  _title;
+private:
+    bool              _fitToDisplay;
+    ScaleFilter       _scaleFilter;
+    FrameScaler::ptr  _scaler;       // 画面大于窗口时使用, 直接缩放至加锁的纹理内存
 private:
     SDL_Window*      _window;
     SDL_Renderer*    _render;       // render bind to window
     SDL_Texture*     _texture;      // texture bind to render, 目前格式固定为 ABGR8888 
-    uint32_t*        _frameBuffer;  // _frameBuffer "bind" to texture (格式固定为 ABGR8888)
+    uint32_t*        _frameBuffer;  // SDL_LockTexture 得到的纹理内存, 仅在 AcquireBuffer 与 Present 之间有效
     bool             _selfInit;
 };
 
@@ -0,0 +1,96 @@
+#include "DownscaleChain.h"
+
+#include <algorithm>
+
+#include "GPU/GL/GLDrawContex.h"
+#include "GPU/PG/Utility/CommonUtility.h"
+
+namespace Mmp
+{
+
+DownscaleChain::DownscaleChain(const PixelsInfo& info, uint32_t minSize)
+{
+    {
+        Level level;
+        level.info = info;
+        _levels.push_back(level);
+    }
+    PixelsInfo levelInfo = info;
+    while ((uint32_t)levelInfo.width / 2 >= minSize && (uint32_t)levelInfo.height / 2 >= minSize)
+    {
+        levelInfo = PixelsInfo(levelInfo.width / 2, levelInfo.height / 2, info.bitdepth, info.format);
+        Level level;
+        level.info    = levelInfo;
+        level.texture = Gpu::Create2DTextures(GLDrawContex::Instance(), levelInfo, "DownscaleLevel", GlTextureFlags::TEXTURE_USE_FOR_RENDER)[0];
+        _levels.push_back(level);
+    }
+}
+
+void DownscaleChain::Build(Texture::ptr source)
+{
+    _levels[0].texture = source;
+    for (size_t i=1; i<_levels.size(); i++)
+    {
+        // Hint : canvas 只是绘制时的工作面, 本级绘制完成后即释放, 同一时刻最多存在一张
+        Texture::ptr canvas = Gpu::Create2DTextures(GLDrawContex::Instance(), _levels[i].info, "DownscaleCanvas", GlTextureFlags::TEXTURE_USE_FOR_RENDER)[0];
+        Gpu::AbstractSceneLayer::ptr layer = Gpu::AbstractSceneLayer::Create();
+        Gpu::AbstractSceneItem::ptr item = Gpu::AbstractSceneItem::Create();
+        {
+            Gpu::SceneLayerParam param = {};
+            param.strategy = Gpu::SceneRenderStrategy::Keep;
+            layer->SetParam(param);
+            layer->UpdateCanvas(canvas);
+        }
+        {
+            Gpu::SceneItemParam param = {};
+            param.location = NormalizedPoint(0.0f, 0.0f);
+            param.area = NormalizedRect(1.0f, 1.0f);
+            item->SetParam(param);
+        }
+        item->UpdateImage(_levels[i-1].texture);
+        layer->AddSceneItem("downscale", item);
+        layer->Draw(_levels[i].texture);
+        layer->DelSceneItem("downscale");
+    }
+}
+
+size_t DownscaleChain::Select(uint32_t width, uint32_t height)
+{
+    size_t level = 0;
+    for (size_t i=1; i<_levels.size(); i++)
+    {
+        if ((uint32_t)_levels[i].info.width < width || (uint32_t)_levels[i].info.height < height)
+        {
+            break;
+        }
+        level = i;
+    }
+    return level;
+}
+
+size_t DownscaleChain::GetLevelCount()
+{
+    return _levels.size();
+}
+
+Texture::ptr DownscaleChain::GetLevel(size_t level)
+{
+    return _levels[std::min(level, _levels.size() - 1)].texture;
+}
+
+const PixelsInfo& DownscaleChain::GetLevelInfo(size_t level)
+{
+    return _levels[std::min(level, _levels.size() - 1)].info;
+}
+
+uint64_t DownscaleChain::GetResidentBytes()
+{
+    uint64_t bytes = 0;
+    for (size_t i=1; i<_levels.size(); i++)
+    {
+        bytes += (uint64_t)_levels[i].info.width * _levels[i].info.height * 4;
+    }
+    return bytes;
+}
+
+} // namespace Mmp
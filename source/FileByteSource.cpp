@@ -0,0 +1,49 @@
+#include "FileByteSource.h"
+
+namespace Mmp
+{
+
+FileByteSource::~FileByteSource()
+{
+    Close();
+}
+
+bool FileByteSource::Open(const std::string& url)
+{
+    std::string path = url.rfind("file://", 0) == 0 ? url.substr(7) : url;
+    _ifs.open(path, std::ios::in | std::ios::binary);
+    return _ifs.is_open();
+}
+
+void FileByteSource::Close()
+{
+    if (_ifs.is_open())
+    {
+        _ifs.close();
+    }
+}
+
+size_t FileByteSource::Read(void* data, size_t bytes)
+{
+    _ifs.read((char*)data, bytes);
+    return (size_t)_ifs.gcount();
+}
+
+bool FileByteSource::eof()
+{
+    return _ifs.eof();
+}
+
+bool FileByteSource::Seekable()
+{
+    return true;
+}
+
+bool FileByteSource::Seek(size_t offset)
+{
+    _ifs.clear();
+    _ifs.seekg(offset);
+    return !_ifs.fail();
+}
+
+} // namespace Mmp
@@ -0,0 +1,33 @@
+//
+// FileByteSource.h
+//
+// Library: Common
+// Package: Stream
+// Module:  ByteSource
+//
+
+#pragma once
+
+#include <fstream>
+
+#include "AbstractByteSource.h"
+
+namespace Mmp
+{
+
+class FileByteSource : public AbstractByteSource
+{
+public:
+    ~FileByteSource();
+public:
+    bool Open(const std::string& url) override;
+    void Close() override;
+    size_t Read(void* data, size_t bytes) override;
+    bool eof() override;
+    bool Seekable() override;
+    bool Seek(size_t offset) override;
+private:
+    std::ifstream _ifs;
+};
+
+} // namespace Mmp
@@ -0,0 +1,573 @@
+#include "FrameScaler.h"
+
+#include <cmath>
+#include <thread>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include "Common/LogMessage.h"
+#include "Common/NormalPicture.h"
+
+#include "WorkStealingPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MMP_SCALER_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MMP_SCALER_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Mmp
+{
+
+constexpr int32_t  kWeightBits      = 14;
+constexpr int32_t  kWeightOne       = 1 << kWeightBits;
+// Hint : 纵向结果保留 7 位小数, 最大 255 << 7 = 32640, 可以放进 int16, 横向累加不超过 int32
+constexpr int32_t  kVerticalShift   = 7;
+constexpr int32_t  kHorizontalShift = 2 * kWeightBits - kVerticalShift;
+constexpr uint32_t kMinRowsPerBand  = 16;
+// Hint : 单通道按 4 个系数一组, 双通道按 2 个系数 (4 个展开后的系数) 一组; 中间行末尾至少留出补零系数读到的范围
+constexpr uint32_t kSimdTapAlign[3] = {1, 4, 2};
+constexpr size_t   kRowPadding      = 8;
+
+static inline uint8_t ClampToByte(int32_t value)
+{
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+/**
+ * @brief 纵向: out[i] = sum(weight[t] * src[t * stride + i]) >> kVerticalShift
+ */
+static void VerticalPass(const uint8_t* src, int32_t stride, const int16_t* weight, uint32_t taps, uint32_t count, uint16_t* out)
+{
+    uint32_t i = 0;
+#if defined(MMP_SCALER_SSE2)
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(1 << (kVerticalShift - 1));
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i acc0 = zero, acc1 = zero, acc2 = zero, acc3 = zero;
+        const uint8_t* row = src + i;
+        for (uint32_t t = 0; t < taps; t++, row += stride)
+        {
+            __m128i w   = _mm_set1_epi16(weight[t]);
+            __m128i px  = _mm_loadu_si128((const __m128i*)row);
+            __m128i lo  = _mm_unpacklo_epi8(px, zero);
+            __m128i hi  = _mm_unpackhi_epi8(px, zero);
+            __m128i loL = _mm_mullo_epi16(lo, w);
+            __m128i loH = _mm_mulhi_epu16(lo, w);
+            __m128i hiL = _mm_mullo_epi16(hi, w);
+            __m128i hiH = _mm_mulhi_epu16(hi, w);
+            acc0 = _mm_add_epi32(acc0, _mm_unpacklo_epi16(loL, loH));
+            acc1 = _mm_add_epi32(acc1, _mm_unpackhi_epi16(loL, loH));
+            acc2 = _mm_add_epi32(acc2, _mm_unpacklo_epi16(hiL, hiH));
+            acc3 = _mm_add_epi32(acc3, _mm_unpackhi_epi16(hiL, hiH));
+        }
+        acc0 = _mm_srli_epi32(_mm_add_epi32(acc0, round), kVerticalShift);
+        acc1 = _mm_srli_epi32(_mm_add_epi32(acc1, round), kVerticalShift);
+        acc2 = _mm_srli_epi32(_mm_add_epi32(acc2, round), kVerticalShift);
+        acc3 = _mm_srli_epi32(_mm_add_epi32(acc3, round), kVerticalShift);
+        // Hint : 结果不超过 32640, 有符号饱和打包不会截断
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(acc0, acc1));
+        _mm_storeu_si128((__m128i*)(out + i + 8), _mm_packs_epi32(acc2, acc3));
+    }
+#elif defined(MMP_SCALER_NEON)
+    for (; i + 16 <= count; i += 16)
+    {
+        uint32x4_t acc0 = vdupq_n_u32(0), acc1 = vdupq_n_u32(0), acc2 = vdupq_n_u32(0), acc3 = vdupq_n_u32(0);
+        const uint8_t* row = src + i;
+        for (uint32_t t = 0; t < taps; t++, row += stride)
+        {
+            uint16_t   w  = (uint16_t)weight[t];
+            uint8x16_t px = vld1q_u8(row);
+            uint16x8_t lo = vmovl_u8(vget_low_u8(px));
+            uint16x8_t hi = vmovl_u8(vget_high_u8(px));
+            acc0 = vmlal_n_u16(acc0, vget_low_u16(lo), w);
+            acc1 = vmlal_n_u16(acc1, vget_high_u16(lo), w);
+            acc2 = vmlal_n_u16(acc2, vget_low_u16(hi), w);
+            acc3 = vmlal_n_u16(acc3, vget_high_u16(hi), w);
+        }
+        vst1q_u16(out + i, vcombine_u16(vrshrn_n_u32(acc0, kVerticalShift), vrshrn_n_u32(acc1, kVerticalShift)));
+        vst1q_u16(out + i + 8, vcombine_u16(vrshrn_n_u32(acc2, kVerticalShift), vrshrn_n_u32(acc3, kVerticalShift)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        int32_t sum = 1 << (kVerticalShift - 1);
+        const uint8_t* row = src + i;
+        for (uint32_t t = 0; t < taps; t++, row += stride)
+        {
+            sum += weight[t] * (*row);
+        }
+        out[i] = (uint16_t)(sum >> kVerticalShift);
+    }
+}
+
+#if defined(MMP_SCALER_SSE2)
+/**
+ * @brief 8 个 16 位数逐个相乘, 得到两组 4 个 32 位乘积 (输入与系数均不超过 32767, 按无符号相乘)
+ */
+static inline void MulWiden(__m128i px, __m128i w, __m128i& lo, __m128i& hi)
+{
+    __m128i l = _mm_mullo_epi16(px, w);
+    __m128i h = _mm_mulhi_epu16(px, w);
+    lo = _mm_unpacklo_epi16(l, h);
+    hi = _mm_unpackhi_epi16(l, h);
+}
+#endif
+
+/**
+ * @brief 横向单通道: 每次 4 个输出像素, 每个像素按 4 个系数一组累加, 返回已处理的像素数
+ */
+static size_t HorizontalPassC1(const uint16_t* in, const int32_t* offset, const int16_t* weight, uint32_t taps, size_t count, uint8_t* out)
+{
+    size_t x = 0;
+#if defined(MMP_SCALER_SSE2)
+    const __m128i round = _mm_set1_epi32(1 << (kHorizontalShift - 1));
+    for (; x + 4 <= count; x += 4, weight += 4 * taps, out += 4)
+    {
+        const uint16_t* px0 = in + offset[x];
+        const uint16_t* px1 = in + offset[x + 1];
+        const uint16_t* px2 = in + offset[x + 2];
+        const uint16_t* px3 = in + offset[x + 3];
+        // Hint : 输入不超过 32640, 系数不超过 16384, 按有符号 madd 不会溢出
+        __m128i acc01 = _mm_setzero_si128();
+        __m128i acc23 = _mm_setzero_si128();
+        for (uint32_t t = 0; t < taps; t += 4)
+        {
+            __m128i v01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(px0 + t)), _mm_loadl_epi64((const __m128i*)(px1 + t)));
+            __m128i v23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(px2 + t)), _mm_loadl_epi64((const __m128i*)(px3 + t)));
+            __m128i w01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(weight + t)), _mm_loadl_epi64((const __m128i*)(weight + taps + t)));
+            __m128i w23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(weight + 2 * taps + t)), _mm_loadl_epi64((const __m128i*)(weight + 3 * taps + t)));
+            acc01 = _mm_add_epi32(acc01, _mm_madd_epi16(v01, w01));
+            acc23 = _mm_add_epi32(acc23, _mm_madd_epi16(v23, w23));
+        }
+        // Hint : acc01 为 [p0a p0b p1a p1b], 整理为 [p0a p1a p2a p3a] + [p0b p1b p2b p3b]
+        __m128i s01 = _mm_shuffle_epi32(acc01, _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i s23 = _mm_shuffle_epi32(acc23, _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i acc = _mm_add_epi32(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23));
+        acc = _mm_srai_epi32(_mm_add_epi32(acc, round), kHorizontalShift);
+        acc = _mm_packs_epi32(acc, acc);
+        int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(acc, acc));
+        memcpy(out, &packed, 4);
+    }
+#elif defined(MMP_SCALER_NEON)
+    for (; x + 4 <= count; x += 4, weight += 4 * taps, out += 4)
+    {
+        const uint16_t* px0 = in + offset[x];
+        const uint16_t* px1 = in + offset[x + 1];
+        const uint16_t* px2 = in + offset[x + 2];
+        const uint16_t* px3 = in + offset[x + 3];
+        const uint16_t* w = (const uint16_t*)weight;
+        uint32x4_t acc0 = vdupq_n_u32(0), acc1 = vdupq_n_u32(0), acc2 = vdupq_n_u32(0), acc3 = vdupq_n_u32(0);
+        for (uint32_t t = 0; t < taps; t += 4)
+        {
+            acc0 = vmlal_u16(acc0, vld1_u16(px0 + t), vld1_u16(w + t));
+            acc1 = vmlal_u16(acc1, vld1_u16(px1 + t), vld1_u16(w + taps + t));
+            acc2 = vmlal_u16(acc2, vld1_u16(px2 + t), vld1_u16(w + 2 * taps + t));
+            acc3 = vmlal_u16(acc3, vld1_u16(px3 + t), vld1_u16(w + 3 * taps + t));
+        }
+        uint32x2_t s01 = vpadd_u32(vadd_u32(vget_low_u32(acc0), vget_high_u32(acc0)), vadd_u32(vget_low_u32(acc1), vget_high_u32(acc1)));
+        uint32x2_t s23 = vpadd_u32(vadd_u32(vget_low_u32(acc2), vget_high_u32(acc2)), vadd_u32(vget_low_u32(acc3), vget_high_u32(acc3)));
+        uint16x4_t v16 = vqmovn_u32(vrshrq_n_u32(vcombine_u32(s01, s23), kHorizontalShift));
+        uint8x8_t  v8  = vqmovn_u16(vcombine_u16(v16, v16));
+        vst1_lane_u32((uint32_t*)(void*)out, vreinterpret_u32_u8(v8), 0);
+    }
+#else
+    (void)in; (void)offset; (void)weight; (void)taps; (void)count; (void)out;
+#endif
+    return x;
+}
+
+/**
+ * @brief 横向双通道 (交错的 UV): 每次 2 个输出像素, 系数已按通道展开, 每组 2 个系数 (4 个 16 位数), 返回已处理的像素数
+ */
+static size_t HorizontalPassC2(const uint16_t* in, const int32_t* offset, const int16_t* weight, uint32_t taps, size_t count, uint8_t* out)
+{
+    size_t x = 0;
+    uint32_t lanes = taps * 2;
+#if defined(MMP_SCALER_SSE2)
+    const __m128i round = _mm_set1_epi32(1 << (kHorizontalShift - 1));
+    for (; x + 2 <= count; x += 2, weight += 2 * lanes, out += 4)
+    {
+        const uint16_t* px0 = in + (size_t)offset[x] * 2;
+        const uint16_t* px1 = in + (size_t)offset[x + 1] * 2;
+        __m128i acc0 = _mm_setzero_si128();
+        __m128i acc1 = _mm_setzero_si128();
+        for (uint32_t i = 0; i < lanes; i += 4)
+        {
+            __m128i v  = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(px0 + i)), _mm_loadl_epi64((const __m128i*)(px1 + i)));
+            __m128i w  = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(weight + i)), _mm_loadl_epi64((const __m128i*)(weight + lanes + i)));
+            __m128i lo, hi;
+            MulWiden(v, w, lo, hi);
+            acc0 = _mm_add_epi32(acc0, lo);
+            acc1 = _mm_add_epi32(acc1, hi);
+        }
+        // Hint : acc 为 [u v u v], 高低 64 位相加得到 [U V]
+        acc0 = _mm_add_epi32(acc0, _mm_srli_si128(acc0, 8));
+        acc1 = _mm_add_epi32(acc1, _mm_srli_si128(acc1, 8));
+        __m128i acc = _mm_unpacklo_epi64(acc0, acc1);
+        acc = _mm_srai_epi32(_mm_add_epi32(acc, round), kHorizontalShift);
+        acc = _mm_packs_epi32(acc, acc);
+        int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(acc, acc));
+        memcpy(out, &packed, 4);
+    }
+#elif defined(MMP_SCALER_NEON)
+    for (; x + 2 <= count; x += 2, weight += 2 * lanes, out += 4)
+    {
+        const uint16_t* px0 = in + (size_t)offset[x] * 2;
+        const uint16_t* px1 = in + (size_t)offset[x + 1] * 2;
+        const uint16_t* w = (const uint16_t*)weight;
+        uint32x4_t acc0 = vdupq_n_u32(0), acc1 = vdupq_n_u32(0);
+        for (uint32_t i = 0; i < lanes; i += 4)
+        {
+            acc0 = vmlal_u16(acc0, vld1_u16(px0 + i), vld1_u16(w + i));
+            acc1 = vmlal_u16(acc1, vld1_u16(px1 + i), vld1_u16(w + lanes + i));
+        }
+        uint32x2_t s0 = vadd_u32(vget_low_u32(acc0), vget_high_u32(acc0));
+        uint32x2_t s1 = vadd_u32(vget_low_u32(acc1), vget_high_u32(acc1));
+        uint16x4_t v16 = vqmovn_u32(vrshrq_n_u32(vcombine_u32(s0, s1), kHorizontalShift));
+        uint8x8_t  v8  = vqmovn_u16(vcombine_u16(v16, v16));
+        vst1_lane_u32((uint32_t*)(void*)out, vreinterpret_u32_u8(v8), 0);
+    }
+#else
+    (void)in; (void)offset; (void)weight; (void)lanes; (void)count; (void)out;
+#endif
+    return x;
+}
+
+/**
+ * @brief 横向: 每个输出像素取 taps 个相邻输入像素加权, 四通道时每个像素一次处理 4 个通道,
+ *        单/双通道使用补零展开后的系数一次处理多个像素, 剩余像素逐个计算
+ */
+static void HorizontalPass(const uint16_t* in, const std::vector<int32_t>& offset, const int16_t* weight, uint32_t taps,
+                           const int16_t* simdWeight, uint32_t simdTaps, uint32_t channels, uint8_t* out)
+{
+    size_t count = offset.size();
+    size_t done = 0;
+    if (channels == 1)
+    {
+        done = HorizontalPassC1(in, offset.data(), simdWeight, simdTaps, count, out);
+    }
+    else if (channels == 2)
+    {
+        done = HorizontalPassC2(in, offset.data(), simdWeight, simdTaps, count, out);
+    }
+    weight += done * taps;
+    out    += done * channels;
+#if defined(MMP_SCALER_SSE2)
+    if (channels == 4)
+    {
+        const __m128i zero  = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi32(1 << (kHorizontalShift - 1));
+        for (size_t x = 0; x < count; x++, weight += taps, out += 4)
+        {
+            const uint16_t* px = in + (size_t)offset[x] * 4;
+            __m128i acc = round;
+            for (uint32_t t = 0; t < taps; t++, px += 4)
+            {
+                // Hint : 与 0 交错后 madd 即为 32 位的 px * w
+                __m128i v = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)px), zero);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(v, _mm_set1_epi32((uint16_t)weight[t])));
+            }
+            acc = _mm_srai_epi32(acc, kHorizontalShift);
+            acc = _mm_packs_epi32(acc, acc);
+            int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(acc, acc));
+            memcpy(out, &packed, 4);
+        }
+        return;
+    }
+#elif defined(MMP_SCALER_NEON)
+    if (channels == 4)
+    {
+        for (size_t x = 0; x < count; x++, weight += taps, out += 4)
+        {
+            const uint16_t* px = in + (size_t)offset[x] * 4;
+            uint32x4_t acc = vdupq_n_u32(0);
+            for (uint32_t t = 0; t < taps; t++, px += 4)
+            {
+                acc = vmlal_n_u16(acc, vld1_u16(px), (uint16_t)weight[t]);
+            }
+            uint16x4_t v16 = vqmovn_u32(vrshrq_n_u32(acc, kHorizontalShift));
+            uint8x8_t  v8  = vqmovn_u16(vcombine_u16(v16, v16));
+            vst1_lane_u32((uint32_t*)(void*)out, vreinterpret_u32_u8(v8), 0);
+        }
+        return;
+    }
+#endif
+    for (size_t x = done; x < count; x++, weight += taps)
+    {
+        const uint16_t* px = in + (size_t)offset[x] * channels;
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            int32_t sum = 1 << (kHorizontalShift - 1);
+            for (uint32_t t = 0; t < taps; t++)
+            {
+                sum += weight[t] * px[t * channels + c];
+            }
+            *out++ = ClampToByte(sum >> kHorizontalShift);
+        }
+    }
+}
+
+PixelsInfo FitToDisplay(const PixelsInfo& info, uint32_t maxWidth, uint32_t maxHeight)
+{
+    if (maxWidth == 0 || maxHeight == 0 || ((uint32_t)info.width <= maxWidth && (uint32_t)info.height <= maxHeight))
+    {
+        return info;
+    }
+    double scale = std::min((double)maxWidth / info.width, (double)maxHeight / info.height);
+    PixelsInfo fit = info;
+    fit.width     = std::max((int32_t)(info.width * scale) & ~1, 2);
+    fit.height    = std::max((int32_t)(info.height * scale) & ~1, 2);
+    fit.horStride = fit.width;
+    fit.virStride = fit.height;
+    return fit;
+}
+
+bool FrameScaler::IsSupported(PixelFormat format)
+{
+    return format == PixelFormat::RGBA8888 || format == PixelFormat::BGRA8888 || format == PixelFormat::NV12 || format == PixelFormat::YUV420P;
+}
+
+bool FrameScaler::IsValid()
+{
+    return _valid;
+}
+
+FrameScaler::FrameScaler(const PixelsInfo& src, const PixelsInfo& dst, ScaleFilter filter, uint32_t bands)
+{
+    _srcInfo = src;
+    _dstInfo = dst;
+    _filter  = filter;
+    _valid   = IsSupported(src.format) && src.format == dst.format && src.width >= 2 && src.height >= 2 && dst.width >= 2 && dst.height >= 2;
+    if (!_valid)
+    {
+        MMP_LOG_ERROR << "FrameScaler unsupported, src is (" << src.width << "x" << src.height << ", " << src.format
+                      << "), dst is (" << dst.width << "x" << dst.height << ", " << dst.format << ")";
+        return;
+    }
+    auto addPlane = [this](uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight, uint32_t channels)
+    {
+        Plane plane;
+        plane.srcWidth  = srcWidth;
+        plane.srcHeight = srcHeight;
+        plane.dstWidth  = dstWidth;
+        plane.dstHeight = dstHeight;
+        plane.channels  = channels;
+        BuildTable(plane.horizontal, srcWidth, dstWidth, _filter);
+        BuildTable(plane.vertical, srcHeight, dstHeight, _filter);
+        BuildSimdTable(plane.horizontal, channels);
+        _planes.push_back(plane);
+    };
+    uint32_t sw = src.width, sh = src.height, dw = dst.width, dh = dst.height;
+    switch (src.format)
+    {
+        case PixelFormat::RGBA8888:
+        case PixelFormat::BGRA8888:
+        {
+            addPlane(sw, sh, dw, dh, 4);
+            break;
+        }
+        case PixelFormat::NV12:
+        {
+            addPlane(sw, sh, dw, dh, 1);
+            addPlane(sw / 2, sh / 2, dw / 2, dh / 2, 2);
+            break;
+        }
+        case PixelFormat::YUV420P:
+        {
+            addPlane(sw, sh, dw, dh, 1);
+            addPlane(sw / 2, sh / 2, dw / 2, dh / 2, 1);
+            addPlane(sw / 2, sh / 2, dw / 2, dh / 2, 1);
+            break;
+        }
+        default:
+            break;
+    }
+    if (bands == 0)
+    {
+        bands = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    bands = std::max(std::min(bands, dh / kMinRowsPerBand), 1u);
+    size_t rowSize = 0;
+    for (const auto& plane : _planes)
+    {
+        rowSize = std::max(rowSize, (size_t)plane.srcWidth * plane.channels);
+    }
+    // Hint : 补零系数会读到行尾之后 (最多 3 个像素), 值乘以 0 不影响结果, 只需保证可读
+    rowSize += kRowPadding;
+    _rowBuffers.resize(bands, std::vector<uint16_t>(rowSize));
+}
+
+void FrameScaler::BuildTable(FilterTable& table, uint32_t srcSize, uint32_t dstSize, ScaleFilter filter)
+{
+    assert(srcSize > 0 && dstSize > 0);
+    double scale = (double)srcSize / dstSize;
+    uint32_t taps = filter == ScaleFilter::AREA ? (uint32_t)std::ceil(scale) + 1 : 2;
+    taps = std::min(taps, srcSize);
+    table.taps = taps;
+    table.offset.resize(dstSize);
+    table.weight.resize((size_t)dstSize * taps);
+    std::vector<double> weights(taps);
+    for (uint32_t i = 0; i < dstSize; i++)
+    {
+        std::fill(weights.begin(), weights.end(), 0.0);
+        int32_t first = 0;
+        if (filter == ScaleFilter::AREA)
+        {
+            double begin = i * scale;
+            double end   = begin + scale;
+            first = std::min((int32_t)std::floor(begin), (int32_t)(srcSize - taps));
+            for (uint32_t t = 0; t < taps; t++)
+            {
+                double s = first + t;
+                weights[t] = std::max(0.0, std::min(end, s + 1) - std::max(begin, s));
+            }
+        }
+        else
+        {
+            double center = (i + 0.5) * scale - 0.5;
+            int32_t left  = (int32_t)std::floor(center);
+            double frac   = center - left;
+            first = std::max(0, std::min(left, (int32_t)(srcSize - taps)));
+            // Hint : 越界的一侧并入边缘像素
+            auto index = [&](int32_t s) -> size_t
+            {
+                s = std::max(0, std::min(s, (int32_t)srcSize - 1));
+                return (size_t)std::min(std::max(s - first, 0), (int32_t)taps - 1);
+            };
+            weights[index(left)]     += 1.0 - frac;
+            weights[index(left + 1)] += frac;
+        }
+        double total = 0;
+        for (double weight : weights)
+        {
+            total += weight;
+        }
+        if (total <= 0)
+        {
+            weights[0] = total = 1.0;
+        }
+        // Hint : 量化误差补到最大的系数上, 保证每组之和严格为 1 << 14, 纯色画面缩放后不偏色
+        int16_t* quantized = table.weight.data() + (size_t)i * taps;
+        int32_t sum = 0;
+        uint32_t largest = 0;
+        for (uint32_t t = 0; t < taps; t++)
+        {
+            quantized[t] = (int16_t)std::lround(weights[t] / total * kWeightOne);
+            sum += quantized[t];
+            largest = quantized[t] > quantized[largest] ? t : largest;
+        }
+        quantized[largest] = (int16_t)(quantized[largest] + kWeightOne - sum);
+        table.offset[i] = first;
+    }
+}
+
+void FrameScaler::BuildSimdTable(FilterTable& table, uint32_t channels)
+{
+    table.simdTaps = 0;
+    table.simdWeight.clear();
+    if (channels != 1 && channels != 2)
+    {
+        return;
+    }
+    uint32_t align = kSimdTapAlign[channels];
+    uint32_t simdTaps = (table.taps + align - 1) / align * align;
+    size_t count = table.offset.size();
+    table.simdTaps = simdTaps;
+    table.simdWeight.assign(count * simdTaps * channels, 0);
+    for (size_t x = 0; x < count; x++)
+    {
+        for (uint32_t t = 0; t < table.taps; t++)
+        {
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                table.simdWeight[(x * simdTaps + t) * channels + c] = table.weight[x * table.taps + t];
+            }
+        }
+    }
+}
+
+void FrameScaler::ScaleRows(size_t band, const uint8_t* const src[3], const int32_t srcStride[3], uint8_t* const dst[3], const int32_t dstStride[3])
+{
+    size_t bands = _rowBuffers.size();
+    uint16_t* row = _rowBuffers[band].data();
+    for (size_t i = 0; i < _planes.size(); i++)
+    {
+        const Plane& plane = _planes[i];
+        uint32_t rowBegin = (uint32_t)((uint64_t)plane.dstHeight * band / bands);
+        uint32_t rowEnd   = (uint32_t)((uint64_t)plane.dstHeight * (band + 1) / bands);
+        uint32_t taps     = plane.vertical.taps;
+        for (uint32_t y = rowBegin; y < rowEnd; y++)
+        {
+            const uint8_t* srcRow = src[i] + (size_t)plane.vertical.offset[y] * srcStride[i];
+            VerticalPass(srcRow, srcStride[i], plane.vertical.weight.data() + (size_t)y * taps, taps, plane.srcWidth * plane.channels, row);
+            HorizontalPass(row, plane.horizontal.offset, plane.horizontal.weight.data(), plane.horizontal.taps,
+                           plane.horizontal.simdWeight.data(), plane.horizontal.simdTaps, plane.channels, dst[i] + (size_t)y * dstStride[i]);
+        }
+    }
+}
+
+void FrameScaler::Scale(const uint8_t* const src[3], const int32_t srcStride[3], uint8_t* const dst[3], const int32_t dstStride[3])
+{
+    size_t bands = _rowBuffers.size();
+    if (!_valid)
+    {
+        return;
+    }
+    if (bands == 1)
+    {
+        ScaleRows(0, src, srcStride, dst, dstStride);
+        return;
+    }
+    // Hint : 第一段在当前线程处理; 缩放在显示路径上, 以 REALTIME 优先级提交
+    WorkStealingPool::Instance().ParallelFor(bands, [&](size_t band)
+    {
+        ScaleRows(band, src, srcStride, dst, dstStride);
+    }, TaskPriority::REALTIME);
+}
+
+AbstractPicture::ptr FrameScaler::Scale(AbstractPicture::ptr src, AbstractPicture::ptr dst)
+{
+    if (!_valid)
+    {
+        return nullptr;
+    }
+    if (!dst)
+    {
+        dst = std::make_shared<NormalPicture>(_dstInfo);
+    }
+    auto tightPlanes = [](const PixelsInfo& info, uint8_t* data, uint8_t* planes[3], int32_t strides[3])
+    {
+        size_t lumaSize = (size_t)info.width * info.height;
+        planes[0] = data;
+        strides[0] = info.format == PixelFormat::RGBA8888 || info.format == PixelFormat::BGRA8888 ? info.width * 4 : info.width;
+        planes[1] = data + lumaSize;
+        strides[1] = info.format == PixelFormat::NV12 ? info.width : info.width / 2;
+        planes[2] = data + lumaSize + lumaSize / 4;
+        strides[2] = info.width / 2;
+    };
+    uint8_t* srcPlanes[3];
+    uint8_t* dstPlanes[3];
+    int32_t srcStrides[3];
+    int32_t dstStrides[3];
+    tightPlanes(_srcInfo, (uint8_t*)src->GetData(), srcPlanes, srcStrides);
+    tightPlanes(_dstInfo, (uint8_t*)dst->GetData(), dstPlanes, dstStrides);
+    Scale(srcPlanes, srcStrides, dstPlanes, dstStrides);
+    return dst;
+}
+
+const PixelsInfo& FrameScaler::GetSrcInfo()
+{
+    return _srcInfo;
+}
+
+const PixelsInfo& FrameScaler::GetDstInfo()
+{
+    return _dstInfo;
+}
+
+} // namespace Mmp
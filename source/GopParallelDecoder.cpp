@@ -0,0 +1,190 @@
+#include "GopParallelDecoder.h"
+
+#include <fstream>
+#include <algorithm>
+
+#include "Common/LogMessage.h"
+
+namespace Mmp
+{
+
+GopParallelDecoder::GopParallelDecoder(const std::string& decoderClassName, Codec::CodecType codecType, size_t workers)
+{
+    _decoderClassName   = decoderClassName;
+    _codecType          = codecType;
+    _workers            = std::max<size_t>(workers, 1);
+    _maxPendingSegments = _workers * 2;
+    _frameTimeoutMs     = 2000;
+    _nextSegment        = 0;
+    _nextOutput         = 0;
+    _abort              = false;
+}
+
+GopParallelDecoder::~GopParallelDecoder()
+{
+}
+
+void GopParallelDecoder::SetMaxPendingSegments(size_t segments)
+{
+    _maxPendingSegments = std::max(segments, _workers);
+}
+
+void GopParallelDecoder::SetFrameTimeout(uint32_t ms)
+{
+    _frameTimeoutMs = ms;
+}
+
+uint64_t GopParallelDecoder::Run(const std::string& path, const FrameCallback& callback)
+{
+    AnnexBIndex index(_codecType);
+    if (!index.LoadOrBuild(path))
+    {
+        MMP_LOG_ERROR << "GopParallelDecoder build index fail, path is: " << path;
+        return 0;
+    }
+    uint64_t fileSize = 0;
+    {
+        std::ifstream ifs(path, std::ios::in | std::ios::binary | std::ios::ate);
+        fileSize = (uint64_t)ifs.tellg();
+    }
+    const std::vector<AnnexBIndex::Entry>& entries = index.GetEntries();
+    _segments.clear();
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        Segment segment;
+        segment.begin  = entries[i].offset;
+        segment.end    = i + 1 < entries.size() ? entries[i + 1].offset : fileSize;
+        segment.frames = (i + 1 < entries.size() ? entries[i + 1].frame : index.GetFrameCount()) - entries[i].frame;
+        segment.parameterSets = entries[i].parameterSets;
+        _segments.push_back(segment);
+    }
+    _nextSegment = 0;
+    _nextOutput  = 0;
+    _abort       = false;
+    _reorder.clear();
+
+    size_t workers = std::min(_workers, _segments.size());
+    MMP_LOG_INFO << "GopParallelDecoder segments : " << _segments.size() << ", workers : " << workers;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workers; i++)
+    {
+        threads.emplace_back(&GopParallelDecoder::WorkerProc, this, i, path);
+    }
+
+    uint64_t outputFrames = 0;
+    while (true)
+    {
+        std::vector<AbstractFrame::ptr> frames;
+        {
+            std::unique_lock<std::mutex> lock(_mtx);
+            _cond.wait(lock, [this]() { return _abort || _nextOutput >= _segments.size() || _reorder.count(_nextOutput); });
+            if (_abort || _nextOutput >= _segments.size())
+            {
+                break;
+            }
+            frames.swap(_reorder[_nextOutput]);
+            _reorder.erase(_nextOutput);
+            _nextOutput++;
+            _cond.notify_all();
+        }
+        for (auto& frame : frames)
+        {
+            callback(frame);
+            outputFrames++;
+        }
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    if (_abort)
+    {
+        MMP_LOG_ERROR << "GopParallelDecoder abort, output frames : " << outputFrames;
+        return 0;
+    }
+    return outputFrames;
+}
+
+void GopParallelDecoder::DecodeSegment(Codec::AbstractDecoder::ptr decoder, H26XFileByteReader& reader, size_t index, std::vector<AbstractFrame::ptr>& frames)
+{
+    const Segment& segment = _segments[index];
+    auto popAll = [&]()
+    {
+        AbstractFrame::ptr frame;
+        while (decoder->Pop(frame))
+        {
+            frames.push_back(frame);
+        }
+    };
+    // Hint : 参数集只在文件开头出现时, 每段先送入 IDR 之前最近的参数集
+    Codec::StreamPack::ptr pack;
+    for (const auto& offset : segment.parameterSets)
+    {
+        reader.Seek((size_t)offset);
+        if ((pack = reader.GetNalUint()))
+        {
+            decoder->Push(pack);
+        }
+    }
+    reader.Seek((size_t)segment.begin);
+    while ((pack = reader.GetNalUint()) && reader.GetLastNalOffset() < segment.end)
+    {
+        decoder->Push(pack);
+        popAll();
+    }
+    // Hint : 解码器为重排保留的尾部帧需要结束标记才会输出
+    uint64_t expectFrames = segment.frames > frames.size() ? segment.frames - frames.size() : 0;
+    FlushDecoder(decoder, _codecType, expectFrames, _frameTimeoutMs, [&](AbstractFrame::ptr frame)
+    {
+        frames.push_back(frame);
+    });
+    if (frames.size() != segment.frames)
+    {
+        MMP_LOG_WARN << "GopParallelDecoder segment " << index << " expect " << segment.frames << " frames, got " << frames.size();
+    }
+}
+
+void GopParallelDecoder::WorkerProc(size_t id, const std::string& path)
+{
+    Codec::AbstractDecoder::ptr decoder = Codec::DecoderFactory::DefaultFactory().CreateDecoder(_decoderClassName);
+    if (!decoder)
+    {
+        MMP_LOG_ERROR << "GopParallelDecoder create decoder fail, name is: " << _decoderClassName;
+        std::lock_guard<std::mutex> lock(_mtx);
+        _abort = true;
+        _cond.notify_all();
+        return;
+    }
+    H26XFileByteReader reader(path, _codecType);
+    decoder->Init();
+    decoder->Start();
+    while (true)
+    {
+        size_t index = _nextSegment.fetch_add(1);
+        if (index >= _segments.size())
+        {
+            break;
+        }
+        {
+            std::unique_lock<std::mutex> lock(_mtx);
+            _cond.wait(lock, [&]() { return _abort || index < _nextOutput + _maxPendingSegments; });
+            if (_abort)
+            {
+                break;
+            }
+        }
+        std::vector<AbstractFrame::ptr> frames;
+        frames.reserve((size_t)_segments[index].frames);
+        DecodeSegment(decoder, reader, index, frames);
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _reorder[index].swap(frames);
+            _cond.notify_all();
+        }
+    }
+    decoder->Stop();
+    decoder->Uninit();
+    MMP_LOG_INFO << "GopParallelDecoder worker " << id << " exit";
+}
+
+} // namespace Mmp
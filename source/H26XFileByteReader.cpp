@@ -0,0 +1,182 @@
+#include "H26XFileByteReader.h"
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include "Common/LogMessage.h"
+#include "Common/ImmutableVectorAllocateMethod.h"
+
+#include "AnnexBIndex.h"
+
+namespace Mmp
+{
+
+constexpr uint32_t kBufSize = 1024 * 1024;
+constexpr uint32_t kKeepBytes = 4;
+
+Codec::StreamPack::ptr H26XFileByteReader::GetNalUint()
+{
+    std::vector<uint8_t>& bufs = _scratch;
+    bufs.clear();
+    uint32_t next_24_bits = 0;
+    bool isFirst = true;
+    size_t nalOffset = Tell();
+    while (!(next_24_bits == 0x000001 && !isFirst))
+    {
+        if (next_24_bits == 0x000001)
+        {
+            isFirst = false;
+            nalOffset = Tell() - 3;
+            bufs.push_back(0);
+            bufs.push_back(0);
+            bufs.push_back(0);
+            bufs.push_back(1);
+        }
+        uint8_t byte = 0;
+        if (Read(&byte, 1) != 1 && eof())
+        {
+            return nullptr;
+        }
+        if (!isFirst)
+        {
+            bufs.push_back(byte);
+        }
+        next_24_bits = (next_24_bits << 8) | byte;
+        next_24_bits = next_24_bits & 0xFFFFFF;
+    }
+    Seek(Tell() - 3);
+    if (bufs.size() >= 3)
+    {
+        bufs.resize(bufs.size() - 3);
+        if (!bufs.empty() && bufs[bufs.size()-1] == 0)
+        {
+            bufs.pop_back();
+        }
+    }
+    std::shared_ptr<ImmutableVectorAllocateMethod<uint8_t>> alloc = std::make_shared<ImmutableVectorAllocateMethod<uint8_t>>();
+    // Hint : 将组帧缓冲直接交给 pack, 不再逐字节拷贝; 按本次容量重新预留, 下一个 NAL 组帧时不再逐步扩容
+    size_t capacity = bufs.capacity();
+    alloc->container.swap(bufs);
+    bufs.reserve(capacity);
+    _lastNalOffset = nalOffset;
+    return std::make_shared<Codec::StreamPack>(_codecType, alloc->container.size(), alloc);
+}
+
+Codec::StreamPack::ptr H26XFileByteReader::GetPacket()
+{
+    return GetNalUint();
+}
+
+Codec::CodecType H26XFileByteReader::GetCodecType()
+{
+    return _codecType;
+}
+
+bool H26XFileByteReader::IsPictureStart(const Codec::StreamPack::ptr& pack)
+{
+    return pack && AnnexBIndex::IsFirstSliceOfPicture(_codecType, (const uint8_t*)pack->GetData(), pack->GetSize());
+}
+
+size_t H26XFileByteReader::GetLastNalOffset()
+{
+    return _lastNalOffset;
+}
+
+H26XFileByteReader::H26XFileByteReader(const std::string& path, Codec::CodecType codecType)
+    : H26XFileByteReader(AbstractByteSource::Create(path), codecType)
+{
+}
+
+H26XFileByteReader::H26XFileByteReader(AbstractByteSource::ptr source, Codec::CodecType codecType)
+{
+    _source = source;
+    _codecType = codecType;
+    _lastNalOffset = 0;
+    _buf = new uint8_t[kBufSize];
+    _offset = 0;
+    _cur = 0;
+    _len = 0;
+    if (!_source)
+    {
+        MMP_LOG_ERROR << "H26XFileByteReader has no valid byte source";
+    }
+}
+
+H26XFileByteReader::~H26XFileByteReader()
+{
+    delete[] _buf;
+    if (_source)
+    {
+        _source->Close();
+    }
+}
+
+bool H26XFileByteReader::IsOpen()
+{
+    return _source != nullptr;
+}
+
+bool H26XFileByteReader::Fill()
+{
+    if (!_source)
+    {
+        return false;
+    }
+    // Hint : 保留缓冲末尾几个字节, 使起始码跨越缓冲边界时 GetNalUint 仍可回退, 对不可 Seek 的输入源同样有效
+    uint32_t keep = std::min(_len, kKeepBytes);
+    memmove(_buf, _buf + _len - keep, keep);
+    _offset += _len - keep;
+    _cur = keep;
+    _len = keep + (uint32_t)_source->Read(_buf + keep, kBufSize - keep);
+    return _len > _cur;
+}
+
+size_t H26XFileByteReader::Read(void* data, size_t bytes)
+{
+    size_t done = 0;
+    while (done < bytes)
+    {
+        if (_cur == _len && !Fill())
+        {
+            break;
+        }
+        size_t n = std::min(bytes - done, (size_t)(_len - _cur));
+        memcpy((uint8_t*)data + done, _buf + _cur, n);
+        _cur += (uint32_t)n;
+        done += n;
+    }
+    return done;
+}
+
+bool H26XFileByteReader::Seek(size_t offset)
+{
+    if (offset >= _offset && offset <= _offset + _len)
+    {
+        _cur = (uint32_t)(offset - _offset);
+        return true;
+    }
+    else if (_source && _source->Seekable() && _source->Seek(offset))
+    {
+        _offset = offset;
+        _cur = 0;
+        _len = 0;
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+size_t H26XFileByteReader::Tell()
+{
+    return _offset + _cur;
+}
+
+bool H26XFileByteReader::eof()
+{
+    return _cur == _len && (!_source || _source->eof());
+}
+
+} // namespace Mmp
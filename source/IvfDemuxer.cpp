@@ -0,0 +1,222 @@
+#include "IvfDemuxer.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "Common/LogMessage.h"
+
+namespace Mmp
+{
+
+constexpr char     kIvfMagic[4]         = {'D', 'K', 'I', 'F'};
+constexpr size_t   kIvfHeaderSize       = 32;
+constexpr size_t   kIvfFrameHeaderSize  = 12;
+constexpr uint32_t kAv1ObuSequenceHeader = 1;
+
+static uint16_t Get16(const uint8_t* data)
+{
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+static uint32_t Get32(const uint8_t* data)
+{
+    return (uint32_t)Get16(data) | ((uint32_t)Get16(data + 2) << 16);
+}
+
+IvfDemuxer::IvfDemuxer()
+{
+    _codecType = Codec::CodecType::VP9;
+    _width = 0;
+    _height = 0;
+    _cur = 0;
+}
+
+bool IvfDemuxer::Open(const std::string& path)
+{
+    MappedFile::ptr file = std::make_shared<MappedFile>();
+    if (!file->Open(path))
+    {
+        MMP_LOG_ERROR << "Open ivf fail, path is: " << path;
+        return false;
+    }
+    const uint8_t* data = file->GetData();
+    size_t size = file->GetSize();
+    if (size < kIvfHeaderSize || memcmp(data, kIvfMagic, 4) != 0)
+    {
+        MMP_LOG_ERROR << "Not an ivf file, path is: " << path;
+        return false;
+    }
+    size_t headerSize = Get16(data + 6);
+    if (memcmp(data + 8, "VP80", 4) == 0)
+    {
+        _codecType = Codec::CodecType::VP8;
+    }
+    else if (memcmp(data + 8, "VP90", 4) == 0)
+    {
+        _codecType = Codec::CodecType::VP9;
+    }
+    else if (memcmp(data + 8, "AV01", 4) == 0)
+    {
+        _codecType = Codec::CodecType::AV1;
+    }
+    else
+    {
+        MMP_LOG_ERROR << "Unsupport ivf fourcc: " << std::string((const char*)data + 8, 4);
+        return false;
+    }
+    _width = Get16(data + 12);
+    _height = Get16(data + 14);
+    std::vector<Frame> frames;
+    // Hint : 头中的帧数不可信, 每帧至少占一个帧头
+    frames.reserve(std::min<uint64_t>(Get32(data + 24), size / kIvfFrameHeaderSize));
+    size_t pos = std::max(headerSize, kIvfHeaderSize);
+    while (pos + kIvfFrameHeaderSize <= size)
+    {
+        Frame frame;
+        frame.size = Get32(data + pos);
+        frame.offset = pos + kIvfFrameHeaderSize;
+        if (frame.offset + frame.size > size)
+        {
+            MMP_LOG_WARN << "Truncated ivf frame " << frames.size() << ", offset : " << frame.offset << ", size : " << frame.size;
+            break;
+        }
+        frame.keyFrame = IsKeyFrame(_codecType, data + frame.offset, frame.size);
+        frames.push_back(frame);
+        pos = frame.offset + frame.size;
+    }
+    _frames.swap(frames);
+    _cur = 0;
+    _file = file;
+    _file->Sequential();
+    MMP_LOG_INFO << "IvfDemuxer open " << path << ", " << _width << "x" << _height << ", " << _frames.size() << " frames";
+    return true;
+}
+
+bool IvfDemuxer::IsKeyFrame(Codec::CodecType codecType, const uint8_t* data, size_t size)
+{
+    if (size == 0)
+    {
+        return false;
+    }
+    if (codecType == Codec::CodecType::VP8)
+    {
+        // Hint : frame tag 第 0 位, 0 表示关键帧
+        return (data[0] & 0x01) == 0;
+    }
+    else if (codecType == Codec::CodecType::VP9)
+    {
+        // Hint : frame_marker (2), profile_low_bit, profile_high_bit, [reserved_zero], show_existing_frame, frame_type
+        if (((data[0] >> 6) & 0x03) != 0x02)
+        {
+            return false;
+        }
+        uint32_t profile = ((data[0] >> 5) & 0x01) | (((data[0] >> 4) & 0x01) << 1);
+        uint32_t bit = profile == 3 ? 2 : 3;
+        if ((data[0] >> bit) & 0x01)
+        {
+            return false;
+        }
+        return ((data[0] >> (bit - 1)) & 0x01) == 0;
+    }
+    else if (codecType == Codec::CodecType::AV1)
+    {
+        for (size_t pos = 0; pos < size; )
+        {
+            uint8_t header = data[pos];
+            uint32_t obuType = (header >> 3) & 0x0F;
+            bool hasExtension = (header >> 2) & 0x01;
+            bool hasSize = (header >> 1) & 0x01;
+            if (obuType == kAv1ObuSequenceHeader)
+            {
+                return true;
+            }
+            pos += hasExtension ? 2 : 1;
+            if (!hasSize)
+            {
+                break;
+            }
+            // Hint : leb128
+            uint64_t obuSize = 0;
+            for (uint32_t i = 0; i < 8 && pos < size; i++)
+            {
+                uint8_t byte = data[pos++];
+                obuSize |= (uint64_t)(byte & 0x7F) << (i * 7);
+                if (!(byte & 0x80))
+                {
+                    break;
+                }
+            }
+            pos += obuSize;
+        }
+        return false;
+    }
+    return false;
+}
+
+bool IvfDemuxer::IsOpen()
+{
+    return _file != nullptr;
+}
+
+Codec::StreamPack::ptr IvfDemuxer::GetPacket()
+{
+    if (!_file)
+    {
+        return nullptr;
+    }
+    while (_cur < _frames.size())
+    {
+        const Frame& frame = _frames[_cur++];
+        if (frame.size == 0)
+        {
+            // Hint : 空 pack 是解码器的结束标记 (CreateEndOfStreamPack), 空帧 (编码端丢帧) 不输出, 直接读下一个
+            continue;
+        }
+        return std::make_shared<Codec::StreamPack>(_codecType, (size_t)frame.size, std::make_shared<MappedFileAllocateMethod>(_file, frame.offset, frame.size));
+    }
+    return nullptr;
+}
+
+Codec::CodecType IvfDemuxer::GetCodecType()
+{
+    return _codecType;
+}
+
+bool IvfDemuxer::IsPictureStart(const Codec::StreamPack::ptr& pack)
+{
+    // Hint : 每帧为一个时间单元 (VP9 superframe / AV1 temporal unit), 只输出一帧
+    return pack != nullptr;
+}
+
+bool IvfDemuxer::SeekToFrame(uint64_t frame, uint64_t& keyFrame)
+{
+    if (!_file || _frames.empty())
+    {
+        return false;
+    }
+    size_t index = (size_t)std::min<uint64_t>(frame, _frames.size() - 1);
+    while (index > 0 && !_frames[index].keyFrame)
+    {
+        index--;
+    }
+    _cur = index;
+    keyFrame = index;
+    return true;
+}
+
+uint64_t IvfDemuxer::GetFrameCount()
+{
+    return _frames.size();
+}
+
+uint32_t IvfDemuxer::GetWidth()
+{
+    return _width;
+}
+
+uint32_t IvfDemuxer::GetHeight()
+{
+    return _height;
+}
+
+} // namespace Mmp
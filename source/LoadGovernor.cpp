@@ -0,0 +1,207 @@
+#include "LoadGovernor.h"
+
+#include <thread>
+#include <algorithm>
+
+#include "Common/LogMessage.h"
+
+#include "SampleUtils.h"
+
+namespace Mmp
+{
+
+const std::string& GovernorLevelToStr(GovernorLevel level)
+{
+    static const std::string names[] = {"normal", "skip_readback", "drop_display", "lower_resolution", "reduce_fps", "unknown"};
+    size_t index = std::min((size_t)level, (size_t)GovernorLevel::COUNT);
+    return names[index];
+}
+
+LoadGovernor::LoadGovernor(uint32_t fps)
+{
+    _fps              = std::max(fps, (uint32_t)1);
+    _enable           = true;
+    _window           = 30;
+    _overload         = 0.9;
+    _recover          = 0.6;
+    _level            = (size_t)GovernorLevel::NORMAL;
+    _windowFrames     = 0;
+    _windowCostUs     = 0;
+    _started          = false;
+    _frames           = 0;
+    _overloadFrames   = 0;
+    _escalations      = 0;
+    _recoveries       = 0;
+    _skippedReadbacks = 0;
+    _droppedDisplays  = 0;
+    _lateFrames       = 0;
+    for (size_t i = 0; i < (size_t)GovernorLevel::COUNT; i++)
+    {
+        _levelEnabled[i]  = true;
+        _framesAtLevel[i] = 0;
+    }
+}
+
+void LoadGovernor::SetEnable(bool enable)
+{
+    _enable = enable;
+}
+
+void LoadGovernor::SetWindow(uint32_t frames)
+{
+    _window = std::max(frames, (uint32_t)1);
+}
+
+void LoadGovernor::SetThresholds(double overload, double recover)
+{
+    _overload = overload;
+    _recover  = std::min(recover, overload);
+}
+
+void LoadGovernor::SetLevelEnabled(GovernorLevel level, bool enable)
+{
+    if (level != GovernorLevel::NORMAL && level < GovernorLevel::COUNT)
+    {
+        _levelEnabled[(size_t)level] = enable;
+    }
+}
+
+bool LoadGovernor::IsLevelEnabled(size_t level)
+{
+    return level < (size_t)GovernorLevel::COUNT && _levelEnabled[level];
+}
+
+GovernorLevel LoadGovernor::Update(int64_t costUs)
+{
+    int64_t intervalUs = GetFrameIntervalUs();
+    _frames++;
+    _framesAtLevel[_level]++;
+    if (costUs > intervalUs)
+    {
+        _overloadFrames++;
+    }
+    _windowCostUs += costUs;
+    _windowFrames++;
+    if (_windowFrames < _window)
+    {
+        return (GovernorLevel)_level;
+    }
+    // Hint : 负载始终相对正常帧间隔计算; REDUCE_FPS 时帧间隔加倍, 若按实际间隔计算负载会减半, 立即降级后又升级, 来回振荡
+    double load = (double)_windowCostUs / _windowFrames / (1000000 / _fps);
+    _windowCostUs = 0;
+    _windowFrames = 0;
+    if (!_enable)
+    {
+        return (GovernorLevel)_level;
+    }
+    size_t level = _level;
+    if (load > _overload)
+    {
+        // Hint : 跳过被禁用的等级, 已是最高级时保持
+        size_t next = _level + 1;
+        while (next < (size_t)GovernorLevel::COUNT && !IsLevelEnabled(next))
+        {
+            next++;
+        }
+        if (next < (size_t)GovernorLevel::COUNT)
+        {
+            level = next;
+            _escalations++;
+        }
+    }
+    else if (load < _recover && _level != (size_t)GovernorLevel::NORMAL)
+    {
+        size_t prev = _level - 1;
+        while (prev != (size_t)GovernorLevel::NORMAL && !IsLevelEnabled(prev))
+        {
+            prev--;
+        }
+        level = prev;
+        _recoveries++;
+    }
+    if (level != _level)
+    {
+        MMP_LOG_INFO << "Governor " << GovernorLevelToStr((GovernorLevel)_level) << " -> " << GovernorLevelToStr((GovernorLevel)level)
+                     << ", load : " << (int64_t)(load * 100) << "%";
+        _level = level;
+    }
+    return (GovernorLevel)_level;
+}
+
+GovernorLevel LoadGovernor::GetLevel()
+{
+    return (GovernorLevel)_level;
+}
+
+bool LoadGovernor::ShouldReadback(uint64_t frameIndex)
+{
+    if (_level >= (size_t)GovernorLevel::SKIP_READBACK && frameIndex % 2 == 1)
+    {
+        _skippedReadbacks++;
+        return false;
+    }
+    return true;
+}
+
+bool LoadGovernor::ShouldDropBusyDisplay()
+{
+    return _level >= (size_t)GovernorLevel::DROP_DISPLAY;
+}
+
+void LoadGovernor::RecordDroppedDisplay()
+{
+    _droppedDisplays++;
+}
+
+uint32_t LoadGovernor::GetResolutionShift()
+{
+    return _level >= (size_t)GovernorLevel::LOWER_RESOLUTION && IsLevelEnabled((size_t)GovernorLevel::LOWER_RESOLUTION) ? 1 : 0;
+}
+
+int64_t LoadGovernor::GetFrameIntervalUs()
+{
+    int64_t intervalUs = 1000000 / _fps;
+    return _level >= (size_t)GovernorLevel::REDUCE_FPS ? intervalUs * 2 : intervalUs;
+}
+
+void LoadGovernor::WaitNextFrame()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::chrono::microseconds interval(GetFrameIntervalUs());
+    if (!_started)
+    {
+        _deadline = now;
+        _started = true;
+    }
+    _deadline += interval;
+    if (_deadline > now)
+    {
+        std::this_thread::sleep_until(_deadline);
+    }
+    else if (now - _deadline > interval)
+    {
+        // Hint : 落后超过一帧, 放弃追赶, 从当前时刻重新开始节拍
+        _lateFrames++;
+        _deadline = now;
+    }
+}
+
+void LoadGovernor::Report(const std::string& prefix)
+{
+    MMP_LOG_INFO << "Governor frames : " << _frames << ", overload frames : " << _overloadFrames
+                 << ", escalations : " << _escalations << ", recoveries : " << _recoveries
+                 << ", skipped readbacks : " << _skippedReadbacks << ", dropped displays : " << _droppedDisplays
+                 << ", late frames : " << _lateFrames << ", final level : " << GovernorLevelToStr((GovernorLevel)_level);
+    ReportPerfMetric(prefix + "_governor_overload_frames", (double)_overloadFrames);
+    ReportPerfMetric(prefix + "_governor_escalations", (double)_escalations);
+    ReportPerfMetric(prefix + "_governor_recoveries", (double)_recoveries);
+    ReportPerfMetric(prefix + "_governor_skipped_readbacks", (double)_skippedReadbacks);
+    ReportPerfMetric(prefix + "_governor_dropped_displays", (double)_droppedDisplays);
+    ReportPerfMetric(prefix + "_governor_late_frames", (double)_lateFrames);
+    for (size_t i = 0; i < (size_t)GovernorLevel::COUNT; i++)
+    {
+        ReportPerfMetric(prefix + "_governor_frames_" + GovernorLevelToStr((GovernorLevel)i), (double)_framesAtLevel[i]);
+    }
+}
+
+} // namespace Mmp
@@ -0,0 +1,135 @@
+#include "MappedFile.h"
+
+#include <fstream>
+#include <algorithm>
+
+#include "Common/LogMessage.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace Mmp
+{
+
+constexpr size_t kPageSize = 4096;
+
+MappedFile::MappedFile()
+{
+    _data = nullptr;
+    _size = 0;
+}
+
+MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+    if (_data)
+    {
+        munmap(_data, _size);
+    }
+#endif
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+    _data = (uint8_t*)data;
+    _size = (size_t)st.st_size;
+    return true;
+#else
+    std::ifstream ifs(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!ifs.is_open())
+    {
+        return false;
+    }
+    _buffer.resize((size_t)ifs.tellg());
+    ifs.seekg(0);
+    ifs.read((char*)_buffer.data(), _buffer.size());
+    _data = _buffer.data();
+    _size = _buffer.size();
+    return !ifs.fail();
+#endif
+}
+
+void MappedFile::WillNeed(size_t offset, size_t size)
+{
+#ifndef _WIN32
+    size_t begin = offset / kPageSize * kPageSize;
+    madvise(_data + begin, std::min(size + (offset - begin), _size - begin), MADV_WILLNEED);
+#endif
+}
+
+void MappedFile::Sequential()
+{
+#ifndef _WIN32
+    madvise(_data, _size, MADV_SEQUENTIAL);
+#endif
+}
+
+uint8_t* MappedFile::GetData()
+{
+    return _data;
+}
+
+size_t MappedFile::GetSize()
+{
+    return _size;
+}
+
+MappedFileAllocateMethod::MappedFileAllocateMethod(MappedFile::ptr file, uint64_t offset, uint64_t size)
+    : _file(file), _offset(offset), _size(size)
+{
+}
+
+void* MappedFileAllocateMethod::Malloc(size_t size)
+{
+    if (size > _size)
+    {
+        MMP_LOG_ERROR << "Needs " << size << " bytes, but mapped range is " << _size << " bytes";
+        return nullptr;
+    }
+    return _file->GetData() + _offset;
+}
+
+void* MappedFileAllocateMethod::Resize(void* data, size_t size)
+{
+    if (size > _size)
+    {
+        MMP_LOG_ERROR << "Needs " << size << " bytes, but mapped range is " << _size << " bytes";
+        return nullptr;
+    }
+    return data;
+}
+
+void* MappedFileAllocateMethod::GetAddress(uint64_t offset)
+{
+    return _file->GetData() + _offset + offset;
+}
+
+const std::string& MappedFileAllocateMethod::Tag()
+{
+    static const std::string tag = "MappedFileAllocateMethod";
+    return tag;
+}
+
+} // namespace Mmp
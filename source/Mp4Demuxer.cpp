@@ -0,0 +1,637 @@
+#include "Mp4Demuxer.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "Common/LogMessage.h"
+#include "Common/ImmutableVectorAllocateMethod.h"
+
+namespace Mmp
+{
+
+constexpr uint32_t FourCC(const char (&code)[5])
+{
+    return ((uint32_t)(uint8_t)code[0] << 24) | ((uint32_t)(uint8_t)code[1] << 16) | ((uint32_t)(uint8_t)code[2] << 8) | (uint32_t)(uint8_t)code[3];
+}
+
+constexpr uint8_t  kStartCode[4]          = {0x00, 0x00, 0x00, 0x01};
+constexpr uint64_t kVisualSampleEntrySize = 78;   // SampleEntry (8) + VisualSampleEntry (70), 不含盒子头
+
+static uint16_t ReadU16(const uint8_t* data)
+{
+    return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+static uint32_t ReadU32(const uint8_t* data)
+{
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+static uint64_t ReadU64(const uint8_t* data)
+{
+    return ((uint64_t)ReadU32(data) << 32) | ReadU32(data + 4);
+}
+
+/**
+ * @brief 盒子, [begin, end) 为去掉盒子头后的内容
+ */
+class Mp4Box
+{
+public:
+    uint32_t  type;
+    uint64_t  begin;
+    uint64_t  end;
+};
+
+/**
+ * @brief 读取 pos 处的盒子头, 支持 64 位大小 (size == 1) 及延伸到父盒子末尾 (size == 0)
+ */
+static bool ReadBox(const uint8_t* data, uint64_t pos, uint64_t end, Mp4Box& box)
+{
+    if (pos + 8 > end)
+    {
+        return false;
+    }
+    uint64_t size = ReadU32(data + pos);
+    uint64_t header = 8;
+    box.type = ReadU32(data + pos + 4);
+    if (size == 1)
+    {
+        if (pos + 16 > end)
+        {
+            return false;
+        }
+        size = ReadU64(data + pos + 8);
+        header = 16;
+    }
+    else if (size == 0)
+    {
+        size = end - pos;
+    }
+    if (size < header || size > end - pos)
+    {
+        return false;
+    }
+    box.begin = pos + header;
+    box.end = pos + size;
+    return true;
+}
+
+/**
+ * @brief 将 avcC / hvcC 中的一个参数集追加为 Annex-B
+ */
+static bool AppendParameterSet(const uint8_t* data, uint64_t& pos, uint64_t end, std::vector<uint8_t>& out)
+{
+    if (pos + 2 > end)
+    {
+        return false;
+    }
+    uint16_t size = ReadU16(data + pos);
+    pos += 2;
+    if (pos + size > end)
+    {
+        return false;
+    }
+    out.insert(out.end(), kStartCode, kStartCode + 4);
+    out.insert(out.end(), data + pos, data + pos + size);
+    pos += size;
+    return true;
+}
+
+Mp4Demuxer::Track::Track()
+{
+    video = false;
+    supported = false;
+    codecType = Codec::CodecType::H264;
+    width = 0;
+    height = 0;
+    lengthSize = 0;
+    defaultSize = 0;
+    hasSyncTable = false;
+}
+
+Mp4Demuxer::Mp4Demuxer()
+{
+    _codecType = Codec::CodecType::H264;
+    _width = 0;
+    _height = 0;
+    _lengthSize = 0;
+    _cur = 0;
+    _sendParameterSets = false;
+    _copiedSamples = 0;
+}
+
+bool Mp4Demuxer::Open(const std::string& path)
+{
+    MappedFile::ptr file = std::make_shared<MappedFile>();
+    if (!file->Open(path))
+    {
+        MMP_LOG_ERROR << "Open mp4 fail, path is: " << path;
+        return false;
+    }
+    _file = file;
+    const uint8_t* data = _file->GetData();
+    uint64_t size = _file->GetSize();
+    Mp4Box moov = {0, 0, 0};
+    Mp4Box box;
+    for (uint64_t pos = 0; ReadBox(data, pos, size, box); pos = box.end)
+    {
+        if (box.type == FourCC("moov"))
+        {
+            moov = box;
+        }
+        else if (box.type == FourCC("moof"))
+        {
+            MMP_LOG_ERROR << "Fragmented mp4 is not supported, path is: " << path;
+            _file.reset();
+            return false;
+        }
+    }
+    if (moov.type == 0)
+    {
+        MMP_LOG_ERROR << "No moov box, path is: " << path;
+        _file.reset();
+        return false;
+    }
+    for (uint64_t pos = moov.begin; ReadBox(data, pos, moov.end, box); pos = box.end)
+    {
+        if (box.type != FourCC("trak"))
+        {
+            continue;
+        }
+        Track track;
+        if (!ParseTrack(box.begin, box.end, box.type, track) || !track.video)
+        {
+            continue;
+        }
+        if (!track.supported)
+        {
+            MMP_LOG_WARN << "Skip video track with unsupported sample entry";
+            continue;
+        }
+        if (!BuildSamples(track))
+        {
+            continue;
+        }
+        _codecType = track.codecType;
+        _width = track.width;
+        _height = track.height;
+        _lengthSize = track.lengthSize;
+        if (!track.parameterSets.empty())
+        {
+            std::shared_ptr<ImmutableVectorAllocateMethod<uint8_t>> alloc = std::make_shared<ImmutableVectorAllocateMethod<uint8_t>>();
+            alloc->container.swap(track.parameterSets);
+            _parameterSetPack = std::make_shared<Codec::StreamPack>(_codecType, alloc->container.size(), alloc);
+        }
+        _sendParameterSets = _parameterSetPack != nullptr;
+        // Hint : 按 sample 顺序读取时 sample 在文件中基本连续, 加大预读窗口
+        _file->Sequential();
+        MMP_LOG_INFO << "Mp4Demuxer open " << path << ", " << _width << "x" << _height << ", " << _samples.size() << " samples";
+        return true;
+    }
+    MMP_LOG_ERROR << "No supported video track, path is: " << path;
+    _file.reset();
+    return false;
+}
+
+bool Mp4Demuxer::ParseTrack(uint64_t begin, uint64_t end, uint32_t parent, Track& track)
+{
+    const uint8_t* data = _file->GetData();
+    Mp4Box box;
+    for (uint64_t pos = begin; ReadBox(data, pos, end, box); pos = box.end)
+    {
+        uint64_t size = box.end - box.begin;
+        const uint8_t* payload = data + box.begin;
+        if (box.type == FourCC("mdia") || box.type == FourCC("minf") || box.type == FourCC("stbl"))
+        {
+            if (!ParseTrack(box.begin, box.end, box.type, track))
+            {
+                return false;
+            }
+        }
+        else if (box.type == FourCC("hdlr") && parent == FourCC("mdia"))
+        {
+            // Hint : minf/dinf 下也可能有 hdlr (数据引用的 alis / url), 只有 mdia 下的表示轨道类型
+            //        version/flags (4) + pre_defined (4) + handler_type (4)
+            track.video = size >= 12 && ReadU32(payload + 8) == FourCC("vide");
+        }
+        else if (box.type == FourCC("stsd"))
+        {
+            Mp4Box entry;
+            if (size >= 8 && ReadU32(payload + 4) >= 1 && ReadBox(data, box.begin + 8, box.end, entry))
+            {
+                track.supported = ParseSampleEntry(entry.begin, entry.end, track);
+                if (entry.type == FourCC("avc1") || entry.type == FourCC("avc3"))
+                {
+                    track.codecType = Codec::CodecType::H264;
+                }
+                else if (entry.type == FourCC("hvc1") || entry.type == FourCC("hev1"))
+                {
+                    track.codecType = Codec::CodecType::H265;
+                }
+                else if (entry.type == FourCC("vp09"))
+                {
+                    track.codecType = Codec::CodecType::VP9;
+                }
+                else if (entry.type == FourCC("av01"))
+                {
+                    track.codecType = Codec::CodecType::AV1;
+                }
+                else
+                {
+                    track.supported = false;
+                }
+            }
+        }
+        else if (box.type == FourCC("stsz"))
+        {
+            if (size < 12)
+            {
+                return false;
+            }
+            track.defaultSize = ReadU32(payload + 4);
+            uint32_t count = ReadU32(payload + 8);
+            if (track.defaultSize == 0)
+            {
+                if (12 + (uint64_t)count * 4 > size)
+                {
+                    return false;
+                }
+                track.sizes.resize(count);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    track.sizes[i] = ReadU32(payload + 12 + i * 4);
+                }
+            }
+            else
+            {
+                // Hint : 所有 sample 都在文件内, 数量不会超过 文件大小 / sample 大小, 避免损坏的 count 触发巨大的分配
+                count = (uint32_t)std::min<uint64_t>(count, _file->GetSize() / track.defaultSize);
+                track.sizes.assign(count, track.defaultSize);
+            }
+        }
+        else if (box.type == FourCC("stz2"))
+        {
+            if (size < 12)
+            {
+                return false;
+            }
+            uint32_t fieldSize = payload[7];
+            uint32_t count = ReadU32(payload + 8);
+            if ((fieldSize != 4 && fieldSize != 8 && fieldSize != 16) || 12 + ((uint64_t)count * fieldSize + 7) / 8 > size)
+            {
+                return false;
+            }
+            track.sizes.resize(count);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (fieldSize == 16)
+                {
+                    track.sizes[i] = ReadU16(payload + 12 + i * 2);
+                }
+                else if (fieldSize == 8)
+                {
+                    track.sizes[i] = payload[12 + i];
+                }
+                else
+                {
+                    uint8_t byte = payload[12 + i / 2];
+                    track.sizes[i] = (i % 2 == 0) ? (byte >> 4) : (byte & 0x0F);
+                }
+            }
+        }
+        else if (box.type == FourCC("stsc"))
+        {
+            if (size < 8)
+            {
+                return false;
+            }
+            uint32_t count = ReadU32(payload + 4);
+            if (8 + (uint64_t)count * 12 > size)
+            {
+                return false;
+            }
+            track.stscFirstChunk.resize(count);
+            track.stscSamplesPerChunk.resize(count);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                track.stscFirstChunk[i] = ReadU32(payload + 8 + i * 12);
+                track.stscSamplesPerChunk[i] = ReadU32(payload + 8 + i * 12 + 4);
+            }
+        }
+        else if (box.type == FourCC("stco") || box.type == FourCC("co64"))
+        {
+            bool wide = box.type == FourCC("co64");
+            uint64_t entrySize = wide ? 8 : 4;
+            if (size < 8)
+            {
+                return false;
+            }
+            uint32_t count = ReadU32(payload + 4);
+            if (8 + (uint64_t)count * entrySize > size)
+            {
+                return false;
+            }
+            track.chunkOffsets.resize(count);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                track.chunkOffsets[i] = wide ? ReadU64(payload + 8 + i * 8) : ReadU32(payload + 8 + i * 4);
+            }
+        }
+        else if (box.type == FourCC("stss"))
+        {
+            if (size < 8)
+            {
+                return false;
+            }
+            uint32_t count = ReadU32(payload + 4);
+            if (8 + (uint64_t)count * 4 > size)
+            {
+                return false;
+            }
+            track.syncSamples.resize(count);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                track.syncSamples[i] = ReadU32(payload + 8 + i * 4);
+            }
+            track.hasSyncTable = true;
+        }
+    }
+    return true;
+}
+
+bool Mp4Demuxer::ParseSampleEntry(uint64_t begin, uint64_t end, Track& track)
+{
+    const uint8_t* data = _file->GetData();
+    if (begin + kVisualSampleEntrySize > end)
+    {
+        return false;
+    }
+    // Hint : SampleEntry 的 reserved (6) + data_reference_index (2), 之后 pre_defined/reserved (16) + width (2) + height (2)
+    track.width = ReadU16(data + begin + 24);
+    track.height = ReadU16(data + begin + 26);
+    Mp4Box box;
+    for (uint64_t pos = begin + kVisualSampleEntrySize; ReadBox(data, pos, end, box); pos = box.end)
+    {
+        const uint8_t* payload = data + box.begin;
+        uint64_t size = box.end - box.begin;
+        if (box.type == FourCC("avcC"))
+        {
+            // Hint : configurationVersion, profile, compatibility, level, lengthSizeMinusOne, numOfSequenceParameterSets
+            if (size < 7)
+            {
+                return false;
+            }
+            track.lengthSize = (payload[4] & 0x03) + 1;
+            uint64_t cur = box.begin + 6;
+            for (uint32_t i = 0; i < (uint32_t)(payload[5] & 0x1F); i++)
+            {
+                if (!AppendParameterSet(data, cur, box.end, track.parameterSets))
+                {
+                    return false;
+                }
+            }
+            if (cur >= box.end)
+            {
+                return false;
+            }
+            uint32_t ppsCount = data[cur++];
+            for (uint32_t i = 0; i < ppsCount; i++)
+            {
+                if (!AppendParameterSet(data, cur, box.end, track.parameterSets))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        else if (box.type == FourCC("hvcC"))
+        {
+            // Hint : 前 21 字节为 profile/level 等, 第 21 字节低 2 位为 lengthSizeMinusOne, 第 22 字节为数组个数
+            if (size < 23)
+            {
+                return false;
+            }
+            track.lengthSize = (payload[21] & 0x03) + 1;
+            uint32_t arrayCount = payload[22];
+            uint64_t cur = box.begin + 23;
+            for (uint32_t i = 0; i < arrayCount; i++)
+            {
+                if (cur + 3 > box.end)
+                {
+                    return false;
+                }
+                uint16_t nalCount = ReadU16(data + cur + 1);
+                cur += 3;
+                for (uint32_t j = 0; j < nalCount; j++)
+                {
+                    if (!AppendParameterSet(data, cur, box.end, track.parameterSets))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+        else if (box.type == FourCC("vpcC") || box.type == FourCC("av1C"))
+        {
+            // Hint : VP9 / AV1 的 sample 为帧 (时间单元) 本身, 不需要转换
+            track.lengthSize = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Mp4Demuxer::BuildSamples(const Track& track)
+{
+    uint64_t fileSize = _file->GetSize();
+    if (track.sizes.empty() || track.stscFirstChunk.empty() || track.chunkOffsets.empty())
+    {
+        MMP_LOG_ERROR << "Incomplete sample table";
+        return false;
+    }
+    std::vector<Sample> samples;
+    samples.reserve(track.sizes.size());
+    size_t run = 0;
+    for (size_t chunk = 0; chunk < track.chunkOffsets.size() && samples.size() < track.sizes.size(); chunk++)
+    {
+        // Hint : stsc 中 first_chunk 从 1 开始, 每项覆盖到下一项的 first_chunk 之前
+        while (run + 1 < track.stscFirstChunk.size() && track.stscFirstChunk[run + 1] <= chunk + 1)
+        {
+            run++;
+        }
+        uint64_t offset = track.chunkOffsets[chunk];
+        for (uint32_t i = 0; i < track.stscSamplesPerChunk[run] && samples.size() < track.sizes.size(); i++)
+        {
+            Sample sample;
+            sample.offset = offset;
+            sample.size = track.sizes[samples.size()];
+            sample.keyFrame = !track.hasSyncTable;
+            sample.converted = track.lengthSize == 0;
+            if (sample.offset + sample.size > fileSize)
+            {
+                MMP_LOG_ERROR << "Sample " << samples.size() << " is out of file, offset : " << sample.offset << ", size : " << sample.size;
+                return false;
+            }
+            samples.push_back(sample);
+            offset += sample.size;
+        }
+    }
+    if (samples.size() != track.sizes.size())
+    {
+        MMP_LOG_WARN << "Sample table covers " << samples.size() << " of " << track.sizes.size() << " samples";
+    }
+    for (uint32_t sync : track.syncSamples)
+    {
+        if (sync >= 1 && sync <= samples.size())
+        {
+            samples[sync - 1].keyFrame = true;
+        }
+    }
+    _samples.swap(samples);
+    return !_samples.empty();
+}
+
+Codec::StreamPack::ptr Mp4Demuxer::ConvertSample(Sample& sample)
+{
+    uint8_t* data = _file->GetData() + sample.offset;
+    // Hint : 先完整校验一遍长度字段, 校验失败时不改写, 避免半转换的 sample
+    bool valid = true;
+    size_t nalCount = 0;
+    for (uint64_t pos = 0; pos < sample.size; )
+    {
+        if (pos + _lengthSize > sample.size)
+        {
+            valid = false;
+            break;
+        }
+        uint64_t nalSize = 0;
+        for (uint32_t i = 0; i < _lengthSize; i++)
+        {
+            nalSize = (nalSize << 8) | data[pos + i];
+        }
+        pos += _lengthSize + nalSize;
+        valid = pos <= sample.size;
+        nalCount++;
+    }
+    if (!valid)
+    {
+        MMP_LOG_WARN << "Invalid length prefixed sample, offset : " << sample.offset << ", size : " << sample.size;
+        return nullptr;
+    }
+    if (_lengthSize == 4)
+    {
+        for (uint64_t pos = 0; pos < sample.size; )
+        {
+            uint32_t nalSize = ReadU32(data + pos);
+            memcpy(data + pos, kStartCode, 4);
+            pos += 4 + nalSize;
+        }
+        sample.converted = true;
+        return std::make_shared<Codec::StreamPack>(_codecType, (size_t)sample.size, std::make_shared<MappedFileAllocateMethod>(_file, sample.offset, sample.size));
+    }
+    // Hint : 长度字段短于起始码, 原地无法容纳, 拷贝输出
+    std::shared_ptr<ImmutableVectorAllocateMethod<uint8_t>> alloc = std::make_shared<ImmutableVectorAllocateMethod<uint8_t>>();
+    alloc->container.reserve(sample.size + nalCount * (4 - _lengthSize));
+    for (uint64_t pos = 0; pos < sample.size; )
+    {
+        uint64_t nalSize = 0;
+        for (uint32_t i = 0; i < _lengthSize; i++)
+        {
+            nalSize = (nalSize << 8) | data[pos + i];
+        }
+        pos += _lengthSize;
+        alloc->container.insert(alloc->container.end(), kStartCode, kStartCode + 4);
+        alloc->container.insert(alloc->container.end(), data + pos, data + pos + nalSize);
+        pos += nalSize;
+    }
+    _copiedSamples++;
+    return std::make_shared<Codec::StreamPack>(_codecType, alloc->container.size(), alloc);
+}
+
+bool Mp4Demuxer::IsOpen()
+{
+    return _file != nullptr;
+}
+
+Codec::StreamPack::ptr Mp4Demuxer::GetPacket()
+{
+    if (!_file)
+    {
+        return nullptr;
+    }
+    if (_sendParameterSets)
+    {
+        _sendParameterSets = false;
+        return _parameterSetPack;
+    }
+    while (_cur < _samples.size())
+    {
+        Sample& sample = _samples[_cur++];
+        if (sample.size == 0)
+        {
+            // Hint : 空 pack 是解码器的结束标记 (CreateEndOfStreamPack), 空 sample 不输出, 直接读下一个
+            continue;
+        }
+        if (sample.converted)
+        {
+            return std::make_shared<Codec::StreamPack>(_codecType, (size_t)sample.size, std::make_shared<MappedFileAllocateMethod>(_file, sample.offset, sample.size));
+        }
+        Codec::StreamPack::ptr pack = ConvertSample(sample);
+        if (pack)
+        {
+            return pack;
+        }
+    }
+    return nullptr;
+}
+
+Codec::CodecType Mp4Demuxer::GetCodecType()
+{
+    return _codecType;
+}
+
+bool Mp4Demuxer::IsPictureStart(const Codec::StreamPack::ptr& pack)
+{
+    return pack && pack != _parameterSetPack;
+}
+
+bool Mp4Demuxer::SeekToFrame(uint64_t frame, uint64_t& keyFrame)
+{
+    if (!_file || _samples.empty())
+    {
+        return false;
+    }
+    size_t index = (size_t)std::min<uint64_t>(frame, _samples.size() - 1);
+    while (index > 0 && !_samples[index].keyFrame)
+    {
+        index--;
+    }
+    _cur = index;
+    _sendParameterSets = _parameterSetPack != nullptr;
+    keyFrame = index;
+    return true;
+}
+
+uint64_t Mp4Demuxer::GetSampleCount()
+{
+    return _samples.size();
+}
+
+uint64_t Mp4Demuxer::GetCopiedSamples()
+{
+    return _copiedSamples;
+}
+
+uint32_t Mp4Demuxer::GetWidth()
+{
+    return _width;
+}
+
+uint32_t Mp4Demuxer::GetHeight()
+{
+    return _height;
+}
+
+} // namespace Mmp
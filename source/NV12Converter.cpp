@@ -0,0 +1,108 @@
+#include "NV12Converter.h"
+
+#include <thread>
+#include <vector>
+#include <cassert>
+#include <algorithm>
+
+#include "GPU/GL/GLDrawContex.h"
+#include "GPU/PG/Utility/CommonUtility.h"
+
+#include "WorkStealingPool.h"
+
+namespace Mmp
+{
+
+static inline uint8_t ClampToByte(int32_t value)
+{
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+/**
+ * @note  处理 [rowBegin, rowEnd) 行, rowBegin 需为偶数
+ */
+static void ConvertRGBAToNV12Rows(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* nv12, const RGBToYUVCoeff& coeff, uint32_t rowBegin, uint32_t rowEnd)
+{
+    uint8_t* yPlane  = nv12;
+    uint8_t* uvPlane = nv12 + (size_t)width * height;
+    for (uint32_t row=rowBegin; row<rowEnd; row+=2)
+    {
+        const uint8_t* src0 = rgba + (size_t)row * width * 4;
+        const uint8_t* src1 = src0 + (size_t)width * 4;
+        uint8_t* y0 = yPlane + (size_t)row * width;
+        uint8_t* y1 = y0 + width;
+        uint8_t* uv = uvPlane + (size_t)(row / 2) * width;
+        for (uint32_t col=0; col<width; col+=2)
+        {
+            int32_t r = 0, g = 0, b = 0;
+            const uint8_t* pixels[4] = {src0, src0 + 4, src1, src1 + 4};
+            uint8_t* lumas[4] = {y0, y0 + 1, y1, y1 + 1};
+            for (size_t i=0; i<4; i++)
+            {
+                const uint8_t* p = pixels[i];
+                *lumas[i] = ClampToByte(((coeff.yCoeff[0] * p[0] + coeff.yCoeff[1] * p[1] + coeff.yCoeff[2] * p[2] + 128) >> 8) + coeff.yOffset);
+                r += p[0];
+                g += p[1];
+                b += p[2];
+            }
+            r = (r + 2) >> 2;
+            g = (g + 2) >> 2;
+            b = (b + 2) >> 2;
+            uv[0] = ClampToByte(((coeff.uCoeff[0] * r + coeff.uCoeff[1] * g + coeff.uCoeff[2] * b + 128) >> 8) + coeff.uvOffset);
+            uv[1] = ClampToByte(((coeff.vCoeff[0] * r + coeff.vCoeff[1] * g + coeff.vCoeff[2] * b + 128) >> 8) + coeff.uvOffset);
+            src0 += 8;
+            src1 += 8;
+            y0 += 2;
+            y1 += 2;
+            uv += 2;
+        }
+    }
+}
+
+void ConvertRGBAToNV12(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* nv12, const RGBToYUVCoeff& coeff, uint32_t bands)
+{
+    assert(width % 2 == 0 && height % 2 == 0);
+    if (bands == 0)
+    {
+        bands = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    uint32_t rowsPerBand = ((height / 2 + bands - 1) / bands) * 2;
+    if (bands == 1 || rowsPerBand >= height)
+    {
+        ConvertRGBAToNV12Rows(rgba, width, height, nv12, coeff, 0, height);
+        return;
+    }
+    // Hint : 第一段在当前线程处理; 读回每帧都要完成, 以 REALTIME 优先级提交
+    size_t bandCount = (height + rowsPerBand - 1) / rowsPerBand;
+    WorkStealingPool::Instance().ParallelFor(bandCount, [&](size_t band)
+    {
+        uint32_t rowBegin = (uint32_t)band * rowsPerBand;
+        uint32_t rowEnd = std::min(rowBegin + rowsPerBand, height);
+        ConvertRGBAToNV12Rows(rgba, width, height, nv12, coeff, rowBegin, rowEnd);
+    }, TaskPriority::REALTIME);
+}
+
+NV12Converter::NV12Converter(const PixelsInfo& info, YUVColorSpace space, YUVColorRange range)
+{
+    _nv12Info = PixelsInfo(info.width, info.height, 8, PixelFormat::NV12);
+    _coeff    = GetRGBToYUVCoeff(space, range);
+    _rgba     = std::make_shared<NormalPicture>(PixelsInfo(info.width, info.height, 8, PixelFormat::RGBA8888));
+}
+
+AbstractPicture::ptr NV12Converter::ReadbackAndConvert(Texture::ptr framebuffer, AbstractPicture::ptr picture)
+{
+    if (!picture)
+    {
+        picture = std::make_shared<NormalPicture>(_nv12Info);
+    }
+    Gpu::Copy2DTexturesToMemory(GLDrawContex::Instance(), std::vector<Texture::ptr>({framebuffer}), _rgba);
+    ConvertRGBAToNV12((const uint8_t*)_rgba->GetData(), _nv12Info.width, _nv12Info.height, (uint8_t*)picture->GetData(), _coeff);
+    return picture;
+}
+
+const PixelsInfo& NV12Converter::GetNV12Info()
+{
+    return _nv12Info;
+}
+
+} // namespace Mmp
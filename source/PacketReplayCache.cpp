@@ -0,0 +1,108 @@
+#include "PacketReplayCache.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "Common/AbstractAllocateMethod.h"
+#include "Common/LogMessage.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief 引用 arena 中一段内存的分配器, 不拥有也不分配内存
+ */
+class ArenaSliceAllocateMethod : public AbstractAllocateMethod
+{
+public:
+    ArenaSliceAllocateMethod(std::shared_ptr<std::vector<uint8_t>> arena, uint64_t offset, uint64_t size)
+        : _arena(arena), _offset(offset), _size(size)
+    {
+    }
+public:
+    void* Malloc(size_t size) override
+    {
+        assert(size <= _size);
+        return _arena->data() + _offset;
+    }
+    void* Resize(void* data, size_t size) override
+    {
+        assert(size <= _size);
+        return data;
+    }
+    void* GetAddress(uint64_t offset) override
+    {
+        return _arena->data() + _offset + offset;
+    }
+    const std::string& Tag() override
+    {
+        static const std::string tag = "ArenaSliceAllocateMethod";
+        return tag;
+    }
+private:
+    std::shared_ptr<std::vector<uint8_t>> _arena;
+    uint64_t _offset;
+    uint64_t _size;
+};
+
+PacketReplayCache::PacketReplayCache(Codec::CodecType codecType)
+{
+    _codecType = codecType;
+    _pictures = 0;
+    _arena = std::make_shared<std::vector<uint8_t>>();
+}
+
+size_t PacketReplayCache::Load(AbstractPacketReader& reader)
+{
+    // Hint : 使用新的 arena, 解码器仍持有的旧 pack 继续引用旧 arena
+    _arena = std::make_shared<std::vector<uint8_t>>();
+    _packs.clear();
+    _pictures = 0;
+    std::vector<uint64_t> sizes;
+    Codec::StreamPack::ptr pack;
+    while ((pack = reader.GetPacket()))
+    {
+        uint64_t offset = _arena->size();
+        _arena->resize(_arena->size() + pack->GetSize());
+        memcpy(_arena->data() + offset, pack->GetData(), pack->GetSize());
+        sizes.push_back(pack->GetSize());
+        if (reader.IsPictureStart(pack))
+        {
+            _pictures++;
+        }
+    }
+    _arena->shrink_to_fit();
+    // Hint : arena 此后不再变化, 地址稳定, 可以提前创建好所有 pack
+    _packs.reserve(sizes.size());
+    uint64_t offset = 0;
+    for (uint64_t size : sizes)
+    {
+        AbstractAllocateMethod::ptr alloc = std::make_shared<ArenaSliceAllocateMethod>(_arena, offset, size);
+        _packs.push_back(std::make_shared<Codec::StreamPack>(_codecType, (size_t)size, alloc));
+        offset += size;
+    }
+    MMP_LOG_INFO << "PacketReplayCache load " << _packs.size() << " packs, " << _arena->size() / 1024 << " KB";
+    return _packs.size();
+}
+
+Codec::StreamPack::ptr PacketReplayCache::GetPack(size_t index)
+{
+    return _packs[index];
+}
+
+size_t PacketReplayCache::GetPackCount()
+{
+    return _packs.size();
+}
+
+uint64_t PacketReplayCache::GetPictureCount()
+{
+    return _pictures;
+}
+
+uint64_t PacketReplayCache::GetBytes()
+{
+    return _arena->size();
+}
+
+} // namespace Mmp
@@ -0,0 +1,521 @@
+#include "PictureFile.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <algorithm>
+
+#include "Common/LogMessage.h"
+#include "Common/NormalPicture.h"
+#include "Common/AbstractAllocateMethod.h"
+
+#include "MappedFile.h"
+#include "WorkStealingPool.h"
+
+namespace Mmp
+{
+
+constexpr char     kPictureMagic[4]    = {'M', 'P', 'I', 'C'};
+constexpr uint16_t kPictureVersion     = 1;
+constexpr size_t   kPictureHeaderSize  = 64;
+constexpr size_t   kPayloadAlign       = 4096;
+constexpr uint32_t kChunkSize          = 1 << 20;
+
+/**
+ * @brief 文件内的像素格式编号, 只增不改
+ */
+static const std::pair<PixelFormat, uint32_t> kFormatCodes[] =
+{
+    {PixelFormat::RGBA8888, 1},
+    {PixelFormat::BGRA8888, 2},
+    {PixelFormat::NV12,     3},
+    {PixelFormat::YUV420P,  4},
+};
+
+class PictureHeader
+{
+public:
+    PixelsInfo          info;
+    PictureCompression  compression;
+    uint64_t            payloadSize;
+    uint64_t            payloadOffset;
+    uint32_t            chunkSize;
+    uint32_t            chunkCount;
+};
+
+static void Put16(uint8_t* data, uint16_t value)
+{
+    data[0] = (uint8_t)(value);
+    data[1] = (uint8_t)(value >> 8);
+}
+
+static void Put32(uint8_t* data, uint32_t value)
+{
+    Put16(data, (uint16_t)value);
+    Put16(data + 2, (uint16_t)(value >> 16));
+}
+
+static void Put64(uint8_t* data, uint64_t value)
+{
+    Put32(data, (uint32_t)value);
+    Put32(data + 4, (uint32_t)(value >> 32));
+}
+
+static uint16_t Get16(const uint8_t* data)
+{
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+static uint32_t Get32(const uint8_t* data)
+{
+    return (uint32_t)Get16(data) | ((uint32_t)Get16(data + 2) << 16);
+}
+
+static uint64_t Get64(const uint8_t* data)
+{
+    return (uint64_t)Get32(data) | ((uint64_t)Get32(data + 4) << 32);
+}
+
+static size_t AlignUp(size_t value, size_t align)
+{
+    return (value + align - 1) / align * align;
+}
+
+static void EncodeHeader(const PictureHeader& header, uint8_t* data)
+{
+    uint32_t formatCode = 0;
+    for (const auto& code : kFormatCodes)
+    {
+        formatCode = code.first == header.info.format ? code.second : formatCode;
+    }
+    memset(data, 0, kPictureHeaderSize);
+    memcpy(data, kPictureMagic, 4);
+    Put16(data + 4, kPictureVersion);
+    Put16(data + 6, (uint16_t)header.compression);
+    Put32(data + 8, (uint32_t)header.info.width);
+    Put32(data + 12, (uint32_t)header.info.height);
+    Put32(data + 16, (uint32_t)header.info.bitdepth);
+    Put32(data + 20, formatCode);
+    Put32(data + 24, (uint32_t)header.info.horStride);
+    Put32(data + 28, (uint32_t)header.info.virStride);
+    Put64(data + 32, header.payloadSize);
+    Put64(data + 40, header.payloadOffset);
+    Put32(data + 48, header.chunkSize);
+    Put32(data + 52, header.chunkCount);
+}
+
+static bool DecodeHeader(const uint8_t* data, size_t size, PictureHeader& header)
+{
+    if (size < kPictureHeaderSize || memcmp(data, kPictureMagic, 4) != 0)
+    {
+        MMP_LOG_ERROR << "Not a picture file";
+        return false;
+    }
+    if (Get16(data + 4) != kPictureVersion)
+    {
+        MMP_LOG_ERROR << "Unsupport picture file version : " << Get16(data + 4);
+        return false;
+    }
+    uint16_t compression = Get16(data + 6);
+    uint32_t formatCode  = Get32(data + 20);
+    bool formatKnown = false;
+    for (const auto& code : kFormatCodes)
+    {
+        if (code.second == formatCode)
+        {
+            header.info = PixelsInfo((int32_t)Get32(data + 8), (int32_t)Get32(data + 12), (int32_t)Get32(data + 16), code.first);
+            formatKnown = true;
+        }
+    }
+    if (!formatKnown || compression > (uint16_t)PictureCompression::LZ4)
+    {
+        MMP_LOG_ERROR << "Unsupport picture file, format : " << formatCode << ", compression : " << compression;
+        return false;
+    }
+    header.info.horStride = (int32_t)Get32(data + 24);
+    header.info.virStride = (int32_t)Get32(data + 28);
+    header.compression    = (PictureCompression)compression;
+    header.payloadSize    = Get64(data + 32);
+    header.payloadOffset  = Get64(data + 40);
+    header.chunkSize      = Get32(data + 48);
+    header.chunkCount     = Get32(data + 52);
+    if (header.compression == PictureCompression::LZ4 && (header.chunkSize == 0 ||
+        (uint64_t)header.chunkCount != (header.payloadSize + header.chunkSize - 1) / header.chunkSize))
+    {
+        MMP_LOG_ERROR << "Invalid picture file chunk table";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 在 WorkStealingPool 上并行执行 func(0 ... count - 1), 第一段在当前线程处理
+ */
+static void ParallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+    size_t bands = std::min((size_t)std::max(std::thread::hardware_concurrency(), 1u), count);
+    WorkStealingPool::Instance().ParallelFor(bands, [&func, count, bands](size_t band)
+    {
+        for (size_t i = band; i < count; i += bands)
+        {
+            func(i);
+        }
+    }, TaskPriority::NORMAL);
+}
+
+/************************************************** LZ4 block format **************************************************/
+// Hint : 标准 LZ4 块格式 (无帧头), 可与 lz4 库互通; 压缩为贪心匹配, 只在转换工具中使用, 不追求压缩速度
+
+constexpr size_t kLz4MinMatch     = 4;
+constexpr size_t kLz4LastLiterals = 5;
+constexpr size_t kLz4MfLimit      = 12;
+constexpr size_t kLz4MaxOffset    = 65535;
+constexpr uint32_t kLz4HashBits   = 16;
+
+static size_t Lz4CompressBound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+static uint32_t Lz4Read32(const uint8_t* data)
+{
+    uint32_t value;
+    memcpy(&value, data, 4);
+    return value;
+}
+
+static uint8_t* Lz4WriteLength(uint8_t* op, size_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        *op++ = 255;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+/**
+ * @return 压缩后的大小, dst 容量需不小于 Lz4CompressBound(srcSize)
+ */
+static size_t Lz4Compress(const uint8_t* src, size_t srcSize, uint8_t* dst, std::vector<uint32_t>& table)
+{
+    table.assign((size_t)1 << kLz4HashBits, 0);
+    uint8_t* op = dst;
+    size_t anchor = 0;
+    size_t ip = 0;
+    auto emit = [&](size_t literals, size_t offset, size_t matchLength)
+    {
+        uint8_t* token = op++;
+        *token = (uint8_t)(std::min(literals, (size_t)15) << 4);
+        if (literals >= 15)
+        {
+            op = Lz4WriteLength(op, literals - 15);
+        }
+        memcpy(op, src + anchor, literals);
+        op += literals;
+        if (matchLength == 0)
+        {
+            return;
+        }
+        *op++ = (uint8_t)(offset);
+        *op++ = (uint8_t)(offset >> 8);
+        size_t length = matchLength - kLz4MinMatch;
+        *token |= (uint8_t)std::min(length, (size_t)15);
+        if (length >= 15)
+        {
+            op = Lz4WriteLength(op, length - 15);
+        }
+    };
+    if (srcSize > kLz4MfLimit)
+    {
+        while (ip + kLz4MfLimit <= srcSize)
+        {
+            uint32_t sequence = Lz4Read32(src + ip);
+            uint32_t& slot = table[(sequence * 2654435761u) >> (32 - kLz4HashBits)];
+            size_t ref = slot;
+            slot = (uint32_t)ip;
+            if (ref >= ip || ip - ref > kLz4MaxOffset || Lz4Read32(src + ref) != sequence)
+            {
+                ip++;
+                continue;
+            }
+            size_t matchLength = kLz4MinMatch;
+            size_t matchLimit = srcSize - kLz4LastLiterals;
+            while (ip + matchLength < matchLimit && src[ref + matchLength] == src[ip + matchLength])
+            {
+                matchLength++;
+            }
+            emit(ip - anchor, ip - ref, matchLength);
+            ip += matchLength;
+            anchor = ip;
+        }
+    }
+    emit(srcSize - anchor, 0, 0);
+    return (size_t)(op - dst);
+}
+
+/**
+ * @brief 解压并校验, 输出需恰好为 dstSize
+ */
+static bool Lz4Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+{
+    size_t ip = 0;
+    size_t op = 0;
+    auto readLength = [&](size_t& length) -> bool
+    {
+        uint8_t byte = 255;
+        while (byte == 255)
+        {
+            if (ip >= srcSize)
+            {
+                return false;
+            }
+            byte = src[ip++];
+            length += byte;
+        }
+        return true;
+    };
+    while (ip < srcSize)
+    {
+        uint8_t token = src[ip++];
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(literals))
+        {
+            return false;
+        }
+        if (literals > srcSize - ip || literals > dstSize - op)
+        {
+            return false;
+        }
+        memcpy(dst + op, src + ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == srcSize)
+        {
+            break;
+        }
+        if (srcSize - ip < 2)
+        {
+            return false;
+        }
+        size_t offset = (size_t)src[ip] | ((size_t)src[ip + 1] << 8);
+        ip += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(matchLength))
+        {
+            return false;
+        }
+        matchLength += kLz4MinMatch;
+        if (offset == 0 || offset > op || matchLength > dstSize - op)
+        {
+            return false;
+        }
+        uint8_t* out = dst + op;
+        const uint8_t* ref = out - offset;
+        if (offset >= matchLength)
+        {
+            memcpy(out, ref, matchLength);
+        }
+        else if (offset >= 8)
+        {
+            for (size_t i = 0; i < matchLength; i += 8)
+            {
+                memcpy(out + i, ref + i, std::min((size_t)8, matchLength - i));
+            }
+        }
+        else
+        {
+            // Hint : 重叠拷贝 (如纯色区域 offset 为 1/4), 需逐字节向前复制
+            for (size_t i = 0; i < matchLength; i++)
+            {
+                out[i] = ref[i];
+            }
+        }
+        op += matchLength;
+    }
+    return op == dstSize;
+}
+
+/************************************************** PictureFile **************************************************/
+
+bool PictureFile::Save(const std::string& path, AbstractPicture::ptr picture, PictureCompression compression)
+{
+    if (!picture)
+    {
+        return false;
+    }
+    PictureHeader header;
+    header.info        = picture->info;
+    header.compression = compression;
+    header.payloadSize = picture->GetSize();
+    header.chunkSize   = 0;
+    header.chunkCount  = 0;
+    if (std::none_of(std::begin(kFormatCodes), std::end(kFormatCodes), [&header](const std::pair<PixelFormat, uint32_t>& code) { return code.first == header.info.format; }))
+    {
+        MMP_LOG_ERROR << "Unsupport pixel format : " << header.info.format;
+        return false;
+    }
+    const uint8_t* payload = (const uint8_t*)picture->GetData();
+    std::vector<std::vector<uint8_t>> chunks;
+    if (compression == PictureCompression::LZ4)
+    {
+        header.chunkSize  = kChunkSize;
+        header.chunkCount = (uint32_t)((header.payloadSize + kChunkSize - 1) / kChunkSize);
+        chunks.resize(header.chunkCount);
+        ParallelFor(chunks.size(), [&](size_t i)
+        {
+            size_t offset = i * kChunkSize;
+            size_t size = std::min((size_t)kChunkSize, (size_t)header.payloadSize - offset);
+            std::vector<uint32_t> table;
+            std::vector<uint8_t>& chunk = chunks[i];
+            chunk.resize(Lz4CompressBound(size));
+            chunk.resize(Lz4Compress(payload + offset, size, chunk.data(), table));
+            // Hint : 压缩后不变小的分块原样保存, 解压时以大小相等识别
+            if (chunk.size() >= size)
+            {
+                chunk.assign(payload + offset, payload + offset + size);
+            }
+        });
+    }
+    header.payloadOffset = AlignUp(kPictureHeaderSize + (size_t)header.chunkCount * 4, kPayloadAlign);
+
+    std::ofstream ofs(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open())
+    {
+        MMP_LOG_ERROR << "Open " << path << " fail";
+        return false;
+    }
+    std::vector<uint8_t> head(header.payloadOffset, 0);
+    EncodeHeader(header, head.data());
+    uint64_t storedSize = 0;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        Put32(head.data() + kPictureHeaderSize + i * 4, (uint32_t)chunks[i].size());
+        storedSize += chunks[i].size();
+    }
+    ofs.write((const char*)head.data(), head.size());
+    if (compression == PictureCompression::LZ4)
+    {
+        for (const auto& chunk : chunks)
+        {
+            ofs.write((const char*)chunk.data(), chunk.size());
+        }
+    }
+    else
+    {
+        ofs.write((const char*)payload, header.payloadSize);
+        storedSize = header.payloadSize;
+    }
+    if (ofs.fail())
+    {
+        MMP_LOG_ERROR << "Write " << path << " fail";
+        return false;
+    }
+    MMP_LOG_INFO << "Save picture " << path << " (" << header.info.width << "x" << header.info.height << ", " << header.info.format << ")"
+                 << ", payload : " << header.payloadSize << " bytes, stored : " << storedSize << " bytes";
+    return true;
+}
+
+AbstractPicture::ptr PictureFile::Load(const std::string& path)
+{
+    MappedFile::ptr file = std::make_shared<MappedFile>();
+    if (!file->Open(path))
+    {
+        MMP_LOG_ERROR << "Open " << path << " fail";
+        return nullptr;
+    }
+    PictureHeader header;
+    if (!DecodeHeader(file->GetData(), file->GetSize(), header))
+    {
+        return nullptr;
+    }
+    if (header.compression == PictureCompression::RAW)
+    {
+        if (header.payloadOffset > file->GetSize() || header.payloadSize > file->GetSize() - header.payloadOffset)
+        {
+            MMP_LOG_ERROR << path << " is truncated";
+            return nullptr;
+        }
+        file->WillNeed(header.payloadOffset, header.payloadSize);
+        AbstractAllocateMethod::ptr allocateMethod = std::make_shared<MappedFileAllocateMethod>(file, header.payloadOffset, header.payloadSize);
+        AbstractPicture::ptr picture = std::make_shared<NormalPicture>(header.info, allocateMethod);
+        // Hint : header.info 所需大小超出 payload 时映射无法提供内存 (GetData 为空), 小于 payload 时多余的数据说明文件头有误
+        if (!picture->GetData() || picture->GetSize() != header.payloadSize)
+        {
+            MMP_LOG_ERROR << "Picture size mismatch, expect " << picture->GetSize() << " bytes, payload " << header.payloadSize << " bytes";
+            return nullptr;
+        }
+        return picture;
+    }
+
+    const uint8_t* table = file->GetData() + kPictureHeaderSize;
+    if (kPictureHeaderSize + (size_t)header.chunkCount * 4 > file->GetSize())
+    {
+        MMP_LOG_ERROR << path << " is truncated";
+        return nullptr;
+    }
+    std::vector<uint64_t> offsets(header.chunkCount + 1, header.payloadOffset);
+    for (uint32_t i = 0; i < header.chunkCount; i++)
+    {
+        offsets[i + 1] = offsets[i] + Get32(table + i * 4);
+    }
+    if (offsets.back() > file->GetSize())
+    {
+        MMP_LOG_ERROR << path << " is truncated";
+        return nullptr;
+    }
+    AbstractPicture::ptr picture = std::make_shared<NormalPicture>(header.info);
+    // Hint : 两个方向都要检查, payload 偏小时解压不会写满画面, 偏大时会写越界
+    if (picture->GetSize() != header.payloadSize)
+    {
+        MMP_LOG_ERROR << "Picture size mismatch, expect " << picture->GetSize() << " bytes, payload " << header.payloadSize << " bytes";
+        return nullptr;
+    }
+    uint8_t* data = (uint8_t*)picture->GetData();
+    std::atomic<bool> ok(true);
+    ParallelFor(header.chunkCount, [&](size_t i)
+    {
+        size_t rawOffset = i * header.chunkSize;
+        size_t rawSize = std::min((size_t)header.chunkSize, (size_t)header.payloadSize - rawOffset);
+        size_t storedSize = (size_t)(offsets[i + 1] - offsets[i]);
+        const uint8_t* stored = file->GetData() + offsets[i];
+        if (storedSize == rawSize)
+        {
+            memcpy(data + rawOffset, stored, rawSize);
+        }
+        else if (!Lz4Decompress(stored, storedSize, data + rawOffset, rawSize))
+        {
+            ok = false;
+        }
+    });
+    if (!ok)
+    {
+        MMP_LOG_ERROR << path << " is corrupted";
+        return nullptr;
+    }
+    return picture;
+}
+
+bool PictureFile::ReadInfo(const std::string& path, PixelsInfo& info, PictureCompression& compression)
+{
+    uint8_t data[kPictureHeaderSize];
+    std::ifstream ifs(path, std::ios::in | std::ios::binary);
+    if (!ifs.is_open() || !ifs.read((char*)data, sizeof(data)))
+    {
+        return false;
+    }
+    PictureHeader header;
+    if (!DecodeHeader(data, sizeof(data), header))
+    {
+        return false;
+    }
+    info        = header.info;
+    compression = header.compression;
+    return true;
+}
+
+} // namespace Mmp
@@ -0,0 +1,486 @@
+#include "PipelineGraph.h"
+
+#include <thread>
+#include <chrono>
+#include <sstream>
+#include <algorithm>
+
+#include <Poco/AutoPtr.h>
+
+#include "Common/LogMessage.h"
+
+#include "SampleUtils.h"
+#include "ThreadPlacement.h"
+#include "WorkStealingPool.h"
+
+namespace Mmp
+{
+
+constexpr size_t kDefaultQueueDepth = 2;
+
+static std::vector<std::string> SplitNames(const std::string& value)
+{
+    std::vector<std::string> names;
+    std::stringstream ss(value);
+    std::string name;
+    while (std::getline(ss, name, ','))
+    {
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        if (!name.empty())
+        {
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+/**
+ * @brief 以函数实现的节点
+ */
+class FunctionPipelineNode : public PipelineNode
+{
+public:
+    FunctionPipelineNode(ProcessFunc process, FlushFunc flush)
+    {
+        _process = process;
+        _flush = flush;
+    }
+public:
+    bool Process(PipelineItem& item, PipelineEmitter& emitter) override
+    {
+        return _process(item, emitter);
+    }
+    void Flush(PipelineEmitter& emitter) override
+    {
+        if (_flush)
+        {
+            _flush(emitter);
+        }
+    }
+private:
+    ProcessFunc  _process;
+    FlushFunc    _flush;
+};
+
+/**
+ * @brief 按绝对截止时间节拍转发, 替代各 sample 中的 sleep 循环
+ */
+class RatePipelineNode : public PipelineNode
+{
+public:
+    RatePipelineNode()
+    {
+        _intervalUs = 1000000 / 30;
+        _first = true;
+    }
+public:
+    bool Init(const Poco::Util::AbstractConfiguration& config) override
+    {
+        int fps = config.getInt("fps", 30);
+        _intervalUs = 1000000 / std::max(fps, 1);
+        return true;
+    }
+    bool Process(PipelineItem& item, PipelineEmitter& emitter) override
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (_first || now > _deadline + std::chrono::microseconds(_intervalUs))
+        {
+            // Hint : 首帧或落后超过一帧时重置节拍, 不连续追赶
+            _deadline = now;
+            _first = false;
+        }
+        else
+        {
+            std::this_thread::sleep_until(_deadline);
+        }
+        _deadline += std::chrono::microseconds(_intervalUs);
+        return emitter.Emit(item);
+    }
+private:
+    int64_t                                _intervalUs;
+    bool                                   _first;
+    std::chrono::steady_clock::time_point  _deadline;
+};
+
+class NullPipelineNode : public PipelineNode
+{
+public:
+    bool Process(PipelineItem& item, PipelineEmitter& emitter) override
+    {
+        return true;
+    }
+};
+
+PipelineItem::PipelineItem()
+{
+    index = 0;
+    type = nullptr;
+}
+
+PipelineNode::ptr PipelineNode::Create(ProcessFunc process, FlushFunc flush)
+{
+    return std::make_shared<FunctionPipelineNode>(process, flush);
+}
+
+bool PipelineNode::Init(const Poco::Util::AbstractConfiguration& config)
+{
+    return true;
+}
+
+void PipelineNode::Flush(PipelineEmitter& emitter)
+{
+}
+
+PipelineNodeStats::PipelineNodeStats()
+{
+    itemsIn = 0;
+    itemsOut = 0;
+    busyUs = 0;
+    inputWaitUs = 0;
+    outputWaitUs = 0;
+    latencyUs = 0;
+    queueDepth = 0;
+    queueHighWater = 0;
+}
+
+PipelineEmitter::PipelineEmitter(PipelineGraph& graph, PipelineGraph::Node& node)
+    : _graph(graph), _node(node)
+{
+}
+
+bool PipelineEmitter::Emit(PipelineItem& item)
+{
+    return _graph.Emit(_node, item);
+}
+
+PipelineGraph::PipelineGraph()
+{
+    _stopped = false;
+    _elapsedUs = 0;
+    _creators["rate"] = []() -> PipelineNode::ptr { return std::make_shared<RatePipelineNode>(); };
+    _creators["null"] = []() -> PipelineNode::ptr { return std::make_shared<NullPipelineNode>(); };
+}
+
+PipelineGraph::~PipelineGraph()
+{
+    Stop();
+}
+
+void PipelineGraph::RegisterType(const std::string& type, NodeCreator creator)
+{
+    _creators[type] = creator;
+}
+
+bool PipelineGraph::Build(Poco::Util::AbstractConfiguration& config)
+{
+    _nodes.clear();
+    std::vector<std::string> names = SplitNames(config.getString("pipeline.nodes", ""));
+    if (names.empty())
+    {
+        MMP_LOG_ERROR << "pipeline.nodes is empty";
+        return false;
+    }
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::map<std::string, Node*> byName;
+    size_t callerNodes = 0;
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        const std::string& name = names[i];
+        std::string prefix = "pipeline." + name;
+        if (byName.count(name))
+        {
+            MMP_LOG_ERROR << "Duplicate pipeline node : " << name;
+            return false;
+        }
+        std::unique_ptr<Node> node(new Node());
+        node->stats.name = name;
+        node->stats.type = config.getString(prefix + ".type", name);
+        if (config.has(prefix + ".inputs"))
+        {
+            node->inputNames = SplitNames(config.getString(prefix + ".inputs"));
+        }
+        else if (i > 0)
+        {
+            node->inputNames.push_back(names[i - 1]);
+        }
+        node->runningProducers = (uint32_t)node->inputNames.size();
+        node->onCaller = config.getString(prefix + ".thread", "pool") == "caller";
+        node->placement = -1;
+        std::string placement = config.getString(prefix + ".placement", "");
+        for (size_t stage = 0; stage < (size_t)PipelineStage::COUNT && !placement.empty(); stage++)
+        {
+            if (PipelineStageToStr((PipelineStage)stage) == placement)
+            {
+                node->placement = (int)stage;
+            }
+        }
+        if (!placement.empty() && node->placement < 0)
+        {
+            MMP_LOG_WARN << "Unknown placement stage of pipeline node " << name << " : " << placement;
+        }
+        callerNodes += node->onCaller ? 1 : 0;
+
+        auto creator = _creators.find(node->stats.type);
+        if (creator == _creators.end())
+        {
+            MMP_LOG_ERROR << "Unregistered pipeline node type : " << node->stats.type << " (node " << name << ")";
+            return false;
+        }
+        node->node = creator->second();
+        Poco::AutoPtr<Poco::Util::AbstractConfiguration> view(config.createView(prefix));
+        if (!node->node || !node->node->Init(*view))
+        {
+            MMP_LOG_ERROR << "Init pipeline node fail : " << name;
+            return false;
+        }
+        if (!node->inputNames.empty())
+        {
+            size_t depth = (size_t)std::max(config.getInt(prefix + ".queue_depth", (int)kDefaultQueueDepth), 1);
+            node->input = std::make_shared<BoundedQueue<PipelineItem>>(depth);
+            node->stats.queueDepth = depth;
+        }
+        byName[name] = node.get();
+        nodes.push_back(std::move(node));
+    }
+    if (callerNodes > 1)
+    {
+        MMP_LOG_ERROR << "At most one pipeline node can run on the caller thread";
+        return false;
+    }
+    for (auto& node : nodes)
+    {
+        for (const std::string& input : node->inputNames)
+        {
+            if (!byName.count(input))
+            {
+                MMP_LOG_ERROR << "Unknown input " << input << " of pipeline node " << node->stats.name;
+                return false;
+            }
+            byName[input]->outputs.push_back(node.get());
+        }
+    }
+    // Hint : 按拓扑序排列 (Kahn), 同时检查环; Run 按此顺序提交, 下游先于上游就绪
+    std::map<Node*, size_t> pending;
+    std::vector<Node*> ready;
+    for (auto& node : nodes)
+    {
+        pending[node.get()] = node->inputNames.size();
+        if (node->inputNames.empty())
+        {
+            ready.push_back(node.get());
+        }
+    }
+    std::vector<Node*> order;
+    while (!ready.empty())
+    {
+        Node* node = ready.back();
+        ready.pop_back();
+        order.push_back(node);
+        for (Node* output : node->outputs)
+        {
+            if (--pending[output] == 0)
+            {
+                ready.push_back(output);
+            }
+        }
+    }
+    if (order.size() != nodes.size())
+    {
+        MMP_LOG_ERROR << "Pipeline has a cycle or a node without source";
+        return false;
+    }
+    for (Node* node : order)
+    {
+        for (auto& owned : nodes)
+        {
+            if (owned.get() == node)
+            {
+                _nodes.push_back(std::move(owned));
+                break;
+            }
+        }
+    }
+    _stopped = false;
+    _stopBy.clear();
+    return true;
+}
+
+void PipelineGraph::Run()
+{
+    if (_nodes.empty())
+    {
+        return;
+    }
+    Poco::Timestamp stamp;
+    std::vector<TaskGroup::ptr> tasks;
+    Node* callerNode = nullptr;
+    for (auto it = _nodes.rbegin(); it != _nodes.rend(); it++)
+    {
+        Node* node = it->get();
+        if (node->onCaller)
+        {
+            callerNode = node;
+            continue;
+        }
+        // Hint : 节点在整个运行期间阻塞在队列上, 使用常驻线程槽, 不占用工作线程
+        tasks.push_back(WorkStealingPool::Instance().CommitLongRunning("pipeline." + node->stats.name, [this, node]()
+        {
+            RunNode(*node);
+        }, [this]()
+        {
+            Stop();
+        }));
+    }
+    if (callerNode)
+    {
+        RunNode(*callerNode);
+    }
+    for (auto& task : tasks)
+    {
+        task->Wait();
+    }
+    _elapsedUs = stamp.elapsed();
+}
+
+void PipelineGraph::Stop()
+{
+    _stopped = true;
+    for (auto& node : _nodes)
+    {
+        if (node->input)
+        {
+            node->input->Close();
+        }
+    }
+}
+
+void PipelineGraph::RunNode(Node& node)
+{
+    if (node.placement >= 0)
+    {
+        ThreadPlacement::Instance().Apply((PipelineStage)node.placement);
+    }
+    PipelineEmitter emitter(*this, node);
+    PipelineNodeStats& stats = node.stats;
+    bool keepRunning = true;
+    if (!node.input)
+    {
+        while (!_stopped && keepRunning)
+        {
+            PipelineItem item;
+            Poco::Timestamp stamp;
+            int64_t waitUs = stats.outputWaitUs;
+            keepRunning = node.node->Process(item, emitter);
+            stats.busyUs += stamp.elapsed() - (stats.outputWaitUs - waitUs);
+        }
+    }
+    else
+    {
+        while (keepRunning)
+        {
+            PipelineItem item;
+            Poco::Timestamp waitStamp;
+            if (!node.input->Pop(item))
+            {
+                break;
+            }
+            stats.inputWaitUs += waitStamp.elapsed();
+            stats.itemsIn++;
+            stats.latencyUs += item.born.elapsed();
+            stats.queueHighWater = std::min(std::max(stats.queueHighWater, node.input->Size() + 1), stats.queueDepth);
+            Poco::Timestamp stamp;
+            int64_t waitUs = stats.outputWaitUs;
+            keepRunning = node.node->Process(item, emitter);
+            stats.busyUs += stamp.elapsed() - (stats.outputWaitUs - waitUs);
+        }
+        if (!keepRunning)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mtx);
+                if (_stopBy.empty())
+                {
+                    _stopBy = stats.name;
+                }
+            }
+            Stop();
+        }
+    }
+    if (!_stopped)
+    {
+        Poco::Timestamp stamp;
+        int64_t waitUs = stats.outputWaitUs;
+        node.node->Flush(emitter);
+        stats.busyUs += stamp.elapsed() - (stats.outputWaitUs - waitUs);
+    }
+    for (Node* output : node.outputs)
+    {
+        if (--output->runningProducers == 0)
+        {
+            output->input->Close();
+        }
+    }
+}
+
+bool PipelineGraph::Emit(Node& node, PipelineItem& item)
+{
+    if (!node.input)
+    {
+        item.index = node.stats.itemsOut;
+        item.born.update();
+    }
+    if (node.outputs.empty())
+    {
+        return !_stopped;
+    }
+    bool pushed = false;
+    Poco::Timestamp stamp;
+    for (Node* output : node.outputs)
+    {
+        pushed = output->input->Push(item) || pushed;
+    }
+    node.stats.outputWaitUs += stamp.elapsed();
+    if (pushed)
+    {
+        node.stats.itemsOut++;
+    }
+    return pushed;
+}
+
+std::vector<PipelineNodeStats> PipelineGraph::GetStats()
+{
+    std::vector<PipelineNodeStats> stats;
+    for (auto& node : _nodes)
+    {
+        stats.push_back(node->stats);
+    }
+    return stats;
+}
+
+void PipelineGraph::Report()
+{
+    MMP_LOG_INFO << "Pipeline report, nodes : " << _nodes.size() << ", cost : " << _elapsedUs / 1000 << " ms"
+                 << (_stopBy.empty() ? std::string() : ", stopped by " + _stopBy);
+    for (auto& node : _nodes)
+    {
+        const PipelineNodeStats& stats = node->stats;
+        uint64_t items = node->input ? stats.itemsIn : stats.itemsOut;
+        std::stringstream ss;
+        ss << "-- " << stats.name << " (" << stats.type << ")"
+           << " in : " << stats.itemsIn
+           << ", out : " << stats.itemsOut
+           << ", busy avg : " << (items ? stats.busyUs / (int64_t)items : 0) << " us"
+           << ", input wait : " << stats.inputWaitUs / 1000 << " ms"
+           << ", output wait : " << stats.outputWaitUs / 1000 << " ms";
+        if (node->input)
+        {
+            ss << ", queue : " << stats.queueHighWater << "/" << stats.queueDepth
+               << ", latency avg : " << (stats.itemsIn ? stats.latencyUs / (int64_t)stats.itemsIn : 0) << " us";
+        }
+        MMP_LOG_INFO << ss.str();
+        ReportPerfMetric("pipeline_" + stats.name + "_busy_us", items ? (double)stats.busyUs / items : 0);
+        ReportPerfMetric("pipeline_" + stats.name + "_fps", _elapsedUs > 0 ? items * 1000000.0 / _elapsedUs : 0);
+    }
+}
+
+} // namespace Mmp
@@ -0,0 +1,141 @@
+#include "PresentThread.h"
+
+#include <utility>
+
+#include <Poco/Timestamp.h>
+
+#include "Common/LogMessage.h"
+#include "Common/NormalPicture.h"
+
+#include "ThreadPlacement.h"
+
+namespace Mmp
+{
+
+PresentThread::PresentThread(AbstractDisplay::ptr display, const PixelsInfo& info)
+    : _allocStage("present")
+{
+    _display   = display;
+    _info      = info;
+    _running   = false;
+    _back      = 0;
+    _ready     = 1;
+    _present   = 2;
+    _fresh     = false;
+    _published = 0;
+    _presented = 0;
+    _dropped   = 0;
+    for (size_t i = 0; i < kSlotNum; i++)
+    {
+        _slots[i] = std::make_shared<NormalPicture>(info);
+        // Hint : 放在显示线程所在的 NUMA 节点 (或 placement.memory 指定的节点)
+        ThreadPlacement::Instance().BindMemory(_slots[i]->GetData(), _slots[i]->GetSize());
+    }
+}
+
+PresentThread::~PresentThread()
+{
+    Stop();
+}
+
+void PresentThread::Start()
+{
+    _running = true;
+    _thread = std::thread(&PresentThread::ThreadProc, this);
+}
+
+void PresentThread::Stop()
+{
+    if (!_thread.joinable())
+    {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(_mtx);
+        _cond.wait(lock, [this]() { return !_fresh; });
+        _running = false;
+        _cond.notify_all();
+    }
+    _thread.join();
+    _allocStage.Report();
+    MMP_LOG_INFO << "PresentThread published : " << _published << ", presented : " << _presented << ", dropped : " << _dropped;
+}
+
+AbstractPicture::ptr PresentThread::GetBackBuffer()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _slots[_back];
+}
+
+void PresentThread::Publish()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    std::swap(_back, _ready);
+    if (_fresh)
+    {
+        // Hint : 上一帧还未被显示就被替换
+        _dropped++;
+    }
+    _fresh = true;
+    _published++;
+    _cond.notify_all();
+}
+
+bool PresentThread::IsIdle()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    return !_fresh;
+}
+
+uint64_t PresentThread::GetPublishedCount()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _published;
+}
+
+uint64_t PresentThread::GetPresentedCount()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _presented;
+}
+
+uint64_t PresentThread::GetDroppedCount()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _dropped;
+}
+
+void PresentThread::ThreadProc()
+{
+    ThreadPlacement::Instance().Apply(PipelineStage::DISPLAY);
+    while (true)
+    {
+        AbstractPicture::ptr picture;
+        {
+            std::unique_lock<std::mutex> lock(_mtx);
+            _cond.wait(lock, [this]() { return _fresh || !_running; });
+            if (!_fresh)
+            {
+                break;
+            }
+            std::swap(_ready, _present);
+            _fresh = false;
+            picture = _slots[_present];
+            _cond.notify_all();
+        }
+        _allocStage.Begin();
+        Poco::Timestamp stamp;
+        if (_display)
+        {
+            _display->UpdateWindow((const uint32_t*)(picture->GetData()), _info);
+        }
+        ThreadPlacement::Instance().Sample(PipelineStage::DISPLAY, picture->GetData(), stamp.elapsed());
+        _allocStage.End();
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _presented++;
+        }
+    }
+}
+
+} // namespace Mmp
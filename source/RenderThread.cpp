@@ -0,0 +1,171 @@
+#include "RenderThread.h"
+
+#include <chrono>
+#include <algorithm>
+
+#include <Poco/Timestamp.h>
+
+#include "Common/LogMessage.h"
+#include "GPU/Windows/WindowFactory.h"
+
+#include "ThreadPlacement.h"
+
+namespace Mmp
+{
+
+// Hint : ThreadFrame 耗时低于此值且不需要 present 时视为空转
+constexpr int64_t  kIdleFrameUs     = 20;
+constexpr uint32_t kIdleSpinCount   = 64;
+constexpr uint32_t kMinIdleWaitUs   = 20;
+
+RenderThread::RenderThread(GPUBackend backend)
+{
+    _backend       = backend;
+    _inited        = false;
+    _wake          = false;
+    _maxIdleWaitUs = 1000;
+    _syncCalls     = 0;
+    _loops         = 0;
+    _idleWaits     = 0;
+    _idleWaitUs    = 0;
+}
+
+RenderThread::SyncScope::SyncScope(RenderThread& thread)
+    : _thread(thread)
+{
+    _thread._syncCalls++;
+    _thread.Wake();
+}
+
+RenderThread::SyncScope::~SyncScope()
+{
+    _thread._syncCalls--;
+}
+
+RenderThread::~RenderThread()
+{
+    if (_thread.joinable())
+    {
+        Stop();
+    }
+}
+
+bool RenderThread::Start(bool waitReady)
+{
+    _thread = std::thread(&RenderThread::ThreadProc, this);
+    return waitReady ? WaitReady() : true;
+}
+
+bool RenderThread::WaitReady()
+{
+    std::unique_lock<std::mutex> lock(_mtx);
+    _cond.wait(lock, [this]() { return _inited; });
+    return _draw != nullptr;
+}
+
+void RenderThread::Stop()
+{
+    if (!_thread.joinable())
+    {
+        return;
+    }
+    // Hint : _draw 由渲染线程赋值, WaitReady 之后读取才是同步的 (Start(false) 后立即 Stop 时尚未赋值)
+    if (WaitReady())
+    {
+        _draw->ThreadStop();
+    }
+    Wake();
+    _thread.join();
+    MMP_LOG_INFO << "RenderThread loops : " << _loops << ", idle waits : " << _idleWaits << ", idle wait time : " << _idleWaitUs / 1000 << " ms";
+}
+
+void RenderThread::Wake()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    _wake = true;
+    _cond.notify_all();
+}
+
+void RenderThread::SetMaxIdleWait(uint32_t us)
+{
+    _maxIdleWaitUs = std::max(us, kMinIdleWaitUs);
+}
+
+void RenderThread::IdleWait(uint32_t us)
+{
+    Poco::Timestamp stamp;
+    {
+        std::unique_lock<std::mutex> lock(_mtx);
+        _cond.wait_for(lock, std::chrono::microseconds(us), [this]() { return _wake || _syncCalls > 0; });
+        _wake = false;
+    }
+    _idleWaits++;
+    _idleWaitUs += stamp.elapsed();
+}
+
+void RenderThread::ThreadProc()
+{
+    ThreadPlacement::Instance().Apply(PipelineStage::RENDER);
+    GLDrawContex::SetGPUBackendType(_backend);
+    _window = WindowFactory::DefaultFactory().createWindow(WindowFactory::DefaultFactory().GetGuessClassName(_backend));
+    _window->SetRenderMode(false);
+    _window->Open();
+    _window->BindRenderThread(true);
+    GLDrawContex::ptr draw = GLDrawContex::Instance();
+    if (draw)
+    {
+        draw->SetWindows(_window);
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _draw = draw;
+        _inited = true;
+        _cond.notify_all();
+    }
+    if (!draw)
+    {
+        MMP_LOG_ERROR << "Create draw context fail, backend is: " << _backend;
+        _window->BindRenderThread(false);
+        _window->Close();
+        return;
+    }
+    _draw->ThreadStart();
+    uint32_t idleCount = 0;
+    uint32_t idleWaitUs = kMinIdleWaitUs;
+    while (true)
+    {
+        Poco::Timestamp stamp;
+        GpuTaskStatus status = _draw->ThreadFrame();
+        _loops++;
+        if (status == GpuTaskStatus::EXIT)
+        {
+            break;
+        }
+        else if (status == GpuTaskStatus::PRESENT)
+        {
+            _window->Swap();
+        }
+        else if (stamp.elapsed() < kIdleFrameUs)
+        {
+            idleCount++;
+            if (idleCount < kIdleSpinCount || _syncCalls > 0)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                IdleWait(idleWaitUs);
+                idleWaitUs = std::min(idleWaitUs * 2, _maxIdleWaitUs.load());
+            }
+            continue;
+        }
+        ThreadPlacement::Instance().Sample(PipelineStage::RENDER, nullptr, stamp.elapsed());
+        idleCount = 0;
+        idleWaitUs = kMinIdleWaitUs;
+    }
+    _draw->ThreadEnd();
+    _window->BindRenderThread(false);
+    _window->Close();
+}
+
+} // namespace Mmp
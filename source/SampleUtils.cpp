@@ -1,25 +1,32 @@
 #include "SampleUtils.h"
 
+#include <cstdlib>
 #include <cstring>
+#include <iomanip>
+#include <sstream>
 #include <memory.h>
 
+#include <Poco/File.h>
+
 #include "GPU/GL/GLCommon.h"
 #include "Codec/CodecFactory.h"
+#include "Common/LogMessage.h"
 
+#include "PictureFile.h"
 #include "PngA.h"
 #include "PngB.h"
 
 namespace Mmp
 {
 
-AbstractPicture::ptr GetFrame1920x1080A()
+AbstractPicture::ptr DecodePng(const uint8_t* data, size_t size)
 {
     using namespace Codec;
     // 1 - Read compress data from png array
     NormalPack::ptr pack = std::make_shared<NormalPack>(0);
-    pack->SetCapacity(sizeof(bin2c_A_png));
-    pack->SetSize((size_t)(sizeof(bin2c_A_png)));
-    memcpy(pack->GetData(), bin2c_A_png, sizeof(bin2c_A_png));
+    pack->SetCapacity(size);
+    pack->SetSize(size);
+    memcpy(pack->GetData(), data, size);
     // 2 - decoder to pixel data
     AbstractFrame::ptr frame;
     {
@@ -40,32 +47,59 @@ AbstractPicture::ptr GetFrame1920x1080A()
     return std::dynamic_pointer_cast<AbstractPicture>(frame);
 }
 
-AbstractPicture::ptr GetFrame1920x1080B()
+static std::string& AssetDirectory()
 {
-    using namespace Codec;
-    // 1 - Read compress data from png array
-    NormalPack::ptr pack = std::make_shared<NormalPack>(0);
-    pack->SetCapacity(sizeof(bin2c_B_png));
-    pack->SetSize((size_t)(sizeof(bin2c_B_png)));
-    memcpy(pack->GetData(), bin2c_B_png, sizeof(bin2c_B_png));
-    // 2 - decoder to pixel data
-    AbstractFrame::ptr frame;
+    static std::string dir = []() -> std::string
     {
-        auto pngDecoder = DecoderFactory::DefaultFactory().CreateDecoder("PngDecoder");
-        pngDecoder->Init();
-        pngDecoder->Start();
-        PngDecoderParameter parameter;
-        parameter.format = PixelFormat::RGBA8888;
-        pngDecoder->SetParameter(parameter);
-        pngDecoder->Push(pack);
-        if (!pngDecoder->Pop(frame))
+        const char* env = std::getenv("MMP_SAMPLE_ASSET_DIR");
+        if (env)
         {
-            assert(false);
+            return env;
         }
-        pngDecoder->Stop();
-        pngDecoder->Uninit();
+#ifdef MMP_SAMPLE_ASSET_DIR
+        return MMP_SAMPLE_ASSET_DIR;
+#else
+        return "";
+#endif
+    }();
+    return dir;
+}
+
+void SetAssetDirectory(const std::string& dir)
+{
+    AssetDirectory() = dir;
+}
+
+const std::string& GetAssetDirectory()
+{
+    return AssetDirectory();
+}
+
+AbstractPicture::ptr LoadAsset(const std::string& name)
+{
+    if (AssetDirectory().empty())
+    {
+        return nullptr;
     }
-    return std::dynamic_pointer_cast<AbstractPicture>(frame);
+    std::string path = AssetDirectory() + "/" + name + ".mpic";
+    if (!Poco::File(path).exists())
+    {
+        return nullptr;
+    }
+    return PictureFile::Load(path);
+}
+
+AbstractPicture::ptr GetFrame1920x1080A()
+{
+    // Hint : 优先 mmap 预解码的资源, 不存在时才解码内嵌的 PNG
+    AbstractPicture::ptr picture = LoadAsset("A");
+    return picture ? picture : DecodePng(bin2c_A_png, sizeof(bin2c_A_png));
+}
+
+AbstractPicture::ptr GetFrame1920x1080B()
+{
+    AbstractPicture::ptr picture = LoadAsset("B");
+    return picture ? picture : DecodePng(bin2c_B_png, sizeof(bin2c_B_png));
 }
 
 GPUBackend GetGPUBackend(const std::string& str)
@@ -92,4 +126,12 @@ GPUBackend GetGPUBackend(const std::string& str)
     }
 }
 
+void ReportPerfMetric(const std::string& name, double value)
+{
+    // Hint : 固定小数格式输出, 默认格式对大数 / 极小数会输出科学计数法, cmake/PerfCheck.cmake 无法解析
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(3) << value;
+    MMP_LOG_INFO << "PERF " << name << " " << ss.str();
+}
+
 } // namespace Mmp
\ No newline at end of file
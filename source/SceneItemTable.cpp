@@ -0,0 +1,139 @@
+#include "SceneItemTable.h"
+
+#include <cassert>
+
+namespace Mmp
+{
+
+SceneItemTable::SceneItemTable(Gpu::AbstractSceneLayer::ptr layer)
+{
+    _layer      = layer;
+    _dirtyCount = 0;
+    _size       = 0;
+}
+
+SceneItemTable::~SceneItemTable()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    for (SceneItemHandle handle=0; handle<(SceneItemHandle)_items.size(); handle++)
+    {
+        if (_items[handle])
+        {
+            _layer->DelSceneItem(_tags[handle]);
+        }
+    }
+}
+
+SceneItemHandle SceneItemTable::Add(Gpu::AbstractSceneItem::ptr item, const Gpu::SceneItemParam& param)
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    SceneItemHandle handle = kInvalidSceneItemHandle;
+    if (!_freeHandles.empty())
+    {
+        handle = _freeHandles.back();
+        _freeHandles.pop_back();
+    }
+    else
+    {
+        handle = (SceneItemHandle)_items.size();
+        _items.emplace_back();
+        _tags.push_back("item_" + std::to_string(handle));
+        _params.emplace_back();
+        _dirty.push_back(0);
+    }
+    _items[handle]     = item;
+    _params[handle]    = param;
+    if (_dirty[handle])
+    {
+        _dirty[handle] = 0;
+        _dirtyCount--;
+    }
+    item->SetParam(param);
+    _layer->AddSceneItem(_tags[handle], item);
+    _size++;
+    return handle;
+}
+
+bool SceneItemTable::Remove(SceneItemHandle handle)
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (handle >= _items.size() || !_items[handle])
+    {
+        return false;
+    }
+    _layer->DelSceneItem(_tags[handle]);
+    _items[handle].reset();
+    if (_dirty[handle])
+    {
+        _dirty[handle] = 0;
+        _dirtyCount--;
+    }
+    _freeHandles.push_back(handle);
+    _size--;
+    return true;
+}
+
+bool SceneItemTable::SetParams(SceneItemHandle first, const Gpu::SceneItemParam* params, size_t count)
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    if ((size_t)first + count > _items.size())
+    {
+        assert(false);
+        return false;
+    }
+    for (size_t i=0; i<count; i++)
+    {
+        size_t handle = first + i;
+        _params[handle] = params[i];
+        if (!_dirty[handle] && _items[handle])
+        {
+            _dirty[handle] = 1;
+            _dirtyCount++;
+        }
+    }
+    return true;
+}
+
+bool SceneItemTable::SetParam(SceneItemHandle handle, const Gpu::SceneItemParam& param)
+{
+    return SetParams(handle, &param, 1);
+}
+
+void SceneItemTable::Draw(Texture::ptr framebuffer)
+{
+    Commit();
+    _layer->Draw(framebuffer);
+}
+
+size_t SceneItemTable::Size()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _size;
+}
+
+Gpu::AbstractSceneItem::ptr SceneItemTable::GetItem(SceneItemHandle handle)
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    return handle < _items.size() ? _items[handle] : nullptr;
+}
+
+void SceneItemTable::Commit()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (_dirtyCount == 0)
+    {
+        return;
+    }
+    for (size_t handle=0; handle<_items.size() && _dirtyCount; handle++)
+    {
+        if (!_dirty[handle])
+        {
+            continue;
+        }
+        _items[handle]->SetParam(_params[handle]);
+        _dirty[handle] = 0;
+        _dirtyCount--;
+    }
+}
+
+} // namespace Mmp
@@ -0,0 +1,40 @@
+#include "StartupTimeline.h"
+
+#include <algorithm>
+
+#include "Common/LogMessage.h"
+
+namespace Mmp
+{
+
+StartupTimeline::StartupTimeline()
+{
+    _origin.update();
+}
+
+void StartupTimeline::Record(const std::string& step, const Poco::Timestamp& begin)
+{
+    Poco::Timestamp end;
+    std::lock_guard<std::mutex> lock(_mtx);
+    _steps.push_back({step, begin - _origin, end - _origin});
+}
+
+void StartupTimeline::Dump()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    std::sort(_steps.begin(), _steps.end(), [](const Step& left, const Step& right)
+    {
+        return left.beginUs < right.beginUs;
+    });
+    int64_t lastEndUs = 0;
+    MMP_LOG_INFO << "Startup timeline (ms)";
+    for (const auto& step : _steps)
+    {
+        MMP_LOG_INFO << "-- [" << step.beginUs / 1000 << ", " << step.endUs / 1000 << "] "
+                     << step.name << " : " << (step.endUs - step.beginUs) / 1000 << " ms";
+        lastEndUs = std::max(lastEndUs, step.endUs);
+    }
+    MMP_LOG_INFO << "-- time to first frame : " << lastEndUs / 1000 << " ms";
+}
+
+} // namespace Mmp
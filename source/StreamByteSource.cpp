@@ -0,0 +1,325 @@
+#include "StreamByteSource.h"
+
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#include "Common/LogMessage.h"
+
+namespace Mmp
+{
+
+constexpr size_t   kReceiveChunk   = 64 * 1024;
+constexpr int      kPollTimeoutMs  = 50;
+constexpr uint32_t kReadSpinCount  = 64;
+
+StreamByteSource::StreamByteSource(size_t ringSize)
+    : _ring(ringSize)
+{
+    _kind          = Kind::PIPE;
+    _fd            = -1;
+    _listenFd      = -1;
+    _running       = false;
+    _finished      = false;
+    _eof           = false;
+    _receivedBytes = 0;
+    _droppedBytes  = 0;
+}
+
+StreamByteSource::~StreamByteSource()
+{
+    Close();
+}
+
+bool StreamByteSource::Open(const std::string& url)
+{
+    bool res = false;
+    if (url == "-" || url == "stdin")
+    {
+        _kind = Kind::PIPE;
+        _fd = 0;
+        res = true;
+    }
+#ifndef _WIN32
+    else if (url.rfind("pipe://", 0) == 0)
+    {
+        _kind = Kind::PIPE;
+        _fd = open(url.substr(7).c_str(), O_RDONLY);
+        res = _fd >= 0;
+    }
+    else if (url.rfind("udp://", 0) == 0)
+    {
+        _kind = Kind::UDP;
+        res = OpenUdp(url.substr(6));
+    }
+    else if (url.rfind("unix://", 0) == 0)
+    {
+        _kind = Kind::UNIX;
+        res = OpenUnix(url.substr(7));
+    }
+#endif
+    if (!res)
+    {
+        MMP_LOG_ERROR << "StreamByteSource open fail, url is: " << url;
+        return false;
+    }
+    _running = true;
+    _thread = std::thread(&StreamByteSource::ReceiveProc, this);
+    return true;
+}
+
+void StreamByteSource::Close()
+{
+    if (!_thread.joinable())
+    {
+        return;
+    }
+    _running = false;
+    _thread.join();
+#ifndef _WIN32
+    if (_fd > 0)
+    {
+        close(_fd);
+    }
+    if (_listenFd >= 0)
+    {
+        close(_listenFd);
+        unlink(_unixPath.c_str());
+    }
+#endif
+    _fd = -1;
+    _listenFd = -1;
+    MMP_LOG_INFO << "StreamByteSource received : " << _receivedBytes << " bytes, dropped : " << _droppedBytes << " bytes";
+}
+
+size_t StreamByteSource::Read(void* data, size_t bytes)
+{
+    uint32_t spin = 0;
+    while (true)
+    {
+        // Hint : 先读取 _finished, 保证其置位前写入的数据都能被读到
+        bool finished = _finished.load(std::memory_order_acquire);
+        size_t n = _ring.Read(data, bytes);
+        if (n != 0)
+        {
+            return n;
+        }
+        if (finished)
+        {
+            _eof = true;
+            return 0;
+        }
+        if (spin++ < kReadSpinCount)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+}
+
+bool StreamByteSource::eof()
+{
+    return _eof;
+}
+
+uint64_t StreamByteSource::GetReceivedBytes()
+{
+    return _receivedBytes;
+}
+
+uint64_t StreamByteSource::GetDroppedBytes()
+{
+    return _droppedBytes;
+}
+
+bool StreamByteSource::PushReliable(const uint8_t* data, size_t bytes)
+{
+    while (bytes != 0)
+    {
+        size_t n = _ring.Write(data, bytes);
+        data += n;
+        bytes -= n;
+        if (bytes != 0)
+        {
+            if (!_running)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+    return true;
+}
+
+#ifdef _WIN32
+
+bool StreamByteSource::OpenUdp(const std::string& /* address */)
+{
+    return false;
+}
+
+bool StreamByteSource::OpenUnix(const std::string& /* path */)
+{
+    return false;
+}
+
+bool StreamByteSource::WaitReadable(int /* fd */)
+{
+    return true;
+}
+
+void StreamByteSource::ReceiveProc()
+{
+    std::vector<uint8_t> chunk(kReceiveChunk);
+    while (_running)
+    {
+        size_t n = fread(chunk.data(), 1, chunk.size(), stdin);
+        if (n == 0 || !PushReliable(chunk.data(), n))
+        {
+            break;
+        }
+        _receivedBytes += n;
+    }
+    _finished.store(true, std::memory_order_release);
+}
+
+#else
+
+bool StreamByteSource::OpenUdp(const std::string& address)
+{
+    size_t pos = address.rfind(':');
+    if (pos == std::string::npos)
+    {
+        return false;
+    }
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)std::stoi(address.substr(pos + 1)));
+    if (inet_pton(AF_INET, address.substr(0, pos).c_str(), &addr.sin_addr) != 1)
+    {
+        return false;
+    }
+    _fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (_fd < 0)
+    {
+        return false;
+    }
+    int rcvbuf = 8 * 1024 * 1024;
+    setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if (bind(_fd, (sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        close(_fd);
+        _fd = -1;
+        return false;
+    }
+    return true;
+}
+
+bool StreamByteSource::OpenUnix(const std::string& path)
+{
+    sockaddr_un addr = {};
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size());
+    _listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_listenFd < 0)
+    {
+        return false;
+    }
+    unlink(path.c_str());
+    if (bind(_listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(_listenFd, 1) != 0)
+    {
+        close(_listenFd);
+        _listenFd = -1;
+        return false;
+    }
+    _unixPath = path;
+    return true;
+}
+
+bool StreamByteSource::WaitReadable(int fd)
+{
+    pollfd pfd = {};
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    while (_running)
+    {
+        int res = poll(&pfd, 1, kPollTimeoutMs);
+        if (res > 0)
+        {
+            return true;
+        }
+        else if (res < 0)
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+void StreamByteSource::ReceiveProc()
+{
+    std::vector<uint8_t> chunk(kReceiveChunk);
+    if (_kind == Kind::UNIX)
+    {
+        if (WaitReadable(_listenFd))
+        {
+            _fd = accept(_listenFd, nullptr, nullptr);
+        }
+        if (_fd < 0)
+        {
+            _finished.store(true, std::memory_order_release);
+            return;
+        }
+    }
+    while (_running && WaitReadable(_fd))
+    {
+        ssize_t n = _kind == Kind::UDP ? recv(_fd, chunk.data(), chunk.size(), 0) : read(_fd, chunk.data(), chunk.size());
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            // Hint : UDP 不存在结束标识, 空数据报视为发送端结束
+            break;
+        }
+        _receivedBytes += (uint64_t)n;
+        if (_kind == Kind::UDP)
+        {
+            if (_ring.Free() < (size_t)n)
+            {
+                _droppedBytes += (uint64_t)n;
+                continue;
+            }
+            _ring.Write(chunk.data(), (size_t)n);
+        }
+        else if (!PushReliable(chunk.data(), (size_t)n))
+        {
+            break;
+        }
+    }
+    _finished.store(true, std::memory_order_release);
+}
+
+#endif
+
+} // namespace Mmp
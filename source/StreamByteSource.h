@@ -0,0 +1,71 @@
+//
+// StreamByteSource.h
+//
+// Library: Common
+// Package: Stream
+// Module:  ByteSource
+//
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
+#include "AbstractByteSource.h"
+#include "SpscByteRing.h"
+
+namespace Mmp
+{
+
+/**
+ * @brief  管道/套接字输入源
+ * @note   1 - 接收线程负责所有系统调用, 数据写入 SpscByteRing, Read 只访问环形缓冲
+ *         2 - 管道及 Unix 套接字为可靠流, 环形缓冲满时接收线程等待 (反压)
+ *         3 - UDP 按数据报接收, 环形缓冲剩余空间不足时丢弃整个数据报并计数
+ *         4 - Windows 下仅支持标准输入
+ */
+class StreamByteSource : public AbstractByteSource
+{
+public:
+    explicit StreamByteSource(size_t ringSize = 16 * 1024 * 1024);
+    ~StreamByteSource();
+public:
+    bool Open(const std::string& url) override;
+    void Close() override;
+    size_t Read(void* data, size_t bytes) override;
+    bool eof() override;
+public:
+    uint64_t GetReceivedBytes();
+    uint64_t GetDroppedBytes();
+private:
+    enum class Kind
+    {
+        PIPE,
+        UDP,
+        UNIX
+    };
+    bool OpenUdp(const std::string& address);
+    bool OpenUnix(const std::string& path);
+    void ReceiveProc();
+    /**
+     * @brief      等待 fd 可读, 期间检查 _running
+     */
+    bool WaitReadable(int fd);
+    bool PushReliable(const uint8_t* data, size_t bytes);
+private:
+    Kind                   _kind;
+    int                    _fd;
+    int                    _listenFd;
+    std::string            _unixPath;
+    SpscByteRing           _ring;
+    std::thread            _thread;
+    std::atomic<bool>      _running;
+    std::atomic<bool>      _finished;
+    bool                   _eof;
+private: /* statistics */
+    std::atomic<uint64_t>  _receivedBytes;
+    std::atomic<uint64_t>  _droppedBytes;
+};
+
+} // namespace Mmp
@@ -0,0 +1,501 @@
+#include "ThreadPlacement.h"
+
+#include <cmath>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include <Poco/Timestamp.h>
+
+#include "Common/Promise.h"
+#include "Common/ThreadPool.h"
+#include "Common/LogMessage.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace Mmp
+{
+
+#if defined(__linux__)
+// Hint : 与 <numaif.h> 中的定义一致, 直接使用系统调用, 不依赖 libnuma
+constexpr int kMpolBind    = 2;
+constexpr int kMpolFNode   = 1 << 0;
+constexpr int kMpolFAddr   = 1 << 1;
+constexpr int kMpolMfMove  = 1 << 1;
+#endif
+
+constexpr int64_t kPoolBarrierTimeoutUs = 1000 * 1000;
+
+const std::string& PipelineStageToStr(PipelineStage stage)
+{
+    static const std::string names[] = {"render", "pool", "decode", "display", "main", "unknown"};
+    size_t index = std::min((size_t)stage, (size_t)PipelineStage::COUNT);
+    return names[index];
+}
+
+/**
+ * @brief 解析 "0-3,8,10-11" 格式的 cpu 列表
+ */
+static bool ParseCpuList(const std::string& list, std::vector<int>& cpus)
+{
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ','))
+    {
+        if (range.empty() || range == "\n")
+        {
+            continue;
+        }
+        try
+        {
+            std::string::size_type pos = range.find('-');
+            int first = std::stoi(range.substr(0, pos));
+            int last  = pos == std::string::npos ? first : std::stoi(range.substr(pos + 1));
+            if (first < 0 || last < first)
+            {
+                return false;
+            }
+            for (int cpu = first; cpu <= last; cpu++)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+    return !cpus.empty();
+}
+
+ThreadPlacement& ThreadPlacement::Instance()
+{
+    static ThreadPlacement gInstance;
+    return gInstance;
+}
+
+ThreadPlacement::ThreadPlacement()
+{
+    _memoryNode = -1;
+    for (auto& stage : _stages)
+    {
+        stage.node      = -1;
+        stage.samples   = 0;
+        stage.crossNode = 0;
+        stage.nodeKnown = 0;
+        stage.sumUs     = 0;
+        stage.sumSqUs   = 0;
+        stage.maxUs     = 0;
+    }
+#if defined(__linux__)
+    for (int node = 0; ; node++)
+    {
+        std::ifstream ifs("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!ifs.is_open())
+        {
+            break;
+        }
+        std::string list;
+        std::getline(ifs, list);
+        std::vector<int> cpus;
+        ParseCpuList(list, cpus);
+        _nodeCpus.push_back(cpus);
+    }
+#endif
+}
+
+bool ThreadPlacement::ParseSpec(const std::string& spec, std::vector<int>& cpus, int& node)
+{
+    cpus.clear();
+    node = -1;
+    if (spec.empty() || spec == "none")
+    {
+        return true;
+    }
+    if (spec.compare(0, 4, "cpu:") == 0)
+    {
+        return ParseCpuList(spec.substr(4), cpus);
+    }
+    else if (spec.compare(0, 5, "node:") == 0)
+    {
+        try
+        {
+            node = std::stoi(spec.substr(5));
+        }
+        catch (...)
+        {
+            return false;
+        }
+        if (node < 0 || node >= (int)_nodeCpus.size())
+        {
+            MMP_LOG_WARN << "NUMA node " << node << " not found, available nodes : " << _nodeCpus.size();
+            node = -1;
+            return false;
+        }
+        cpus = _nodeCpus[node];
+        return true;
+    }
+    return false;
+}
+
+void ThreadPlacement::Load(const Poco::Util::AbstractConfiguration& config)
+{
+    for (size_t i = 0; i < (size_t)PipelineStage::COUNT; i++)
+    {
+        std::string key = "placement." + PipelineStageToStr((PipelineStage)i);
+        if (config.has(key))
+        {
+            Set((PipelineStage)i, config.getString(key));
+        }
+    }
+    if (config.has("placement.memory"))
+    {
+        std::vector<int> cpus;
+        int node = -1;
+        std::string spec = config.getString("placement.memory");
+        if (spec.compare(0, 5, "node:") != 0)
+        {
+            spec = "node:" + spec;
+        }
+        if (ParseSpec(spec, cpus, node))
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _memoryNode = node;
+        }
+        else
+        {
+            MMP_LOG_WARN << "Invalid placement.memory : " << config.getString("placement.memory");
+        }
+    }
+}
+
+bool ThreadPlacement::Set(PipelineStage stage, const std::string& spec)
+{
+    std::vector<int> cpus;
+    int node = -1;
+    if (!ParseSpec(spec, cpus, node))
+    {
+        MMP_LOG_WARN << "Invalid placement for " << PipelineStageToStr(stage) << " : " << spec << ", expect cpu:<list> or node:<id>";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(_mtx);
+    StageInfo& info = _stages[(size_t)stage];
+    info.spec = spec;
+    info.cpus = cpus;
+    info.node = node;
+    return true;
+}
+
+bool ThreadPlacement::Apply(PipelineStage stage)
+{
+    std::vector<int> cpus;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        cpus = _stages[(size_t)stage].cpus;
+    }
+    if (cpus.empty())
+    {
+        return false;
+    }
+    bool ret = false;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+    ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus)
+    {
+        if (cpu < (int)(sizeof(DWORD_PTR) * 8))
+        {
+            mask |= (DWORD_PTR)1 << cpu;
+        }
+    }
+    ret = mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#endif
+    if (!ret)
+    {
+        MMP_LOG_WARN << "Apply placement for " << PipelineStageToStr(stage) << " fail";
+    }
+    return ret;
+}
+
+void ThreadPlacement::ApplyThreadPool(uint32_t workers)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_stages[(size_t)PipelineStage::POOL].cpus.empty())
+        {
+            return;
+        }
+    }
+    class Barrier
+    {
+    public:
+        explicit Barrier(uint32_t workers) : arrived(0), broken(false), missed(workers, 0), threads(workers) {}
+    public:
+        std::atomic<uint32_t>         arrived;
+        std::atomic<bool>             broken;
+        std::vector<uint8_t>          missed;   // 按任务序号, 各任务只写自己的位置
+        std::vector<std::thread::id>  threads;
+    };
+    std::shared_ptr<Barrier> barrier = std::make_shared<Barrier>(workers);
+    std::vector<Promise<void>::ptr> tasks;
+    for (uint32_t i = 0; i < workers; i++)
+    {
+        Promise<void>::ptr task = std::make_shared<Promise<void>>([this, barrier, workers, i]()
+        {
+            barrier->threads[i] = std::this_thread::get_id();
+            // Hint : 屏障已超时, 本任务可能落在已绑定过的工作线程上
+            if (barrier->broken)
+            {
+                barrier->missed[i] = 1;
+                return;
+            }
+            Apply(PipelineStage::POOL);
+            barrier->arrived++;
+            // Hint : 占住当前工作线程, 使剩余任务落到其他工作线程上
+            Poco::Timestamp stamp;
+            while (barrier->arrived < workers)
+            {
+                if (stamp.elapsed() >= kPoolBarrierTimeoutUs)
+                {
+                    barrier->broken = true;
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+        ThreadPool::ThreadPoolSingleton()->Commit(task);
+        tasks.push_back(task);
+    }
+    for (auto& task : tasks)
+    {
+        task->Wait();
+    }
+    if (barrier->broken)
+    {
+        std::vector<std::thread::id> bound;
+        std::string missed;
+        for (uint32_t i = 0; i < workers; i++)
+        {
+            if (barrier->missed[i])
+            {
+                missed += (missed.empty() ? "" : ",") + std::to_string(i);
+            }
+            else if (std::find(bound.begin(), bound.end(), barrier->threads[i]) == bound.end())
+            {
+                bound.push_back(barrier->threads[i]);
+            }
+        }
+        MMP_LOG_WARN << "ThreadPool placement barrier timeout, bound workers : " << bound.size() << "/" << workers
+                     << ", tasks missed the barrier : " << (missed.empty() ? "none" : missed)
+                     << ", the pool may have fewer threads than " << workers;
+    }
+}
+
+int ThreadPlacement::GetMemoryNode()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _memoryNode >= 0 ? _memoryNode : _stages[(size_t)PipelineStage::DISPLAY].node;
+}
+
+bool ThreadPlacement::BindMemory(void* data, size_t size)
+{
+    int node = GetMemoryNode();
+    if (node < 0 || !data || size == 0)
+    {
+        return false;
+    }
+#if defined(__linux__)
+    uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin = ((uintptr_t)data + pageSize - 1) & ~(pageSize - 1);
+    uintptr_t end   = ((uintptr_t)data + size) & ~(pageSize - 1);
+    if (end <= begin)
+    {
+        return false;
+    }
+    unsigned long mask[16] = {0};
+    if (node >= (int)(sizeof(mask) * 8))
+    {
+        return false;
+    }
+    mask[node / (sizeof(unsigned long) * 8)] |= 1UL << (node % (sizeof(unsigned long) * 8));
+    if (syscall(SYS_mbind, (void*)begin, (unsigned long)(end - begin), kMpolBind, mask, (unsigned long)(sizeof(mask) * 8), kMpolMfMove) != 0)
+    {
+        MMP_LOG_WARN << "Bind " << (end - begin) / 1024 << " KB to NUMA node " << node << " fail, errno : " << errno;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+int ThreadPlacement::GetNodeCount()
+{
+    return (int)Instance()._nodeCpus.size();
+}
+
+int ThreadPlacement::GetCurrentNode()
+{
+#if defined(__linux__)
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+    {
+        return (int)node;
+    }
+#endif
+    return -1;
+}
+
+int ThreadPlacement::GetNodeOfAddress(const void* data)
+{
+#if defined(__linux__)
+    int node = -1;
+    if (data && syscall(SYS_get_mempolicy, &node, nullptr, 0UL, data, (unsigned long)(kMpolFNode | kMpolFAddr)) == 0)
+    {
+        return node;
+    }
+#endif
+    (void)data;
+    return -1;
+}
+
+void ThreadPlacement::Sample(PipelineStage stage, const void* buffer, int64_t costUs)
+{
+    // Hint : 单节点机器上不存在跨节点访问, 省去两次系统调用
+    int bufferNode = -1;
+    int threadNode = -1;
+    if (buffer && _nodeCpus.size() > 1)
+    {
+        bufferNode = GetNodeOfAddress(buffer);
+        threadNode = GetCurrentNode();
+    }
+    // Hint : 计数只由当前线程写入, load + store 即可, 无需加锁或原子读改写
+    StageCounter& counter = GetThreadCounters().stages[(size_t)stage];
+    counter.samples.store(counter.samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    counter.sumUs.store(counter.sumUs.load(std::memory_order_relaxed) + (double)costUs, std::memory_order_relaxed);
+    counter.sumSqUs.store(counter.sumSqUs.load(std::memory_order_relaxed) + (double)costUs * costUs, std::memory_order_relaxed);
+    counter.maxUs.store(std::max(counter.maxUs.load(std::memory_order_relaxed), costUs), std::memory_order_relaxed);
+    if (bufferNode >= 0 && threadNode >= 0)
+    {
+        counter.nodeKnown.store(counter.nodeKnown.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (bufferNode != threadNode)
+        {
+            counter.crossNode.store(counter.crossNode.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+}
+
+ThreadPlacement::StageCounter::StageCounter()
+{
+    samples   = 0;
+    crossNode = 0;
+    nodeKnown = 0;
+    sumUs     = 0;
+    sumSqUs   = 0;
+    maxUs     = 0;
+}
+
+ThreadPlacement::ThreadCounters& ThreadPlacement::GetThreadCounters()
+{
+    // Hint : 线程退出时将计数并入总计, 避免 Report 访问已销毁的 thread_local
+    class Holder
+    {
+    public:
+        Holder() { counters = ThreadPlacement::Instance().AcquireCounters(); }
+        ~Holder() { ThreadPlacement::Instance().ReleaseCounters(counters); }
+    public:
+        ThreadCounters* counters;
+    };
+    static thread_local Holder holder;
+    return *holder.counters;
+}
+
+ThreadPlacement::ThreadCounters* ThreadPlacement::AcquireCounters()
+{
+    ThreadCounters* counters = new ThreadCounters();
+    std::lock_guard<std::mutex> lock(_mtx);
+    _threadCounters.push_back(counters);
+    return counters;
+}
+
+void ThreadPlacement::ReleaseCounters(ThreadCounters* counters)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        for (size_t i = 0; i < (size_t)PipelineStage::COUNT; i++)
+        {
+            StageInfo& info = _stages[i];
+            const StageCounter& counter = counters->stages[i];
+            info.samples   += counter.samples;
+            info.crossNode += counter.crossNode;
+            info.nodeKnown += counter.nodeKnown;
+            info.sumUs     += counter.sumUs;
+            info.sumSqUs   += counter.sumSqUs;
+            info.maxUs      = std::max(info.maxUs, counter.maxUs.load());
+        }
+        _threadCounters.erase(std::remove(_threadCounters.begin(), _threadCounters.end(), counters), _threadCounters.end());
+    }
+    delete counters;
+}
+
+void ThreadPlacement::Report()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    MMP_LOG_INFO << "Thread placement report, NUMA nodes : " << _nodeCpus.size() << ", memory node : " << (_memoryNode >= 0 ? std::to_string(_memoryNode) : "default");
+    for (size_t i = 0; i < (size_t)PipelineStage::COUNT; i++)
+    {
+        StageInfo info = _stages[i];
+        for (ThreadCounters* counters : _threadCounters)
+        {
+            const StageCounter& counter = counters->stages[i];
+            info.samples   += counter.samples.load(std::memory_order_relaxed);
+            info.crossNode += counter.crossNode.load(std::memory_order_relaxed);
+            info.nodeKnown += counter.nodeKnown.load(std::memory_order_relaxed);
+            info.sumUs     += counter.sumUs.load(std::memory_order_relaxed);
+            info.sumSqUs   += counter.sumSqUs.load(std::memory_order_relaxed);
+            info.maxUs      = std::max(info.maxUs, counter.maxUs.load(std::memory_order_relaxed));
+        }
+        if (info.samples == 0)
+        {
+            continue;
+        }
+        double avg = info.sumUs / info.samples;
+        double stddev = std::sqrt(std::max(0.0, info.sumSqUs / info.samples - avg * avg));
+        std::stringstream ss;
+        ss << "-- " << PipelineStageToStr((PipelineStage)i) << " (" << (info.spec.empty() ? "float" : info.spec) << ")"
+           << " samples : " << info.samples
+           << ", avg : " << (int64_t)avg << " us"
+           << ", stddev : " << (int64_t)stddev << " us"
+           << ", max : " << info.maxUs << " us";
+        if (info.nodeKnown)
+        {
+            ss << ", cross node : " << info.crossNode << "/" << info.nodeKnown
+               << " (" << (int64_t)(100.0 * info.crossNode / info.nodeKnown) << "%)";
+        }
+        MMP_LOG_INFO << ss.str();
+    }
+}
+
+} // namespace Mmp
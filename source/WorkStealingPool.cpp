@@ -0,0 +1,624 @@
+#include "WorkStealingPool.h"
+
+#include <chrono>
+#include <sstream>
+#include <algorithm>
+
+#include "Common/LogMessage.h"
+
+#include "SampleUtils.h"
+#include "ThreadPlacement.h"
+
+namespace Mmp
+{
+
+constexpr uint32_t kHelpWaitUs = 100;
+constexpr uint32_t kSlotJoinTimeoutMs = 1000;
+
+// Hint : 当前线程在 WorkStealingPool 中的工作线程序号, 非工作线程为 -1
+static thread_local int tWorkerIndex = -1;
+
+static uint64_t NowNs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void UpdateMax(std::atomic<uint64_t>& target, uint64_t value)
+{
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+const std::string& TaskPriorityToStr(TaskPriority priority)
+{
+    static const std::string names[] = {"realtime", "normal", "background", "unknown"};
+    size_t index = std::min((size_t)priority, (size_t)TaskPriority::COUNT);
+    return names[index];
+}
+
+TaskGroup::TaskGroup()
+{
+    _pending = 0;
+}
+
+void TaskGroup::Add(uint32_t count)
+{
+    _pending += count;
+}
+
+void TaskGroup::Finish()
+{
+    // Hint : 在锁内递减, Wait 返回前会取一次锁, 保证返回后 (栈上的 TaskGroup 被销毁) 不再访问本对象
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (--_pending == 0)
+    {
+        _cond.notify_all();
+    }
+}
+
+bool TaskGroup::Done()
+{
+    return _pending == 0;
+}
+
+void TaskGroup::Wait()
+{
+    while (tWorkerIndex >= 0 && _pending > 0)
+    {
+        if (!WorkStealingPool::Instance().RunOne())
+        {
+            std::unique_lock<std::mutex> lock(_mtx);
+            _cond.wait_for(lock, std::chrono::microseconds(kHelpWaitUs), [this]() { return _pending == 0; });
+        }
+    }
+    std::unique_lock<std::mutex> lock(_mtx);
+    _cond.wait(lock, [this]() { return _pending == 0; });
+}
+
+TaskPriorityStats::TaskPriorityStats()
+{
+    committed = 0;
+    executed = 0;
+    dispatchNsSum = 0;
+    dispatchNsMax = 0;
+}
+
+TaskWorkerStats::TaskWorkerStats()
+{
+    executed = 0;
+    steals = 0;
+    queueHighWater = 0;
+    queueDepth = 0;
+}
+
+WorkStealingPool& WorkStealingPool::Instance()
+{
+    static WorkStealingPool gInstance;
+    return gInstance;
+}
+
+WorkStealingPool::WorkStealingPool()
+{
+    _running = false;
+    _exit = false;
+    _queued = 0;
+    _wakeups = 0;
+    _sleeping = 0;
+    _backgroundRunning = 0;
+    _nextWorker = 0;
+    ResetStats();
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    Uninit();
+}
+
+void WorkStealingPool::Init(uint32_t workers)
+{
+    std::lock_guard<std::mutex> lock(_slotMtx);
+    if (_running)
+    {
+        return;
+    }
+    if (workers == 0)
+    {
+        workers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+    _exit = false;
+    _workers.clear();
+    for (uint32_t i = 0; i < workers; i++)
+    {
+        std::unique_ptr<Worker> worker(new Worker());
+        for (size_t p = 0; p < (size_t)TaskPriority::COUNT; p++)
+        {
+            worker->sizes[p] = 0;
+        }
+        worker->executed = 0;
+        worker->steals = 0;
+        worker->queueHighWater = 0;
+        _workers.push_back(std::move(worker));
+    }
+    for (uint32_t i = 0; i < workers; i++)
+    {
+        _workers[i]->thread = std::thread([this, i]()
+        {
+            tWorkerIndex = (int)i;
+            ThreadPlacement::Instance().Apply(PipelineStage::POOL);
+            WorkerLoop((int)i);
+        });
+    }
+    _running = true;
+}
+
+void WorkStealingPool::Uninit()
+{
+    {
+        // Hint : 取出全部槽后即释放 _slotMtx, stop 回调及等待槽结束都在锁外进行;
+        //        stop 回调或槽中的任务可能调用 CommitLongRunning / Report, 持锁调用会死锁
+        std::vector<std::unique_ptr<Slot>> slots;
+        {
+            std::lock_guard<std::mutex> lock(_slotMtx);
+            slots.swap(_slots);
+        }
+        for (auto& slot : slots)
+        {
+            Task stop;
+            {
+                std::lock_guard<std::mutex> slotLock(slot->mtx);
+                slot->exit = true;
+                stop = slot->busy ? slot->stop : nullptr;
+                slot->cond.notify_all();
+            }
+            if (stop)
+            {
+                MMP_LOG_WARN << "Long running slot " << slot->name << " is still running on uninit, request it to stop";
+                stop();
+            }
+        }
+        for (auto& slot : slots)
+        {
+            bool idle = false;
+            {
+                std::unique_lock<std::mutex> slotLock(slot->mtx);
+                idle = slot->cond.wait_for(slotLock, std::chrono::milliseconds(kSlotJoinTimeoutMs), [&slot]() { return !slot->busy; });
+            }
+            if (idle)
+            {
+                slot->thread.join();
+                continue;
+            }
+            // Hint : 任务不响应 stop, 放弃该线程; 线程返回后仍会访问槽, 因此槽不释放
+            MMP_LOG_ERROR << "Long running slot " << slot->name << " does not finish in " << kSlotJoinTimeoutMs << " ms, detach it";
+            slot->thread.detach();
+            slot.release();
+        }
+    }
+    if (!_running)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _exit = true;
+        _cond.notify_all();
+    }
+    for (auto& worker : _workers)
+    {
+        worker->thread.join();
+    }
+    _workers.clear();
+    _running = false;
+}
+
+bool WorkStealingPool::IsRunning()
+{
+    return _running;
+}
+
+uint32_t WorkStealingPool::GetWorkerCount()
+{
+    return (uint32_t)_workers.size();
+}
+
+void WorkStealingPool::Commit(Task task, TaskPriority priority, TaskGroup* group)
+{
+    if (group)
+    {
+        group->Add(1);
+    }
+    if (!_running)
+    {
+        task();
+        if (group)
+        {
+            group->Finish();
+        }
+        return;
+    }
+    TaskItem item;
+    item.task = std::move(task);
+    item.range = nullptr;
+    item.index = 0;
+    item.group = group;
+    item.commitNs = NowNs();
+    Push(std::move(item), priority);
+}
+
+void WorkStealingPool::ParallelFor(size_t count, const RangeTask& func, TaskPriority priority)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (!_running || count == 1)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            func(i);
+        }
+        return;
+    }
+    TaskGroup group;
+    group.Add((uint32_t)(count - 1));
+    for (size_t i = 1; i < count; i++)
+    {
+        TaskItem item;
+        item.range = &func;
+        item.index = i;
+        item.group = &group;
+        item.commitNs = NowNs();
+        Push(std::move(item), priority);
+    }
+    // Hint : 第 0 项在当前线程处理, 之后帮忙执行尚未被取走的同级或更高优先级任务, 工作线程全忙时不必等待
+    func(0);
+    while (!group.Done())
+    {
+        TaskItem item;
+        TaskPriority popped;
+        if (!TryPop(tWorkerIndex, priority, item, popped))
+        {
+            break;
+        }
+        Execute(tWorkerIndex, item, popped);
+    }
+    group.Wait();
+}
+
+TaskGroup::ptr WorkStealingPool::CommitLongRunning(const std::string& name, Task task, Task stop)
+{
+    TaskGroup::ptr group = std::make_shared<TaskGroup>();
+    group->Add(1);
+    std::lock_guard<std::mutex> lock(_slotMtx);
+    Slot* target = nullptr;
+    for (auto& slot : _slots)
+    {
+        std::lock_guard<std::mutex> slotLock(slot->mtx);
+        if (!slot->busy)
+        {
+            target = slot.get();
+            break;
+        }
+    }
+    if (!target)
+    {
+        std::unique_ptr<Slot> slot(new Slot());
+        slot->busy = false;
+        slot->exit = false;
+        target = slot.get();
+        target->thread = std::thread([this, target]()
+        {
+            SlotLoop(target);
+        });
+        _slots.push_back(std::move(slot));
+    }
+    std::lock_guard<std::mutex> slotLock(target->mtx);
+    target->name = name;
+    target->task = std::move(task);
+    target->stop = std::move(stop);
+    target->group = group;
+    target->busy = true;
+    target->cond.notify_one();
+    return group;
+}
+
+void WorkStealingPool::Push(TaskItem&& item, TaskPriority priority)
+{
+    size_t index = tWorkerIndex >= 0 ? (size_t)tWorkerIndex : _nextWorker++ % _workers.size();
+    Worker& worker = *_workers[index];
+    {
+        std::lock_guard<std::mutex> lock(worker.mtx);
+        worker.queues[(size_t)priority].push_back(std::move(item));
+        worker.sizes[(size_t)priority]++;
+        uint64_t depth = 0;
+        for (size_t p = 0; p < (size_t)TaskPriority::COUNT; p++)
+        {
+            depth += worker.queues[p].size();
+        }
+        UpdateMax(worker.queueHighWater, depth);
+    }
+    _counters[(size_t)priority].committed++;
+    _queued++;
+    _wakeups++;
+    WakeOne();
+}
+
+void WorkStealingPool::WakeOne()
+{
+    // Hint : 与 WorkerLoop 中 _sleeping++ 后检查 _wakeups 配对, 两者之一必然看到对方的修改, 不会丢失唤醒
+    if (_sleeping > 0)
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _cond.notify_one();
+    }
+}
+
+void WorkStealingPool::ReleaseBackground()
+{
+    _backgroundRunning--;
+    // Hint : 之前因名额已满而放弃的线程已经睡眠, 名额归还后由被唤醒的线程继续处理排队的后台任务
+    if (_queued > 0)
+    {
+        _wakeups++;
+        WakeOne();
+    }
+}
+
+bool WorkStealingPool::TryPop(int self, TaskPriority lowest, TaskItem& item, TaskPriority& priority)
+{
+    size_t workers = _workers.size();
+    for (size_t p = 0; p <= (size_t)lowest; p++)
+    {
+        bool background = p == (size_t)TaskPriority::BACKGROUND && workers > 1;
+        if (background && _exit)
+        {
+            // Hint : 退出时不再限制后台名额, 否则被名额挡住的后台任务会使空闲线程在 WorkerLoop 中空转;
+            //        仍然计数, 与 Execute 中的归还配对
+            _backgroundRunning++;
+        }
+        else if (background)
+        {
+            // Hint : 先占用后台名额再取任务, 取不到时归还
+            uint32_t running = _backgroundRunning;
+            if (running >= workers - 1 || !_backgroundRunning.compare_exchange_strong(running, running + 1))
+            {
+                continue;
+            }
+        }
+        if (self >= 0)
+        {
+            Worker& own = *_workers[self];
+            if (own.sizes[p] > 0)
+            {
+                std::lock_guard<std::mutex> lock(own.mtx);
+                if (!own.queues[p].empty())
+                {
+                    item = std::move(own.queues[p].back());
+                    own.queues[p].pop_back();
+                    own.sizes[p]--;
+                    priority = (TaskPriority)p;
+                    _queued--;
+                    return true;
+                }
+            }
+        }
+        size_t start = self >= 0 ? (size_t)self + 1 : 0;
+        for (size_t k = 0; k < workers; k++)
+        {
+            size_t victimIndex = (start + k) % workers;
+            if ((int)victimIndex == self)
+            {
+                continue;
+            }
+            Worker& victim = *_workers[victimIndex];
+            if (victim.sizes[p] == 0)
+            {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(victim.mtx);
+            if (!victim.queues[p].empty())
+            {
+                item = std::move(victim.queues[p].front());
+                victim.queues[p].pop_front();
+                victim.sizes[p]--;
+                priority = (TaskPriority)p;
+                _queued--;
+                if (self >= 0)
+                {
+                    _workers[self]->steals++;
+                }
+                return true;
+            }
+        }
+        if (background)
+        {
+            ReleaseBackground();
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::Execute(int self, TaskItem& item, TaskPriority priority)
+{
+    PriorityCounter& counter = _counters[(size_t)priority];
+    uint64_t dispatchNs = NowNs() - item.commitNs;
+    counter.dispatchNsSum += dispatchNs;
+    UpdateMax(counter.dispatchNsMax, dispatchNs);
+    if (item.range)
+    {
+        (*item.range)(item.index);
+    }
+    else
+    {
+        item.task();
+    }
+    counter.executed++;
+    if (self >= 0)
+    {
+        _workers[self]->executed++;
+    }
+    if (priority == TaskPriority::BACKGROUND && _workers.size() > 1)
+    {
+        ReleaseBackground();
+    }
+    if (item.group)
+    {
+        item.group->Finish();
+    }
+}
+
+bool WorkStealingPool::RunOne()
+{
+    TaskItem item;
+    TaskPriority priority;
+    if (!TryPop(tWorkerIndex, TaskPriority::BACKGROUND, item, priority))
+    {
+        return false;
+    }
+    Execute(tWorkerIndex, item, priority);
+    return true;
+}
+
+void WorkStealingPool::WorkerLoop(int self)
+{
+    while (true)
+    {
+        TaskItem item;
+        TaskPriority priority;
+        uint64_t wakeups = _wakeups;
+        if (TryPop(self, TaskPriority::BACKGROUND, item, priority))
+        {
+            Execute(self, item, priority);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(_mtx);
+        if (_exit && _queued == 0)
+        {
+            break;
+        }
+        _sleeping++;
+        // Hint : 以唤醒次数而不是队列长度判断是否需要重试; 剩余的都是受名额限制的后台任务时,
+        //        等到名额归还再重试, 不会空转
+        _cond.wait(lock, [this, wakeups]() { return _wakeups != wakeups || _exit; });
+        _sleeping--;
+    }
+}
+
+void WorkStealingPool::SlotLoop(Slot* slot)
+{
+    while (true)
+    {
+        Task task;
+        TaskGroup::ptr group;
+        {
+            std::unique_lock<std::mutex> lock(slot->mtx);
+            slot->cond.wait(lock, [slot]() { return slot->busy || slot->exit; });
+            if (!slot->busy)
+            {
+                break;
+            }
+            task = std::move(slot->task);
+            group = slot->group;
+        }
+        task();
+        {
+            std::lock_guard<std::mutex> lock(slot->mtx);
+            slot->task = nullptr;
+            slot->stop = nullptr;
+            slot->group.reset();
+            slot->busy = false;
+            slot->cond.notify_all();
+        }
+        group->Finish();
+    }
+}
+
+std::vector<TaskPriorityStats> WorkStealingPool::GetPriorityStats()
+{
+    std::vector<TaskPriorityStats> stats((size_t)TaskPriority::COUNT);
+    for (size_t p = 0; p < (size_t)TaskPriority::COUNT; p++)
+    {
+        stats[p].committed = _counters[p].committed;
+        stats[p].executed = _counters[p].executed;
+        stats[p].dispatchNsSum = _counters[p].dispatchNsSum;
+        stats[p].dispatchNsMax = _counters[p].dispatchNsMax;
+    }
+    return stats;
+}
+
+std::vector<TaskWorkerStats> WorkStealingPool::GetWorkerStats()
+{
+    std::vector<TaskWorkerStats> stats(_workers.size());
+    for (size_t i = 0; i < _workers.size(); i++)
+    {
+        Worker& worker = *_workers[i];
+        stats[i].executed = worker.executed;
+        stats[i].steals = worker.steals;
+        stats[i].queueHighWater = worker.queueHighWater;
+        for (size_t p = 0; p < (size_t)TaskPriority::COUNT; p++)
+        {
+            stats[i].queueDepth += worker.sizes[p];
+        }
+    }
+    return stats;
+}
+
+void WorkStealingPool::ResetStats()
+{
+    for (size_t p = 0; p < (size_t)TaskPriority::COUNT; p++)
+    {
+        _counters[p].committed = 0;
+        _counters[p].executed = 0;
+        _counters[p].dispatchNsSum = 0;
+        _counters[p].dispatchNsMax = 0;
+    }
+    for (auto& worker : _workers)
+    {
+        worker->executed = 0;
+        worker->steals = 0;
+        worker->queueHighWater = 0;
+    }
+}
+
+void WorkStealingPool::Report()
+{
+    std::stringstream slots;
+    {
+        std::lock_guard<std::mutex> lock(_slotMtx);
+        slots << _slots.size();
+        for (auto& slot : _slots)
+        {
+            std::lock_guard<std::mutex> slotLock(slot->mtx);
+            slots << (slot.get() == _slots.front().get() ? " (" : ", ") << slot->name << (slot->busy ? "" : " idle");
+        }
+        slots << (_slots.empty() ? "" : ")");
+    }
+    MMP_LOG_INFO << "Work stealing pool report, workers : " << _workers.size() << ", long running slots : " << slots.str();
+    std::vector<TaskPriorityStats> priorityStats = GetPriorityStats();
+    for (size_t p = 0; p < priorityStats.size(); p++)
+    {
+        const TaskPriorityStats& stats = priorityStats[p];
+        if (stats.committed == 0 && stats.executed == 0)
+        {
+            continue;
+        }
+        double avgUs = stats.executed ? stats.dispatchNsSum / 1000.0 / stats.executed : 0;
+        MMP_LOG_INFO << "-- " << TaskPriorityToStr((TaskPriority)p) << " committed : " << stats.committed << ", executed : " << stats.executed
+                     << ", dispatch avg : " << (int64_t)avgUs << " us, max : " << stats.dispatchNsMax / 1000 << " us";
+        ReportPerfMetric("pool_" + TaskPriorityToStr((TaskPriority)p) + "_dispatch_us", avgUs);
+    }
+    uint64_t steals = 0;
+    std::vector<TaskWorkerStats> workerStats = GetWorkerStats();
+    for (size_t i = 0; i < workerStats.size(); i++)
+    {
+        const TaskWorkerStats& stats = workerStats[i];
+        MMP_LOG_INFO << "-- worker " << i << " executed : " << stats.executed << ", steals : " << stats.steals
+                     << ", queue : " << stats.queueDepth << " (max " << stats.queueHighWater << ")";
+        steals += stats.steals;
+    }
+    ReportPerfMetric("pool_steals", (double)steals);
+}
+
+} // namespace Mmp
@@ -0,0 +1,37 @@
+#include "YUVColor.h"
+
+namespace Mmp
+{
+
+RGBToYUVCoeff GetRGBToYUVCoeff(YUVColorSpace space, YUVColorRange range)
+{
+    float kr = space == YUVColorSpace::BT601 ? 0.299f : 0.2126f;
+    float kb = space == YUVColorSpace::BT601 ? 0.114f : 0.0722f;
+    float kg = 1.0f - kr - kb;
+    float yScale  = range == YUVColorRange::LIMITED ? 219.0f / 255.0f : 1.0f;
+    float uvScale = range == YUVColorRange::LIMITED ? 224.0f / 255.0f : 1.0f;
+    auto toQ8 = [](float value) -> int32_t
+    {
+        return (int32_t)(value * 256.0f + (value >= 0 ? 0.5f : -0.5f));
+    };
+
+    RGBToYUVCoeff coeff = {};
+    // Y = kr * R + kg * G + kb * B
+    // U = (B - Y) / 2(1-kb)
+    // V = (R - Y) / 2(1-kr)
+    // Hint : G 分量系数由其他两项推出, 保证灰阶 (R == G == B) 时取整误差不会让 UV 偏离 128
+    coeff.yCoeff[0] = toQ8(kr * yScale);
+    coeff.yCoeff[2] = toQ8(kb * yScale);
+    coeff.yCoeff[1] = toQ8(yScale) - coeff.yCoeff[0] - coeff.yCoeff[2];
+    coeff.uCoeff[0] = toQ8(-kr / (2.0f * (1.0f - kb)) * uvScale);
+    coeff.uCoeff[2] = toQ8(0.5f * uvScale);
+    coeff.uCoeff[1] = -coeff.uCoeff[0] - coeff.uCoeff[2];
+    coeff.vCoeff[0] = toQ8(0.5f * uvScale);
+    coeff.vCoeff[2] = toQ8(-kb / (2.0f * (1.0f - kr)) * uvScale);
+    coeff.vCoeff[1] = -coeff.vCoeff[0] - coeff.vCoeff[2];
+    coeff.yOffset  = range == YUVColorRange::LIMITED ? 16 : 0;
+    coeff.uvOffset = 128;
+    return coeff;
+}
+
+} // namespace Mmp
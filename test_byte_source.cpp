@@ -0,0 +1,358 @@
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#include <Poco/Stopwatch.h>
+#include <Poco/Util/Application.h>
+#include <Poco/Util/HelpFormatter.h>
+
+#include "Common/AbstractLogger.h"
+#include "Common/LogMessage.h"
+
+#include "AbstractByteSource.h"
+#include "H26XFileByteReader.h"
+#include "SampleUtils.h"
+
+using namespace Mmp;
+using namespace Poco::Util;
+
+/**
+ * @sa Core/Extension/poco/Util/samples/SampleApp/src/SampleApp.cpp
+ */
+class App : public Application
+{
+public:
+    App();
+public:
+    void defineOptions(OptionSet& options) override;
+protected:
+    void defineProperty(const std::string& def);
+    int main(const ArgVec& args);
+private:
+    void HandleHelp(const std::string& name, const std::string& value);
+    void HandleInput(const std::string& name, const std::string& value);
+    void HandleUrl(const std::string& name, const std::string& value);
+    void HandleUdpRate(const std::string& name, const std::string& value);
+    void displayHelp();
+public:
+    std::string  inputFile;
+    std::string  url;
+    uint32_t     udpRateMbps;
+};
+
+App::App()
+{
+    url = "unix:///tmp/mmp_byte_source.sock";
+    udpRateMbps = 100;
+}
+
+void App::displayHelp()
+{
+    AbstractLogger::LoggerSingleton()->Enable(AbstractLogger::Direction::CONSLOE);
+    std::stringstream ss;
+    HelpFormatter helpFormatter(options());
+    helpFormatter.setWidth(1024);
+    helpFormatter.setCommand(commandName());
+    helpFormatter.setUsage("OPTIONS");
+    helpFormatter.setHeader("Simple program to push an annex-b file through a local socket and check what the byte source receives.");
+    helpFormatter.format(ss);
+    MMP_LOG_INFO << ss.str();
+    exit(0);
+}
+
+void App::HandleHelp(const std::string& name, const std::string& value)
+{
+    displayHelp();
+}
+
+void App::HandleInput(const std::string& name, const std::string& value)
+{
+    inputFile = value;
+}
+
+void App::HandleUrl(const std::string& name, const std::string& value)
+{
+    url = value;
+}
+
+void App::HandleUdpRate(const std::string& name, const std::string& value)
+{
+    udpRateMbps = std::stoi(value);
+    udpRateMbps = std::max(udpRateMbps, (uint32_t)1);
+}
+
+void App::defineOptions(OptionSet& options)
+{
+    Application::defineOptions(options);
+
+    options.addOption(Option("help", "h", "")
+        .required(false)
+        .repeatable(false)
+        .callback(OptionCallback<App>(this, &App::HandleHelp))
+    );
+    options.addOption(Option("input", "i", "annex-b file to send")
+        .required(true)
+        .repeatable(false)
+        .argument("[filepath]")
+        .callback(OptionCallback<App>(this, &App::HandleInput))
+    );
+    options.addOption(Option("url", "u", "default(unix:///tmp/mmp_byte_source.sock), unix://<path> or udp://<ip>:<port>")
+        .required(false)
+        .repeatable(false)
+        .argument("[url]")
+        .callback(OptionCallback<App>(this, &App::HandleUrl))
+    );
+    options.addOption(Option("udp_rate", "ur", "default(100), udp send rate in Mbps")
+        .required(false)
+        .repeatable(false)
+        .argument("[mbps]")
+        .callback(OptionCallback<App>(this, &App::HandleUdpRate))
+    );
+}
+
+void App::defineProperty(const std::string& def)
+{
+    std::string name;
+    std::string value;
+    std::string::size_type pos = def.find('=');
+    if (pos != std::string::npos)
+    {
+        name.assign(def, 0, pos);
+        value.assign(def, pos + 1, def.length() - pos);
+    }
+    else name = def;
+    config().setString(name, value);
+}
+
+/**
+ * @brief 按 NAL 扫描, 返回每个 NAL 的偏移以及总字节数
+ */
+static uint64_t ScanNals(H26XFileByteReader& reader, std::vector<size_t>& offsets)
+{
+    uint64_t bytes = 0;
+    Codec::StreamPack::ptr pack;
+    while ((pack = reader.GetNalUint()))
+    {
+        offsets.push_back(reader.GetLastNalOffset());
+        bytes += pack->GetSize();
+    }
+    return bytes;
+}
+
+constexpr size_t kDatagramSize = 1400;
+
+/**
+ * @brief 检查 UDP 接收到的数据是否由完整的数据报按发送顺序拼接而成 (允许丢失整个数据报)
+ * @param[out] lost : 丢失的数据报数
+ */
+static bool CheckDatagrams(const std::vector<uint8_t>& sent, const std::vector<uint8_t>& received, size_t& lost)
+{
+    size_t count = (sent.size() + kDatagramSize - 1) / kDatagramSize;
+    size_t next = 0;
+    size_t pos = 0;
+    lost = 0;
+    while (pos < received.size())
+    {
+        size_t index = next;
+        for (; index < count; index++)
+        {
+            size_t size = std::min(kDatagramSize, sent.size() - index * kDatagramSize);
+            if (size <= received.size() - pos && memcmp(received.data() + pos, sent.data() + index * kDatagramSize, size) == 0)
+            {
+                pos += size;
+                break;
+            }
+        }
+        if (index == count)
+        {
+            // Hint : 数据报被截断或乱序
+            return false;
+        }
+        lost += index - next;
+        next = index + 1;
+    }
+    lost += count - next;
+    return true;
+}
+
+#ifndef _WIN32
+
+/**
+ * @brief Unix 套接字不限速发送, 即本机回环所能达到的最高速率; UDP 按 udpRateMbps 限速, 避免接收缓冲溢出丢包
+ */
+static bool SendFile(const std::string& url, const std::vector<uint8_t>& data, uint32_t udpRateMbps)
+{
+    if (url.rfind("unix://", 0) == 0)
+    {
+        std::string path = url.substr(7);
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, path.c_str(), std::min(path.size(), sizeof(addr.sun_path) - 1));
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0)
+        {
+            return false;
+        }
+        size_t offset = 0;
+        while (offset < data.size())
+        {
+            ssize_t n = write(fd, data.data() + offset, data.size() - offset);
+            if (n <= 0)
+            {
+                break;
+            }
+            offset += (size_t)n;
+        }
+        close(fd);
+        return offset == data.size();
+    }
+    else if (url.rfind("udp://", 0) == 0)
+    {
+        std::string address = url.substr(6);
+        size_t pos = address.rfind(':');
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)std::stoi(address.substr(pos + 1)));
+        inet_pton(AF_INET, address.substr(0, pos).c_str(), &addr.sin_addr);
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0)
+        {
+            return false;
+        }
+        Poco::Stopwatch sw;
+        sw.start();
+        for (size_t offset = 0; offset < data.size(); offset += kDatagramSize)
+        {
+            sendto(fd, data.data() + offset, std::min(kDatagramSize, data.size() - offset), 0, (sockaddr*)&addr, sizeof(addr));
+            // Hint : 领先计划时间 1 ms 以上时再休眠, 避免每个数据报都休眠
+            int64_t planUs = (int64_t)((offset + kDatagramSize) * 8 / udpRateMbps);
+            if (planUs - sw.elapsed() > 1000)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(planUs - sw.elapsed()));
+            }
+        }
+        // Hint : 空数据报通知接收端结束
+        sendto(fd, "", 0, 0, (sockaddr*)&addr, sizeof(addr));
+        close(fd);
+        return true;
+    }
+    return false;
+}
+
+#else
+
+static bool SendFile(const std::string& /* url */, const std::vector<uint8_t>& /* data */, uint32_t /* udpRateMbps */)
+{
+    return false;
+}
+
+#endif
+
+/********************************************************* TEST(BEGIN) *****************************************************/
+
+int App::main(const ArgVec& args)
+{
+    AbstractLogger::LoggerSingleton()->Enable(AbstractLogger::Direction::CONSLOE);
+    std::vector<uint8_t> data;
+    {
+        std::ifstream ifs(inputFile, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!ifs.is_open())
+        {
+            MMP_LOG_ERROR << "Open input fail, path is: " << inputFile;
+            return 255;
+        }
+        data.resize((size_t)ifs.tellg());
+        ifs.seekg(0);
+        ifs.read((char*)data.data(), data.size());
+    }
+
+    std::vector<size_t> expectOffsets;
+    uint64_t expectBytes = 0;
+    {
+        Poco::Stopwatch scan;
+        scan.start();
+        H26XFileByteReader reader(inputFile);
+        expectBytes = ScanNals(reader, expectOffsets);
+        scan.stop();
+        MMP_LOG_INFO << "NAL scan : " << expectOffsets.size() << " nals, cost " << scan.elapsed() / 1000 << " ms";
+        ReportPerfMetric("nal_scan_mbps", scan.elapsed() > 0 ? data.size() * 8.0 / scan.elapsed() : 0);
+    }
+
+    AbstractByteSource::ptr source = AbstractByteSource::Create(url);
+    if (!source)
+    {
+        return 255;
+    }
+    bool udp = url.rfind("udp://", 0) == 0;
+    Poco::Stopwatch sw;
+    sw.start();
+    bool sent = false;
+    std::thread sender([&]()
+    {
+        sent = SendFile(url, data, udpRateMbps);
+    });
+    std::vector<size_t> offsets;
+    uint64_t bytes = 0;
+    std::vector<uint8_t> received;
+    if (udp)
+    {
+        // Hint : UDP 可能丢包, 不按 NAL 逐字节比较, 而是检查收到的数据报是否完整且保持顺序
+        uint8_t chunk[64 * 1024];
+        size_t n = 0;
+        while ((n = source->Read(chunk, sizeof(chunk))) > 0)
+        {
+            received.insert(received.end(), chunk, chunk + n);
+        }
+    }
+    else
+    {
+        H26XFileByteReader reader(source);
+        bytes = ScanNals(reader, offsets);
+    }
+    sender.join();
+    sw.stop();
+
+    bool match = false;
+    MMP_LOG_INFO << "Loopback statistics";
+    MMP_LOG_INFO << "-- url : " << url;
+    if (udp)
+    {
+        size_t lost = 0;
+        size_t datagrams = (data.size() + kDatagramSize - 1) / kDatagramSize;
+        bool framed = CheckDatagrams(data, received, lost);
+        match = sent && framed && lost < datagrams;
+        MMP_LOG_INFO << "-- rate : " << udpRateMbps << " Mbps";
+        MMP_LOG_INFO << "-- datagram : " << datagrams - lost << "/" << datagrams << ", bytes : " << received.size() << "/" << data.size()
+                     << ", framing and order : " << (framed ? "ok" : "broken");
+        if (lost > 0)
+        {
+            MMP_LOG_WARN << "UDP lost " << lost << " datagrams, lower --udp_rate if this keeps happening";
+        }
+    }
+    else
+    {
+        match = sent && offsets == expectOffsets && bytes == expectBytes;
+        MMP_LOG_INFO << "-- nal : " << offsets.size() << "/" << expectOffsets.size() << ", bytes : " << bytes << "/" << expectBytes;
+    }
+    MMP_LOG_INFO << "-- throughput : " << (sw.elapsed() > 0 ? data.size() * 8.0 / sw.elapsed() : 0) << " Mbps";
+    MMP_LOG_INFO << "-- result : " << (match ? "PASS" : "FAIL");
+    ReportPerfMetric("loopback_mbps", sw.elapsed() > 0 ? data.size() * 8.0 / sw.elapsed() : 0);
+    return match ? 0 : 255;
+}
+
+/********************************************************* TEST(END) *****************************************************/
+
+POCO_APP_MAIN(App)
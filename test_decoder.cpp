@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <fstream>
 #include <Poco/Stopwatch.h>
+#include <Poco/Timestamp.h>
 #include <Poco/Util/Application.h>
 #include <Poco/Util/HelpFormatter.h>
 
@@ -13,164 +15,20 @@
 #include "Codec/CodecFactory.h"
 #include "Common/ImmutableVectorAllocateMethod.h"
 #include "AbstractDisplay.h"
+#include "SampleUtils.h"
+#include "H26XFileByteReader.h"
+#include "AbstractPacketReader.h"
+#include "AnnexBIndex.h"
+#include "GopParallelDecoder.h"
+#include "PacketReplayCache.h"
+#include "AllocTracker.h"
+#include "ThreadPlacement.h"
+#include "PipelineGraph.h"
+#include "WorkStealingPool.h"
 
 using namespace Mmp;
 using namespace Poco::Util;
 
-constexpr uint32_t kBufSize = 1024 * 1024;
-
-
-class H26XFileByteReader
-{
-public:
-    explicit H26XFileByteReader(const std::string& path);
-    ~H26XFileByteReader();
-public:
-    Codec::StreamPack::ptr GetNalUint();
-public:
-    size_t Read(void* data, size_t bytes);
-    bool Seek(size_t offset);
-    size_t Tell();
-    bool eof();
-private:
-    std::ifstream _ifs;
-private:
-    uint8_t* _buf;
-    size_t _offset;
-    uint32_t _cur;
-    uint32_t _len;
-};
-
-Codec::StreamPack::ptr H26XFileByteReader::GetNalUint()
-{
-    std::vector<uint8_t> bufs;
-    bufs.reserve(1024 * 1024);
-    uint32_t next_24_bits = 0;
-    bool isFirst = true;
-    while (!(next_24_bits == 0x000001 && !isFirst))
-    {
-        if (next_24_bits == 0x000001)
-        {
-            isFirst = false;
-            bufs.push_back(0);
-            bufs.push_back(0);
-            bufs.push_back(0);
-            bufs.push_back(1);
-        }
-        uint8_t byte = 0;
-        if (Read(&byte, 1) != 1 && eof())
-        {
-            return nullptr;
-        }
-        if (!isFirst)
-        {
-            bufs.push_back(byte);
-        }
-        next_24_bits = (next_24_bits << 8) | byte;
-        next_24_bits = next_24_bits & 0xFFFFFF;
-    }
-    Seek(Tell() - 3);
-    if (bufs.size() >= 3)
-    {
-        bufs.resize(bufs.size() - 3);
-        if (!bufs.empty() && bufs[bufs.size()-1] == 0)
-        {
-            bufs.pop_back();
-        }
-    }
-    std::shared_ptr<ImmutableVectorAllocateMethod<uint8_t>> alloc = std::make_shared<ImmutableVectorAllocateMethod<uint8_t>>();
-    alloc->container.swap(bufs);
-    return std::make_shared<Codec::StreamPack>(Codec::CodecType::H264, alloc->container.size(), alloc);
-}
-
-H26XFileByteReader::H26XFileByteReader(const std::string& path)
-{
-    _ifs.open(path, std::ios::in | std::ios::binary);
-    if (!_ifs.is_open())
-    {
-        assert(false);
-        exit(255);
-    }
-    _buf = new uint8_t[kBufSize];
-    _offset = (uint32_t)_ifs.tellg();
-    _ifs.read((char*)_buf, kBufSize);
-    _cur = 0;
-    _len = (uint32_t)_ifs.gcount();
-}
-
-H26XFileByteReader::~H26XFileByteReader()
-{
-    delete[] _buf;
-    _ifs.close();
-}
-
-size_t H26XFileByteReader::Read(void* data, size_t bytes)
-{
-    if (_cur + bytes <= _len)
-    {
-        memcpy(data, _buf + _cur, bytes);
-        _cur += (uint32_t)bytes;
-        return bytes;
-    }
-    else if (_ifs.eof())
-    {
-        memcpy(data, _buf + _cur, _len -  _cur);
-        return _len -  _cur;
-    }
-    else
-    {
-        _offset = (size_t)_ifs.tellg();
-        _ifs.read((char*)_buf, kBufSize);
-        _cur = 0;
-        _len = (uint32_t)_ifs.gcount();
-        if (_len == 0) /* eof */
-        {
-            return 0;
-        }
-        else
-        {
-            return Read(data, bytes);
-        }
-    }
-}
-
-bool H26XFileByteReader::Seek(size_t offset)
-{
-    if (offset < _offset)
-    {
-        _ifs.seekg(offset);
-        _offset = (size_t)_ifs.tellg();
-        _ifs.read((char*)_buf, kBufSize);
-        _cur = 0;
-        _len = (uint32_t)_ifs.gcount(); 
-        return _offset == offset;
-    }
-    else if (offset > _offset + kBufSize)
-    {
-        _ifs.seekg(offset);
-        _offset = (size_t)_ifs.tellg();
-        _ifs.read((char*)_buf, kBufSize);
-        _cur = 0;
-        _len = (uint32_t)_ifs.gcount(); 
-        return _offset == offset;
-    }
-    else
-    {
-        _cur = (uint32_t)(offset - _offset);
-        return true;
-    }
-}
-
-size_t H26XFileByteReader::Tell()
-{
-    return _offset + _cur;
-}
-
-bool H26XFileByteReader::eof()
-{
-    return _len == 0 || (_ifs.eof() && _cur == _len);
-}
-
 /**
  * @sa MMP-Core/Extension/poco/Util/samples/SampleApp/src/SampleApp.cpp 
  */
@@ -192,13 +50,31 @@ private:
     void HandleInput(const std::string& name, const std::string& value);
     void HandleShow(const std::string& name, const std::string& value);
     void HandleFps(const std::string& name, const std::string& value);
+    void HandleSeek(const std::string& name, const std::string& value);
+    void HandleScrub(const std::string& name, const std::string& value);
+    void HandleGopParallel(const std::string& name, const std::string& value);
+    void HandleReplay(const std::string& name, const std::string& value);
+    void HandleAllocAssert(const std::string& name, const std::string& value);
+    void HandlePlacement(const std::string& name, const std::string& value);
+    void HandleFitDisplay(const std::string& name, const std::string& value);
+    void HandlePipeline(const std::string& name, const std::string& value);
     void displayHelp();
+    int RunGopParallel();
+    int RunPipeline();
 public:
     std::string              decoderClassName;
     std::string              inputFile;
     bool                     show;
     uint64_t                 fps;
     size_t                   loopTime;
+    double                   loopSecond;
+    int64_t                  seekFrame;
+    double                   seekSecond;
+    std::vector<std::pair<uint64_t, uint64_t>> scrubs;
+    size_t                   gopParallel;
+    int64_t                  allocWarmUp;
+    bool                     fitDisplay;
+    ScaleFilter              scaleFilter;
 };
 
 App::App()
@@ -206,6 +82,13 @@ App::App()
     show = true;
     fps = 30;
     loopTime = 0;
+    loopSecond = 0;
+    seekFrame = -1;
+    seekSecond = -1;
+    gopParallel = 0;
+    allocWarmUp = -1;
+    fitDisplay = true;
+    scaleFilter = ScaleFilter::AREA;
 }
 
 void App::displayHelp()
@@ -258,6 +141,92 @@ void App::HandleFps(const std::string& name, const std::string& value)
     fps = std::stoi(value);
 }
 
+void App::HandleSeek(const std::string& name, const std::string& value)
+{
+    // Hint : 以 s 结尾时按秒定位, 否则按帧序号定位
+    if (!value.empty() && value.back() == 's')
+    {
+        seekSecond = std::stod(value.substr(0, value.size() - 1));
+    }
+    else
+    {
+        seekFrame = std::stoll(value);
+    }
+}
+
+void App::HandleScrub(const std::string& name, const std::string& value)
+{
+    // Hint : <at>:<to>, 已送入 at 帧后跳转到第 to 帧
+    std::string::size_type pos = value.find(':');
+    if (pos == std::string::npos)
+    {
+        MMP_LOG_WARN << "Invalid scrub : " << value << ", expect <at>:<to>";
+        return;
+    }
+    scrubs.push_back({std::stoull(value.substr(0, pos)), std::stoull(value.substr(pos + 1))});
+    std::sort(scrubs.begin(), scrubs.end());
+}
+
+void App::HandleGopParallel(const std::string& name, const std::string& value)
+{
+    gopParallel = std::stoi(value);
+}
+
+void App::HandleReplay(const std::string& name, const std::string& value)
+{
+    // Hint : 以 s 结尾时按时长回放, 否则按次数回放
+    if (!value.empty() && value.back() == 's')
+    {
+        loopSecond = std::stod(value.substr(0, value.size() - 1));
+    }
+    else
+    {
+        loopTime = std::stoi(value);
+    }
+}
+
+void App::HandleAllocAssert(const std::string& name, const std::string& value)
+{
+    allocWarmUp = value.empty() ? 60 : std::stoll(value);
+    allocWarmUp = std::max(allocWarmUp, (int64_t)0);
+}
+
+void App::HandlePlacement(const std::string& name, const std::string& value)
+{
+    // Hint : <stage>=<spec> 写入 placement.<stage>, 与配置文件中的 key 一致
+    std::string::size_type pos = value.find('=');
+    if (pos == std::string::npos)
+    {
+        MMP_LOG_WARN << "Invalid placement : " << value << ", expect <stage>=<spec>";
+        return;
+    }
+    config().setString("placement." + value.substr(0, pos), value.substr(pos + 1));
+}
+
+void App::HandlePipeline(const std::string& name, const std::string& value)
+{
+    // Hint : <key>=<value> 写入 pipeline.<key>, 与配置文件中的 key 一致
+    std::string::size_type pos = value.find('=');
+    if (pos == std::string::npos)
+    {
+        MMP_LOG_WARN << "Invalid pipeline : " << value << ", expect <key>=<value>";
+        return;
+    }
+    config().setString("pipeline." + value.substr(0, pos), value.substr(pos + 1));
+}
+
+void App::HandleFitDisplay(const std::string& name, const std::string& value)
+{
+    if (value == "none" || value == "false")
+    {
+        fitDisplay = false;
+    }
+    else if (value == "bilinear")
+    {
+        scaleFilter = ScaleFilter::BILINEAR;
+    }
+}
+
 void App::HandleInput(const std::string& name, const std::string& value)
 {
     inputFile = value;
@@ -266,7 +235,10 @@ void App::HandleInput(const std::string& name, const std::string& value)
 void App::initialize(Application& self)
 {
     loadConfiguration(); 
+    ThreadPlacement::Instance().Load(config());
     ThreadPool::ThreadPoolSingleton()->Init();
+    ThreadPlacement::Instance().ApplyThreadPool(std::thread::hardware_concurrency());
+    WorkStealingPool::Instance().Init();
     Application::initialize(self);
     Codec::CodecConfig::Instance()->Init();
     AbstractLogger::LoggerSingleton()->Enable(AbstractLogger::Direction::CONSLOE);
@@ -276,6 +248,7 @@ void App::uninitialize()
 {
     Codec::CodecConfig::Instance()->Uninit();
     Application::uninitialize();
+    WorkStealingPool::Instance().Uninit();
     ThreadPool::ThreadPoolSingleton()->Uninit();
 }
 
@@ -299,7 +272,7 @@ void App::defineOptions(OptionSet& options)
         .argument("[name]")
         .callback(OptionCallback<App>(this, &App::HandleCodecName))
     );
-    options.addOption(Option("input", "i", "")
+    options.addOption(Option("input", "i", "Annex-B, mp4 or ivf file path; Annex-B also from - (stdin), pipe://<fifo>, udp://<ip>:<port> or unix://<path>")
         .required(true)
         .repeatable(false)
         .argument("[filepath]")
@@ -317,6 +290,54 @@ void App::defineOptions(OptionSet& options)
         .argument("[num]")
         .callback(OptionCallback<App>(this, &App::HandleFps))
     );
+    options.addOption(Option("seek", "seek", "start from frame [num] or second [num]s, seek to the nearest preceding keyframe")
+        .required(false)
+        .repeatable(false)
+        .argument("[pos]")
+        .callback(OptionCallback<App>(this, &App::HandleSeek))
+    );
+    options.addOption(Option("scrub", "scrub", "mid-stream seek, after feeding [at] frames flush the decoder and jump to frame [to], repeatable")
+        .required(false)
+        .repeatable(true)
+        .argument("[at:to]")
+        .callback(OptionCallback<App>(this, &App::HandleScrub))
+    );
+    options.addOption(Option("gop_parallel", "gp", "offline decode with [num] decoder instances split at keyframes, 1 for single instance baseline")
+        .required(false)
+        .repeatable(false)
+        .argument("[num]")
+        .callback(OptionCallback<App>(this, &App::HandleGopParallel))
+    );
+    options.addOption(Option("replay", "replay", "preload all packs into memory, then replay [num] times or for [num]s seconds")
+        .required(false)
+        .repeatable(false)
+        .argument("[count]")
+        .callback(OptionCallback<App>(this, &App::HandleReplay))
+    );
+    options.addOption(Option("alloc_assert", "aa", "default(off), [warm up frames], abort on heap allocation after warm up (replay only), build with MMP_SAMPLE_ALLOC_TRACKER")
+        .required(false)
+        .repeatable(false)
+        .argument("[frames]", false)
+        .callback(OptionCallback<App>(this, &App::HandleAllocAssert))
+    );
+    options.addOption(Option("placement", "pl", "<stage>=<spec>, stage is pool/decode/display/memory, spec is cpu:0-3,8 or node:1")
+        .required(false)
+        .repeatable(true)
+        .argument("[placement]")
+        .callback(OptionCallback<App>(this, &App::HandlePlacement))
+    );
+    options.addOption(Option("fit_display", "fd", "default(area), area, bilinear or none, shrink the window to fit the screen and scale on CPU before upload")
+        .required(false)
+        .repeatable(false)
+        .argument("[filter]")
+        .callback(OptionCallback<App>(this, &App::HandleFitDisplay))
+    );
+    options.addOption(Option("pipeline", "pp", "<key>=<value>, e.g. nodes=reader,decode,rate,display or decode.queue_depth=8, run the pipeline graph (types: reader/decode/display/rate/null)")
+        .required(false)
+        .repeatable(true)
+        .argument("[pipeline]")
+        .callback(OptionCallback<App>(this, &App::HandlePipeline))
+    );
 }
 
 void App::defineProperty(const std::string& def)
@@ -335,8 +356,193 @@ void App::defineProperty(const std::string& def)
 
 /********************************************************* TEST(BEGIN) *****************************************************/
 
+int App::RunGopParallel()
+{
+    MMP_LOG_INFO << "GOP parallel decode config";
+    MMP_LOG_INFO << "-- codec name : " << decoderClassName;
+    MMP_LOG_INFO << "-- input :  " << inputFile;
+    MMP_LOG_INFO << "-- decoders : " << gopParallel;
+    if (show)
+    {
+        MMP_LOG_INFO << "-- display is ignored in gop parallel mode";
+    }
+    if (!AbstractPacketReader::IsAnnexB(inputFile))
+    {
+        // Hint : GopParallelDecoder 按 AnnexBIndex 切分文件, 封装格式的输入需先转为裸流
+        MMP_LOG_ERROR << "gop_parallel only supports Annex-B input, input is: " << inputFile;
+        return 255;
+    }
+
+    GopParallelDecoder::ptr decoder = std::make_shared<GopParallelDecoder>(decoderClassName, GetDecoderCodecType(decoderClassName), gopParallel);
+    Poco::Stopwatch sw;
+    sw.start();
+    uint64_t frames = decoder->Run(inputFile, [&](AbstractFrame::ptr frame)
+    {
+        // Hint : 按显示顺序输出, 缩略图/分析等离线处理在此消费
+    });
+    sw.stop();
+    if (frames == 0)
+    {
+        MMP_LOG_ERROR << "GOP parallel decode fail, no frame decoded, input is: " << inputFile;
+        return 255;
+    }
+    double second = sw.elapsed() / 1000000.0;
+    MMP_LOG_INFO << "GOP parallel decode, decoders : " << gopParallel << ", frames : " << frames << ", cost : " << sw.elapsed() / 1000 << " ms"
+                 << ", fps : " << (second > 0 ? frames / second : 0);
+    ReportPerfMetric("gop_parallel_decode_fps", second > 0 ? frames / second : 0);
+    return 0;
+}
+
+/**
+ * @note 与 main 中手工连接的线程相同的拓扑, 各级之间改为有界队列, 由 pipeline.* 配置连接方式及队列深度;
+ *       不支持 seek / replay / alloc_assert
+ */
+int App::RunPipeline()
+{
+    MMP_LOG_INFO << "Pipeline decode config";
+    MMP_LOG_INFO << "-- codec name : " << decoderClassName;
+    MMP_LOG_INFO << "-- input :  " << inputFile;
+    MMP_LOG_INFO << "-- nodes : " << config().getString("pipeline.nodes");
+
+    Codec::AbstractDecoder::ptr decoder = Codec::DecoderFactory::DefaultFactory().CreateDecoder(decoderClassName);
+    if (!decoder)
+    {
+        MMP_LOG_ERROR << "Unsupport decoder, name is: " << decoderClassName;
+        displayHelp();
+        return 0;
+    }
+    Codec::CodecType codecType = GetDecoderCodecType(decoderClassName);
+    AbstractPacketReader::ptr byteReader = AbstractPacketReader::Create(inputFile, codecType);
+    if (!byteReader->IsOpen())
+    {
+        MMP_LOG_ERROR << "Open input fail, input is: " << inputFile;
+        return 255;
+    }
+    if (byteReader->GetCodecType() != codecType)
+    {
+        MMP_LOG_ERROR << "Input codec type " << byteReader->GetCodecType() << " does not match decoder " << decoderClassName << " (" << codecType << ")";
+        return 255;
+    }
+    AbstractDisplay::ptr display;
+    if (show)
+    {
+        display = AbstractDisplay::Create();
+    }
+    if (display)
+    {
+        display->Init();
+        display->SetFitToDisplay(fitDisplay, scaleFilter);
+    }
+    decoder->Init();
+    decoder->Start();
+
+    bool pushFailed = false;
+    PipelineGraph::ptr graph = std::make_shared<PipelineGraph>();
+    graph->RegisterType("reader", [&]() -> PipelineNode::ptr
+    {
+        return PipelineNode::Create([&](PipelineItem& item, PipelineEmitter& emitter) -> bool
+        {
+            Codec::StreamPack::ptr pack = byteReader->GetPacket();
+            if (!pack)
+            {
+                return false;
+            }
+            item.Set(pack);
+            emitter.Emit(item);
+            return true;
+        });
+    });
+    graph->RegisterType("decode", [&]() -> PipelineNode::ptr
+    {
+        // Hint : 送入的帧数与已取出的帧数, 输入结束后据此确定解码器中剩余的帧数
+        std::shared_ptr<uint64_t> pushedPictures = std::make_shared<uint64_t>(0);
+        std::shared_ptr<uint64_t> poppedFrames = std::make_shared<uint64_t>(0);
+        auto drain = [&, poppedFrames](PipelineItem& item, PipelineEmitter& emitter) -> void
+        {
+            AbstractFrame::ptr frame;
+            while (decoder->Pop(frame))
+            {
+                (*poppedFrames)++;
+                item.Set(frame);
+                emitter.Emit(item);
+            }
+        };
+        return PipelineNode::Create([&, drain, pushedPictures](PipelineItem& item, PipelineEmitter& emitter) -> bool
+        {
+            Codec::StreamPack::ptr pack = item.Get<Codec::StreamPack>();
+            if (!decoder->Push(pack))
+            {
+                // Hint : 返回 false 停止整个流水线, 此时不调用 Flush
+                MMP_LOG_ERROR << "Push pack to decoder fail, pack index : " << item.index;
+                pushFailed = true;
+                return false;
+            }
+            if (byteReader->IsPictureStart(pack))
+            {
+                (*pushedPictures)++;
+            }
+            drain(item, emitter);
+            return true;
+        }, [&, pushedPictures, poppedFrames](PipelineEmitter& emitter)
+        {
+            // Hint : 送入结束标记取出解码器为重排保留的尾部帧, 取满即结束
+            PipelineItem item;
+            uint64_t expectFrames = *pushedPictures > *poppedFrames ? *pushedPictures - *poppedFrames : 0;
+            FlushDecoder(decoder, codecType, expectFrames, 2000, [&](AbstractFrame::ptr frame)
+            {
+                item.Set(frame);
+                emitter.Emit(item);
+            });
+        });
+    });
+    graph->RegisterType("display", [&]() -> PipelineNode::ptr
+    {
+        std::shared_ptr<bool> first = std::make_shared<bool>(true);
+        return PipelineNode::Create([&, first](PipelineItem& item, PipelineEmitter& emitter) -> bool
+        {
+            Codec::StreamFrame::ptr streamFrame = std::dynamic_pointer_cast<Codec::StreamFrame>(item.Get<AbstractFrame>());
+            if (!streamFrame || !display)
+            {
+                return true;
+            }
+            if (*first)
+            {
+                display->Open(streamFrame->info);
+                *first = false;
+            }
+            display->UpdateWindow((const uint32_t*)streamFrame->GetData(0), streamFrame->info);
+            emitter.Emit(item);
+            return true;
+        });
+    });
+    bool success = graph->Build(config());
+    if (success)
+    {
+        graph->Run();
+        graph->Report();
+    }
+    graph.reset();
+
+    if (display)
+    {
+        display->Close();
+        display->UnInit();
+    }
+    decoder->Stop();
+    decoder->Uninit();
+    return success && !pushFailed ? 0 : 255;
+}
+
 int App::main(const ArgVec& args)
 {
+    if (gopParallel > 0)
+    {
+        return RunGopParallel();
+    }
+    if (config().has("pipeline.nodes"))
+    {
+        return RunPipeline();
+    }
     AbstractDisplay::ptr display;
     Codec::AbstractDecoder::ptr decoder = Codec::DecoderFactory::DefaultFactory().CreateDecoder(decoderClassName);
     {
@@ -344,7 +550,33 @@ int App::main(const ArgVec& args)
         MMP_LOG_INFO << "-- codec name : " << decoderClassName;
         MMP_LOG_INFO << "-- input :  " << inputFile;
         MMP_LOG_INFO << "-- display : " << (show ? "true" : "false");
+        MMP_LOG_INFO << "-- fit_display : " << (fitDisplay ? (scaleFilter == ScaleFilter::AREA ? "area" : "bilinear") : "none");
         MMP_LOG_INFO << "-- fps : " << fps;
+        if (seekFrame >= 0 || seekSecond >= 0)
+        {
+            MMP_LOG_INFO << "-- seek : " << (seekFrame >= 0 ? std::to_string(seekFrame) : std::to_string(seekSecond) + "s");
+        }
+        for (const auto& scrub : scrubs)
+        {
+            MMP_LOG_INFO << "-- scrub : at " << scrub.first << " to " << scrub.second;
+        }
+        if (loopTime > 0 || loopSecond > 0)
+        {
+            MMP_LOG_INFO << "-- replay : " << (loopTime > 0 ? std::to_string(loopTime) : std::to_string(loopSecond) + "s");
+        }
+        if (allocWarmUp >= 0)
+        {
+            MMP_LOG_INFO << "-- alloc_assert : after " << allocWarmUp << " frames";
+            if (!AllocTracker::Enabled())
+            {
+                MMP_LOG_WARN << "Alloc tracker is not compiled in, rebuild with -DMMP_SAMPLE_ALLOC_TRACKER=ON";
+            }
+            if (loopTime == 0 && loopSecond <= 0)
+            {
+                // Hint : 逐 NAL 读文件时每个包都需要新的 StreamPack, 只有回放路径可以做到无分配
+                MMP_LOG_WARN << "alloc_assert only takes effect with replay";
+            }
+        }
         std::this_thread::sleep_for(std::chrono::seconds(1));
     }
 
@@ -365,9 +597,110 @@ int App::main(const ArgVec& args)
     if (display)
     {
         display->Init();
+        display->SetFitToDisplay(fitDisplay, scaleFilter);
+    }
+    Codec::CodecType codecType = GetDecoderCodecType(decoderClassName);
+    AbstractPacketReader::ptr byteReader = AbstractPacketReader::Create(inputFile, codecType);
+    if (!byteReader->IsOpen())
+    {
+        MMP_LOG_ERROR << "Open input fail, input is: " << inputFile;
+        if (display)
+        {
+            display->UnInit();
+        }
+        decoder->Stop();
+        decoder->Uninit();
+        return 255;
+    }
+    if (byteReader->GetCodecType() != codecType)
+    {
+        MMP_LOG_ERROR << "Input codec type " << byteReader->GetCodecType() << " does not match decoder " << decoderClassName << " (" << codecType << ")";
+        if (display)
+        {
+            display->UnInit();
+        }
+        decoder->Stop();
+        decoder->Uninit();
+        return 255;
     }
-    std::shared_ptr<H26XFileByteReader> byteReader = std::make_shared<H26XFileByteReader>(inputFile);
     Codec::StreamPack::ptr pack = nullptr;
+    bool replay = loopTime > 0 || loopSecond > 0;
+
+    // Hint : 从最近的关键帧开始送入解码器, 关键帧到目标帧之间解码出的帧直接丢弃;
+    //        IDR 之前解码的帧在显示顺序上也都在它之前, 其显示序号等于解码序号, 因此丢弃数按输出顺序计数:
+    //        定位后输出的第 n 帧即显示序号 keyFrame + n, 含 B 帧的码流同样成立
+    std::atomic<uint64_t> dropFrames(0);
+    std::atomic<uint64_t> decodedFrames(0);
+    std::atomic<bool>     flushing(false);
+    uint64_t pushedPictures = 0;
+    std::shared_ptr<H26XFileByteReader> annexBReader = std::dynamic_pointer_cast<H26XFileByteReader>(byteReader);
+    AnnexBIndex::ptr index;
+    bool indexFail = false;
+    auto seekTo = [&](uint64_t targetFrame) -> void
+    {
+        uint64_t keyFrame = 0;
+        Codec::StreamPack::ptr parameterSets;
+        Poco::Timestamp stamp;
+        if (annexBReader)
+        {
+            // Hint : 裸流没有帧索引, 通过 AnnexBIndex 扫描 (或加载缓存的) 随机访问点
+            if (!index && !indexFail)
+            {
+                index = std::make_shared<AnnexBIndex>(codecType);
+                indexFail = !index->LoadOrBuild(inputFile);
+            }
+            if (indexFail)
+            {
+                MMP_LOG_WARN << "Build index fail, seek is ignored";
+                return;
+            }
+            // Hint : 参数集只在码流开头出现时, 随机访问点之前需要重新送入最近的参数集
+            keyFrame = index->SeekToFrame(*annexBReader, targetFrame, parameterSets);
+        }
+        else if (!byteReader->SeekToFrame(targetFrame, keyFrame))
+        {
+            MMP_LOG_WARN << "Seek is not supported, seek is ignored";
+            return;
+        }
+        if (parameterSets)
+        {
+            decoder->Push(parameterSets);
+        }
+        dropFrames = targetFrame > keyFrame ? targetFrame - keyFrame : 0;
+        MMP_LOG_INFO << "Seek to frame " << targetFrame << ", keyframe " << keyFrame << ", drop " << dropFrames << " frames, cost " << stamp.elapsed() / 1000 << " ms";
+    };
+    // Hint : 送入结束标记后等待已送入的帧全部输出; discard 时这些帧由显示循环丢弃 (seek), 否则正常显示 (输入结束)
+    auto flushDecoder = [&](bool discard) -> void
+    {
+        constexpr int64_t kFlushIdleTimeoutUs = 2000 * 1000;
+        flushing = discard;
+        decoder->Push(CreateEndOfStreamPack(codecType));
+        Poco::Timestamp idle;
+        uint64_t lastDecodedFrames = decodedFrames;
+        while (decodedFrames < pushedPictures && idle.elapsed() < kFlushIdleTimeoutUs)
+        {
+            if (decodedFrames != lastDecodedFrames)
+            {
+                lastDecodedFrames = decodedFrames;
+                idle.update();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (decodedFrames < pushedPictures)
+        {
+            MMP_LOG_WARN << "Decoder flush incomplete, pushed " << pushedPictures << " frames, decoded " << decodedFrames;
+        }
+        pushedPictures = decodedFrames;
+        flushing = false;
+    };
+    if (seekFrame >= 0 || seekSecond >= 0)
+    {
+        seekTo(seekFrame >= 0 ? (uint64_t)seekFrame : (uint64_t)(seekSecond * fps));
+    }
+    if (!scrubs.empty() && replay)
+    {
+        MMP_LOG_WARN << "scrub is not supported with replay, ignored";
+    }
 
     //
     // Input File Read -> VDEC PUSH
@@ -376,9 +709,15 @@ int App::main(const ArgVec& args)
 
     /***************************************** 渲染线程(Begin) ****************************************/
     std::atomic<bool> running(true);
-    std::atomic<bool> sync(false);
-    Promise<void>::ptr displayTask = std::make_shared<Promise<void>>([&]()
+    AllocStage feedStage("feed");
+    AllocStage displayStage("display");
+    feedStage.SetWarmUp(allocWarmUp > 0 ? (uint64_t)allocWarmUp : 0);
+    displayStage.SetWarmUp(allocWarmUp > 0 ? (uint64_t)allocWarmUp : 0);
+    // Hint : 显示循环在整个解码期间不返回, 使用常驻线程槽, 不占用 WorkStealingPool 的工作线程
+    TaskGroup::ptr displayTask = WorkStealingPool::Instance().CommitLongRunning("display", [&]()
     {
+        // Hint : 显示线程绑定后不再迁移
+        ThreadPlacement::Instance().Apply(PipelineStage::DISPLAY);
         uint64_t intervalMs = 1000 / fps;
         Poco::Stopwatch sw;
         sw.start();
@@ -388,16 +727,51 @@ int App::main(const ArgVec& args)
             AbstractFrame::ptr frame;
             if (decoder->Pop(frame))
             {
-                MMP_LOG_INFO << "AbstractDisplay Pop";
-                Codec::StreamFrame::ptr streamFrame = std::dynamic_pointer_cast<Codec::StreamFrame>(frame);
-                if (display && first)
+                if (!replay)
+                {
+                    // Hint : 回放时逐帧日志的开销会计入 decode_fps
+                    MMP_LOG_INFO << "AbstractDisplay Pop";
+                }
+                // Hint : 先读 flushing 再计数, flush 等到计数达到送入帧数时, 这些帧的丢弃判断均已完成
+                bool discard = flushing;
+                decodedFrames++;
+                // Hint : 断言覆盖整帧处理, MMP-Core 的调用 (Open / UpdateWindow) 以 AllocAssertPause 排除, 其分配只统计不断言
+                bool steady = replay && allocWarmUp >= 0 && decodedFrames > (uint64_t)allocWarmUp;
+                bool shown = false;
                 {
-                    display->Open(streamFrame->info);
-                    first = false;
+                    AllocAssertScope noAlloc(steady);
+                    if (discard)
+                    {
+                        continue;
+                    }
+                    if (dropFrames > 0)
+                    {
+                        dropFrames--;
+                        continue;
+                    }
+                    Codec::StreamFrame::ptr streamFrame = std::dynamic_pointer_cast<Codec::StreamFrame>(frame);
+                    if (display && first)
+                    {
+                        AllocAssertPause external;
+                        display->Open(streamFrame->info);
+                        first = false;
+                    }
+                    if (display)
+                    {
+                        displayStage.Begin();
+                        Poco::Timestamp displayStamp;
+                        {
+                            // Hint : UpdateWindow 经 FrameScaler 缩放, 其 ParallelFor 派发任务时会分配
+                            AllocAssertPause external;
+                            display->UpdateWindow((const uint32_t*)streamFrame->GetData(0), streamFrame->info);
+                        }
+                        ThreadPlacement::Instance().Sample(PipelineStage::DISPLAY, streamFrame->GetData(0), displayStamp.elapsed());
+                        displayStage.End();
+                        shown = true;
+                    }
                 }
-                if (display)
+                if (shown)
                 {
-                    display->UpdateWindow((const uint32_t*)streamFrame->GetData(0), streamFrame->info);
                     if (intervalMs > sw.elapsed() / 1000)
                     {
                         std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs - sw.elapsed() / 1000));
@@ -409,38 +783,111 @@ int App::main(const ArgVec& args)
                     sw.restart();
                 }
             }
-            sync = true;
         } 
     });
-    ThreadPool::ThreadPoolSingleton()->Commit(displayTask);
     /***************************************** 渲染线程(End) ****************************************/
     /*********************************** 解码线程(Begin) ******************************/
-    size_t currentLoopTime = 0;
-    // loopTime = 120; // for quick exit debug
-    do
+    ThreadPlacement::Instance().Apply(PipelineStage::DECODE);
+    if (loopTime == 0 && loopSecond <= 0)
+    {
+        uint64_t fedPictures = 0;
+        size_t nextScrub = 0;
+        do
+        {
+            Poco::Timestamp feedStamp;
+            pack = byteReader->GetPacket();
+            if (pack)
+            {
+                bool pictureStart = byteReader->IsPictureStart(pack);
+                if (pictureStart && nextScrub < scrubs.size() && fedPictures >= scrubs[nextScrub].first)
+                {
+                    // Hint : 在新一帧开始处跳转, 该帧不再送入; 先清空解码器中尚未输出的帧, 再从新的随机访问点送入
+                    MMP_LOG_INFO << "Scrub at frame " << fedPictures << " to frame " << scrubs[nextScrub].second;
+                    flushDecoder(true);
+                    seekTo(scrubs[nextScrub].second);
+                    nextScrub++;
+                    continue;
+                }
+                MMP_LOG_INFO << "AbstractDisplay Push";
+                decoder->Push(pack);
+                if (pictureStart)
+                {
+                    fedPictures++;
+                    pushedPictures++;
+                }
+                ThreadPlacement::Instance().Sample(PipelineStage::DECODE, pack->GetData(), feedStamp.elapsed());
+            }
+        } while (pack);
+        // Hint : 输入结束, 取出解码器中缓存的尾部帧
+        flushDecoder(false);
+    }
+    else
     {
-        pack = byteReader->GetNalUint();
-        if (pack)
+        // Hint : 回放阶段只有解码开销, 不读取文件也不解析起始码
+        PacketReplayCache::ptr cache = std::make_shared<PacketReplayCache>(byteReader->GetCodecType());
+        Poco::Timestamp loadStamp;
+        cache->Load(*byteReader);
+        MMP_LOG_INFO << "Preload cost " << loadStamp.elapsed() / 1000 << " ms";
+        Poco::Stopwatch sw;
+        sw.start();
+        size_t currentLoopTime = 0;
+        uint64_t pushBytes = 0;
+        uint64_t pushPacks = 0;
+        while (cache->GetPackCount() != 0)
         {
+            if (loopTime > 0 && currentLoopTime >= loopTime)
+            {
+                break;
+            }
+            if (loopSecond > 0 && sw.elapsed() >= (Poco::Timestamp::TimeDiff)(loopSecond * 1000000))
+            {
+                break;
+            }
+            for (size_t i = 0; i < cache->GetPackCount(); i++)
+            {
+                // Hint : 断言覆盖整个取包及送包过程, Push 属于 MMP-Core, 其内部分配只统计不断言
+                bool steady = allocWarmUp >= 0 && pushPacks >= (uint64_t)allocWarmUp;
+                {
+                    AllocAssertScope noAlloc(steady);
+                    feedStage.Begin();
+                    Poco::Timestamp feedStamp;
+                    Codec::StreamPack::ptr replayPack = cache->GetPack(i);
+                    {
+                        AllocAssertPause external;
+                        decoder->Push(replayPack);
+                    }
+                    ThreadPlacement::Instance().Sample(PipelineStage::DECODE, replayPack->GetData(), feedStamp.elapsed());
+                    feedStage.End();
+                }
+                pushPacks++;
+            }
+            pushBytes += cache->GetBytes();
+            pushedPictures += cache->GetPictureCount();
             currentLoopTime++;
-            MMP_LOG_INFO << "AbstractDisplay Push";
-            decoder->Push(pack);
         }
-    } while (pack && (loopTime == 0 || currentLoopTime < loopTime));
+        // Hint : 计时包含 flush, decode_fps 以全部送入帧解码输出为准, 不受解码器内部缓存深度影响
+        flushDecoder(false);
+        sw.stop();
+        double second = sw.elapsed() / 1000000.0;
+        MMP_LOG_INFO << "Replay " << currentLoopTime << " times, cost : " << sw.elapsed() / 1000 << " ms, frames : " << decodedFrames
+                     << ", fps : " << (second > 0 ? decodedFrames / second : 0) << ", bitrate : " << (second > 0 ? pushBytes * 8 / second / 1000000 : 0) << " Mbps";
+        ReportPerfMetric("decode_fps", second > 0 ? decodedFrames / second : 0);
+        feedStage.Report();
+    }
     /*********************************** 解码线程(End) ******************************/
 
+    // Hint : 先结束显示循环再关闭显示, 避免关闭后仍有 UpdateWindow
+    running = false;
+    displayTask->Wait();
     if (display)
     {
         display->Close();
         display->UnInit();
     }
 
-    running = false;
-    while (!sync)
-    {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
-
+    displayStage.Report();
+    ThreadPlacement::Instance().Report();
+    WorkStealingPool::Instance().Report();
     decoder->Stop();
     decoder->Uninit();
     return 0;
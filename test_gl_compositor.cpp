@@ -2,6 +2,7 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <deque>
 #include <Poco/Stopwatch.h>
@@ -31,6 +32,15 @@
 
 #include "AbstractDisplay.h"
 #include "SampleUtils.h"
+#include "RenderThread.h"
+#include "StartupTimeline.h"
+#include "SceneItemTable.h"
+#include "DownscaleChain.h"
+#include "PresentThread.h"
+#include "AllocTracker.h"
+#include "ThreadPlacement.h"
+#include "LoadGovernor.h"
+#include "WorkStealingPool.h"
 
 
 using namespace Mmp;
@@ -58,6 +68,13 @@ private:
     void HandleFps(const std::string& name, const std::string& value);
     void HandleMerryGoRound(const std::string& name, const std::string& value);
     void HandleDuration(const std::string& name, const std::string& value);
+    void HandleDownscale(const std::string& name, const std::string& value);
+    void HandleDisplay(const std::string& name, const std::string& value);
+    void HandleAllocAssert(const std::string& name, const std::string& value);
+    void HandlePlacement(const std::string& name, const std::string& value);
+    void HandleGovernor(const std::string& name, const std::string& value);
+    void HandleDirectPresent(const std::string& name, const std::string& value);
+    void HandleFitDisplay(const std::string& name, const std::string& value);
     void displayHelp();
 public:
     GPUBackend backend;
@@ -65,11 +82,15 @@ public:
     uint64_t   duration;
     uint32_t   fps;
     bool       merryGoRound;
+    bool       downscale;
+    bool       show;
+    int64_t    allocWarmUp;
+    bool       governorEnable;
+    bool       directPresent;
+    bool       fitDisplay;
+    ScaleFilter scaleFilter;
 private: /* gpu */
-    std::atomic<bool> _gpuInited;
-    std::thread _renderThread;
-    AbstractWindows::ptr _window;
-    GLDrawContex::ptr    _draw;
+    RenderThread::ptr _renderThread;
 };
 
 App::App()
@@ -78,7 +99,14 @@ App::App()
     splitNum = 4;
     fps = 60;
     merryGoRound = false;
+    downscale = false;
+    show = true;
     duration = 30;
+    allocWarmUp = -1;
+    governorEnable = true;
+    directPresent = false;
+    fitDisplay = true;
+    scaleFilter = ScaleFilter::AREA;
 }
 
 void App::displayHelp()
@@ -103,7 +131,7 @@ void App::HandleBackend(const std::string& name, const std::string& value)
 void App::HandleSplitNum(const std::string& name, const std::string& value)
 {
     splitNum = std::stoi(value);
-    splitNum = std::min(splitNum, (size_t)8);
+    splitNum = std::min(splitNum, (size_t)16);
     splitNum = std::max(splitNum, (size_t)2);
 }
 
@@ -133,58 +161,86 @@ void App::HandleDuration(const std::string& name, const std::string& value)
     duration = std::max(duration, (uint64_t)1);
 }
 
+void App::HandleDownscale(const std::string& name, const std::string& value)
+{
+    if (value == "true")
+    {
+        downscale = true;
+    }
+}
+
+void App::HandleDisplay(const std::string& name, const std::string& value)
+{
+    if (value == "false")
+    {
+        show = false;
+    }
+}
+
+void App::HandleAllocAssert(const std::string& name, const std::string& value)
+{
+    allocWarmUp = value.empty() ? 60 : std::stoll(value);
+    allocWarmUp = std::max(allocWarmUp, (int64_t)0);
+}
+
+void App::HandleGovernor(const std::string& name, const std::string& value)
+{
+    if (value == "false")
+    {
+        governorEnable = false;
+    }
+}
+
+void App::HandleDirectPresent(const std::string& name, const std::string& value)
+{
+    if (value == "true")
+    {
+        directPresent = true;
+    }
+}
+
+void App::HandleFitDisplay(const std::string& name, const std::string& value)
+{
+    if (value == "none" || value == "false")
+    {
+        fitDisplay = false;
+    }
+    else if (value == "bilinear")
+    {
+        scaleFilter = ScaleFilter::BILINEAR;
+    }
+}
+
+void App::HandlePlacement(const std::string& name, const std::string& value)
+{
+    // Hint : <stage>=<spec> 写入 placement.<stage>, 与配置文件中的 key 一致
+    std::string::size_type pos = value.find('=');
+    if (pos == std::string::npos)
+    {
+        MMP_LOG_WARN << "Invalid placement : " << value << ", expect <stage>=<spec>";
+        return;
+    }
+    config().setString("placement." + value.substr(0, pos), value.substr(pos + 1));
+}
+
 void App::Initialize()
 {
+    ThreadPlacement::Instance().Load(config());
     ThreadPool::ThreadPoolSingleton()->Init();
+    ThreadPlacement::Instance().ApplyThreadPool(std::thread::hardware_concurrency());
+    WorkStealingPool::Instance().Init();
     Codec::CodecConfig::Instance()->Init();
-    {
-        _renderThread = std::thread([this]() -> void
-        {
-            GLDrawContex::SetGPUBackendType(backend);
-            _window = WindowFactory::DefaultFactory().createWindow(WindowFactory::DefaultFactory().GetGuessClassName(backend));
-            _window->SetRenderMode(false);
-            _window->Open();
-            _window->BindRenderThread(true);
-            _draw = GLDrawContex::Instance();
-            _draw->SetWindows(_window);
-            _gpuInited = true;
-            _draw->ThreadStart();
-            while (true)
-            {
-                GpuTaskStatus status;
-                status = _draw->ThreadFrame();
-                if (status == GpuTaskStatus::EXIT)
-                {
-                    break;
-                }
-                else if (status == GpuTaskStatus::PRESENT)
-                {
-                    _window->Swap();
-                }
-                else
-                {
-                    continue;
-                }
-            };
-            _draw->ThreadEnd();
-            _window->BindRenderThread(false);
-            _window->Close();
-        });
-        while (!_gpuInited)
-        {
-            std::this_thread::sleep_for(std::chrono::microseconds(200));
-        }
-    }
+    _renderThread = std::make_shared<RenderThread>(backend);
+    // Hint : 不等待 GPU 就绪, 与资源解码等步骤并行, 使用 GPU 前调用 WaitReady
+    _renderThread->Start(false);
 }
 
 void App::Uninitialize()
 {
     Application::uninitialize();
-    {
-        _draw->ThreadStop();
-        _renderThread.join();
-    }
+    _renderThread->Stop();
     Codec::CodecConfig::Instance()->Uninit();
+    WorkStealingPool::Instance().Uninit();
     ThreadPool::ThreadPoolSingleton()->Uninit();
 }
 
@@ -212,7 +268,7 @@ void App::defineOptions(OptionSet& options)
         .argument("[type]")
         .callback(OptionCallback<App>(this, &App::HandleBackend))
     );
-    options.addOption(Option("split_num", "sn", "default(4), 2~8, 2*2, 3*3, n*n")
+    options.addOption(Option("split_num", "sn", "default(4), 2~16, 2*2, 3*3, n*n")
         .required(false)
         .repeatable(false)
         .argument("[num]")
@@ -236,7 +292,48 @@ void App::defineOptions(OptionSet& options)
         .argument("[num]")
         .callback(OptionCallback<App>(this, &App::HandleDuration))
     );
-    
+    options.addOption(Option("downscale", "ds", "default(false), true or false, sample pre-scaled level closest to item size")
+        .required(false)
+        .repeatable(false)
+        .argument("[switch]")
+        .callback(OptionCallback<App>(this, &App::HandleDownscale))
+    );
+    options.addOption(Option("display", "display", "default(true), true or false, false for offscreen run")
+        .required(false)
+        .repeatable(false)
+        .argument("[show]")
+        .callback(OptionCallback<App>(this, &App::HandleDisplay))
+    );
+    options.addOption(Option("alloc_assert", "aa", "default(off), [warm up frames], abort on heap allocation after warm up, build with MMP_SAMPLE_ALLOC_TRACKER")
+        .required(false)
+        .repeatable(false)
+        .argument("[frames]", false)
+        .callback(OptionCallback<App>(this, &App::HandleAllocAssert))
+    );
+    options.addOption(Option("placement", "pl", "<stage>=<spec>, stage is render/pool/display/main/memory, spec is cpu:0-3,8 or node:1")
+        .required(false)
+        .repeatable(true)
+        .argument("[placement]")
+        .callback(OptionCallback<App>(this, &App::HandlePlacement))
+    );
+    options.addOption(Option("governor", "gov", "default(true), true or false, degrade step by step under overload (skip readback, drop display, lower resolution, reduce fps)")
+        .required(false)
+        .repeatable(false)
+        .argument("[enable]")
+        .callback(OptionCallback<App>(this, &App::HandleGovernor))
+    );
+    options.addOption(Option("direct_present", "dp", "default(false), true or false, read back straight into the locked display texture and present on the main loop thread")
+        .required(false)
+        .repeatable(false)
+        .argument("[enable]")
+        .callback(OptionCallback<App>(this, &App::HandleDirectPresent))
+    );
+    options.addOption(Option("fit_display", "fd", "default(area), area, bilinear or none, shrink the window to fit the screen and scale on CPU before upload")
+        .required(false)
+        .repeatable(false)
+        .argument("[filter]")
+        .callback(OptionCallback<App>(this, &App::HandleFitDisplay))
+    );
 }
 
 void App::defineProperty(const std::string& def)
@@ -265,17 +362,53 @@ int App::main(const ArgVec& args)
     MMP_LOG_INFO << "-- fps : " << fps;
     MMP_LOG_INFO << "-- merry_go_round : " << (merryGoRound ? "true" : "false");
     MMP_LOG_INFO << "-- duration : " << duration << " second";
-    Initialize();
-
-    AbstractPicture::ptr sceneA = GetFrame1920x1080A();
-    AbstractPicture::ptr sceneB = GetFrame1920x1080B();
-    AbstractDisplay::ptr display = AbstractDisplay::Create();
+    MMP_LOG_INFO << "-- downscale : " << (downscale ? "true" : "false");
+    MMP_LOG_INFO << "-- display : " << (show ? "true" : "false");
+    MMP_LOG_INFO << "-- governor : " << (governorEnable ? "true" : "false");
+    MMP_LOG_INFO << "-- direct_present : " << (directPresent ? "true" : "false");
+    MMP_LOG_INFO << "-- fit_display : " << (fitDisplay ? (scaleFilter == ScaleFilter::AREA ? "area" : "bilinear") : "none");
+    if (allocWarmUp >= 0)
+    {
+        MMP_LOG_INFO << "-- alloc_assert : after " << allocWarmUp << " frames";
+        if (!AllocTracker::Enabled())
+        {
+            MMP_LOG_WARN << "Alloc tracker is not compiled in, rebuild with -DMMP_SAMPLE_ALLOC_TRACKER=ON";
+        }
+    }
+    StartupTimeline timeline;
+    {
+        Poco::Timestamp begin;
+        Initialize();
+        timeline.Record("initialize", begin);
+    }
+    AbstractPicture::ptr sceneA;
+    AbstractPicture::ptr sceneB;
+    Promise<void>::ptr decodeA = std::make_shared<Promise<void>>([&]()
+    {
+        Poco::Timestamp begin;
+        sceneA = GetFrame1920x1080A();
+        timeline.Record("decode A", begin);
+    });
+    Promise<void>::ptr decodeB = std::make_shared<Promise<void>>([&]()
+    {
+        Poco::Timestamp begin;
+        sceneB = GetFrame1920x1080B();
+        timeline.Record("decode B", begin);
+    });
+    ThreadPool::ThreadPoolSingleton()->Commit(decodeA);
+    ThreadPool::ThreadPoolSingleton()->Commit(decodeB);
+    AbstractDisplay::ptr display;
     PixelsInfo info = {1920, 1080, 8, PixelFormat::RGBA8888};
-    AbstractPicture::ptr fb = std::make_shared<NormalPicture>(info);
-    if (display)
     {
-        display->Init();
-        display->Open(info);
+        Poco::Timestamp begin;
+        display = show ? AbstractDisplay::Create() : nullptr;
+        if (display)
+        {
+            display->Init();
+            display->SetFitToDisplay(fitDisplay, scaleFilter);
+            display->Open(info);
+        }
+        timeline.Record("display", begin);
     }
     /******************************* PluginTransitionTest(BEGIN) ********************************/
     Texture::ptr imageA;
@@ -283,50 +416,102 @@ int App::main(const ArgVec& args)
     Texture::ptr canvas;
     Texture::ptr framebuffer;
     {
+        Poco::Timestamp begin;
+        _renderThread->WaitReady();
+        timeline.Record("wait gpu", begin);
+    }
+    {
+        Poco::Timestamp begin;
+        canvas = Gpu::Create2DTextures(GLDrawContex::Instance(), info, "Canvas", GlTextureFlags::TEXTURE_USE_FOR_RENDER)[0];
+        framebuffer = Gpu::Create2DTextures(GLDrawContex::Instance(), info, "Framebuffer", GlTextureFlags::TEXTURE_USE_FOR_RENDER)[0];
+        timeline.Record("create framebuffer", begin);
+    }
+    {
+        decodeA->Wait();
+        Poco::Timestamp begin;
         imageA = Gpu::Create2DTextures(GLDrawContex::Instance(), sceneA->info)[0];
-        imageB = Gpu::Create2DTextures(GLDrawContex::Instance(), sceneB->info)[0];
-        canvas = Gpu::Create2DTextures(GLDrawContex::Instance(), sceneA->info, "Canvas", GlTextureFlags::TEXTURE_USE_FOR_RENDER)[0];
-        framebuffer = Gpu::Create2DTextures(GLDrawContex::Instance(), sceneA->info, "Framebuffer", GlTextureFlags::TEXTURE_USE_FOR_RENDER)[0];
         Gpu::Update2DTextures(GLDrawContex::Instance(), std::vector<Texture::ptr>({imageA}), sceneA);
+        timeline.Record("upload A", begin);
+    }
+    {
+        decodeB->Wait();
+        Poco::Timestamp begin;
+        imageB = Gpu::Create2DTextures(GLDrawContex::Instance(), sceneB->info)[0];
         Gpu::Update2DTextures(GLDrawContex::Instance(), std::vector<Texture::ptr>({imageB}), sceneB);
+        timeline.Record("upload B", begin);
     }
     
-    Promise<void>::ptr lastDraw;
+    // Hint : 常驻显示线程, 读回直接写入信箱的 back 画面, 发布不阻塞, 显示耗时不影响合成
+    // Hint : 直写模式下读回目标为加锁的显示纹理, 在本线程 Present, 不经过显示线程;
+    //        纹理内存不是紧密排列时 (跨距不等于宽度) 无法直接作为读回目标, 回退至信箱
+    if (directPresent && display)
+    {
+        DisplayBuffer buffer;
+        if (display->AcquireBuffer(buffer))
+        {
+            // Hint : 窗口被缩小时显示纹理小于读回画面, 同样回退
+            bool sameSize = buffer.info.width == info.width && buffer.info.height == info.height;
+            AbstractPicture::ptr probe = sameSize ? WrapDisplayBuffer(buffer) : nullptr;
+            memset(buffer.data[0], 0, (size_t)buffer.stride[0] * buffer.info.height);
+            display->Present();
+            if (!probe)
+            {
+                MMP_LOG_WARN << "Display buffer is not tightly packed or window is scaled, fallback to mailbox present";
+                directPresent = false;
+            }
+        }
+        else
+        {
+            MMP_LOG_WARN << "Display does not support AcquireBuffer, fallback to mailbox present";
+            directPresent = false;
+        }
+    }
+    bool direct = directPresent && display;
+    DisplayBufferCache displayBuffers;
+    PresentThread::ptr presentThread = std::make_shared<PresentThread>(direct ? nullptr : display, info);
+    presentThread->Start();
     auto equalSplitScreen = [&](size_t count, size_t fps, uint64_t duration) -> void
     {
+        Texture::ptr tileA = imageA;
+        Texture::ptr tileB = imageB;
+        uint64_t sampledBytesPerFrame = 0;
+        DownscaleChain::ptr chainA;
+        DownscaleChain::ptr chainB;
+        size_t levelA = 0;
+        size_t levelB = 0;
+        // Hint : 开启降级时缩放链也提前生成, 避免在过载时才在循环内生成, 加重过载
+        if (downscale || governorEnable)
+        {
+            chainA = std::make_shared<DownscaleChain>(sceneA->info);
+            chainB = std::make_shared<DownscaleChain>(sceneB->info);
+            chainA->Build(imageA);
+            chainB->Build(imageB);
+            MMP_LOG_INFO << "Downscale resident bytes : " << (chainA->GetResidentBytes() + chainB->GetResidentBytes()) / 1024 << " KiB";
+        }
+        if (downscale)
+        {
+            levelA = chainA->Select((uint32_t)(info.width / count), (uint32_t)(info.height / count));
+            levelB = chainB->Select((uint32_t)(info.width / count), (uint32_t)(info.height / count));
+            MMP_LOG_INFO << "Downscale level A : " << chainA->GetLevelInfo(levelA).width << "x" << chainA->GetLevelInfo(levelA).height;
+            MMP_LOG_INFO << "Downscale level B : " << chainB->GetLevelInfo(levelB).width << "x" << chainB->GetLevelInfo(levelB).height;
+            // Hint : chain 中的纹理由 shared_ptr 持有, chain 释放后仍然有效
+            tileA = chainA->GetLevel(levelA);
+            tileB = chainB->GetLevel(levelB);
+        }
         Gpu::AbstractSceneLayer::ptr layer = Gpu::AbstractSceneLayer::Create();
+        SceneItemTable::ptr table = std::make_shared<SceneItemTable>(layer);
         std::vector<Gpu::SceneItemParam> params;
-        std::vector<Gpu::AbstractSceneItem::ptr> items;
-        size_t curItem = 0;
+        std::vector<Gpu::SceneItemParam> rotatedParams;
+        std::vector<bool> itemUseA;
         // Init params and items
         for (size_t col=0; col<count; col++)
         {
             for (size_t row=0; row<count; row++)
             {
-                {
-                    Gpu::SceneItemParam param = {};
-                    param.location = NormalizedPoint(1.0f/count * row, 1.0f/count * col);
-                    param.area = NormalizedRect(1.0f/count, 1.0f/count);
-                    params.push_back(param);
-                }
-                {
-                    Gpu::AbstractSceneItem::ptr item = Gpu::AbstractSceneItem::Create();
-                    Texture::ptr image;
-                    if ((col+1) % 2 == 1 && (row+1) % 2 == 1)
-                    {
-                        image = imageA;
-                    }
-                    else if ((col+1) % 2 == 0 && (row+1) % 2 == 0)
-                    {
-                        image = imageA;
-                    }
-                    else
-                    {
-                        image = imageB;
-                    }
-                    item->UpdateImage(image);
-                    items.push_back(item);
-                }
+                Gpu::SceneItemParam param = {};
+                param.location = NormalizedPoint(1.0f/count * row, 1.0f/count * col);
+                param.area = NormalizedRect(1.0f/count, 1.0f/count);
+                params.push_back(param);
             }
         }
         // Add items to layer
@@ -334,65 +519,176 @@ int App::main(const ArgVec& args)
         {
             for (size_t row=0; row<count; row++)
             {
-                items[curItem]->SetParam(params[curItem]);
-                layer->AddSceneItem(std::string() + "item" + "_" + std::to_string(row) + "_" + std::to_string(col), items[curItem]);
-                curItem++;
+                Gpu::AbstractSceneItem::ptr item = Gpu::AbstractSceneItem::Create();
+                Texture::ptr image;
+                if ((col+1) % 2 == 1 && (row+1) % 2 == 1)
+                {
+                    image = tileA;
+                }
+                else if ((col+1) % 2 == 0 && (row+1) % 2 == 0)
+                {
+                    image = tileA;
+                }
+                else
+                {
+                    image = tileB;
+                }
+                itemUseA.push_back(image == tileA);
+                item->UpdateImage(image);
+                // Hint : handle 按添加顺序分配, 与 params 下标一一对应
+                table->Add(item, params[col * count + row]);
             }
         }
+        // Hint : A/B 两路交错排列, 按每个 item 实际采样的纹理累计
+        for (bool useA : itemUseA)
+        {
+            const PixelsInfo& tileInfo = useA ? (chainA ? chainA->GetLevelInfo(levelA) : sceneA->info) : (chainB ? chainB->GetLevelInfo(levelB) : sceneB->info);
+            sampledBytesPerFrame += (uint64_t)tileInfo.width * tileInfo.height * 4;
+        }
+        rotatedParams.resize(params.size());
         {
             Gpu::SceneLayerParam param = {};
             param.strategy = Gpu::SceneRenderStrategy::Keep;
             layer->SetParam(param);
             layer->UpdateCanvas(canvas);
         }
+        // Hint : 过载降级时采样更低一级的画面, 缩放链已在循环前生成
+        uint32_t resolutionShift = 0;
+        auto applyResolutionShift = [&](uint32_t shift) -> void
+        {
+            if (!chainA)
+            {
+                return;
+            }
+            Texture::ptr shiftedA = chainA->GetLevel(std::min(levelA + shift, chainA->GetLevelCount() - 1));
+            Texture::ptr shiftedB = chainB->GetLevel(std::min(levelB + shift, chainB->GetLevelCount() - 1));
+            for (size_t handle=0; handle<itemUseA.size(); handle++)
+            {
+                table->GetItem((SceneItemHandle)handle)->UpdateImage(itemUseA[handle] ? shiftedA : shiftedB);
+            }
+            resolutionShift = shift;
+        };
+        LoadGovernor::ptr governor = std::make_shared<LoadGovernor>((uint32_t)fps);
+        governor->SetEnable(governorEnable);
+        // Hint : 循环内复用, 避免每帧构造临时 vector
+        std::vector<Texture::ptr> framebuffers = {framebuffer};
+        AllocStage paramStage("param");
+        AllocStage drawStage("draw");
+        AllocStage readbackStage("readback");
+        AllocStage submitStage("present submit");
+        for (AllocStage* stage : {&paramStage, &drawStage, &readbackStage, &submitStage})
+        {
+            stage->SetWarmUp(allocWarmUp > 0 ? (uint64_t)allocWarmUp : 0);
+        }
+        ThreadPlacement::Instance().Apply(PipelineStage::MAIN);
         Poco::Timestamp stamp;
         uint64_t curDrawTime = 0;
         uint64_t itemParamOffset = 0;
-        for (uint32_t i=0; i< fps * duration; i++)
+        uint64_t totalCostUs = 0;
+        uint64_t maxCostUs = 0;
+        // Hint : 按时长而不是帧数结束, 降帧率时总时长不变
+        Poco::Timestamp runStamp;
+        while (runStamp.elapsed() < (Poco::Timestamp::TimeDiff)(duration * 1000000))
         {
             stamp.update();
-            if (merryGoRound && (curDrawTime * 2 % fps == 0))
+            // Hint : 断言只覆盖 sample 自身的代码, MMP-Core 内部 (Draw/Copy2DTexturesToMemory) 的分配只统计不断言
+            bool steady = allocWarmUp >= 0 && curDrawTime >= (uint64_t)allocWarmUp;
+            paramStage.Begin();
+            {
+                AllocAssertScope noAlloc(steady);
+                if (merryGoRound && (curDrawTime * 2 % fps == 0))
+                {
+                    for (size_t curItem=0; curItem<params.size(); curItem++)
+                    {
+                        rotatedParams[curItem] = params[(curItem + itemParamOffset) % (count * count)];
+                    }
+                    table->SetParams(0, rotatedParams.data(), rotatedParams.size());
+                    itemParamOffset++;
+                }
+            }
+            paramStage.End();
+            drawStage.Begin();
+            table->Draw(framebuffer);
+            _renderThread->Wake();
+            drawStage.End();
+            // Hint : 未读回的帧没有新内容, 同样不显示; 上一帧还未被取走且允许丢帧时, 不再读回本帧
+            bool present = governor->ShouldReadback(curDrawTime);
+            if (present && !presentThread->IsIdle() && governor->ShouldDropBusyDisplay())
+            {
+                governor->RecordDroppedDisplay();
+                present = false;
+            }
+            AbstractPicture::ptr fb = presentThread->GetBackBuffer();
+            if (present)
             {
-                curItem = 0;
-                for (size_t col=0; col<count; col++)
+                readbackStage.Begin();
+                // Hint : 直写模式下获取或包装显示缓冲失败时放弃本帧, 不读回到不会显示的信箱画面
+                AbstractPicture::ptr target = fb;
+                if (direct)
                 {
-                    for (size_t row=0; row<count; row++)
+                    DisplayBuffer buffer;
+                    bool acquired = display->AcquireBuffer(buffer);
+                    target = acquired ? displayBuffers.Wrap(buffer) : nullptr;
+                    if (acquired && !target)
                     {
-                        items[curItem]->SetParam(params[(curItem + itemParamOffset) % (count * count)]);
-                        curItem++;
+                        display->AbortBuffer();
                     }
                 }
-                itemParamOffset++;
+                if (target)
+                {
+                    RenderThread::SyncScope sync(*_renderThread);
+                    Gpu::Copy2DTexturesToMemory(GLDrawContex::Instance(), framebuffers, target);
+                }
+                readbackStage.End();
+                if (direct && target)
+                {
+                    display->Present();
+                }
             }
-            layer->Draw(framebuffer);
-            if (lastDraw)
+            if (curDrawTime == 0)
             {
-                lastDraw->Wait();
+                timeline.Record("first frame", stamp);
+                timeline.Dump();
             }
-            Gpu::Copy2DTexturesToMemory(GLDrawContex::Instance(), std::vector<Texture::ptr>({framebuffer}), fb);
-            if (stamp.elapsed()/1000 > 1000 / fps)
+            totalCostUs += stamp.elapsed();
+            // Hint : 直写模式下不访问信箱画面, 不统计跨节点访问
+            ThreadPlacement::Instance().Sample(PipelineStage::MAIN, direct ? nullptr : fb->GetData(), stamp.elapsed());
+            maxCostUs = std::max(maxCostUs, (uint64_t)stamp.elapsed());
+            governor->Update(stamp.elapsed());
+            if (governor->GetResolutionShift() != resolutionShift)
             {
-                MMP_LOG_WARN << "overload, cost time is: " << stamp.elapsed()/1000 << " ms";
+                applyResolutionShift(governor->GetResolutionShift());
             }
-            lastDraw = std::make_shared<Promise<void>>([display, fb, info]()
+            if (present && !direct)
             {
-                if (display)
+                submitStage.Begin();
                 {
-                    display->UpdateWindow((const uint32_t*)(fb->GetData()), info);
+                    AllocAssertScope noAlloc(steady);
+                    presentThread->Publish();
                 }
-            });
-            ThreadPool::ThreadPoolSingleton()->Commit(lastDraw);
+                submitStage.End();
+            }
             curDrawTime++;
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000 / fps - stamp.elapsed()/1000));
+            governor->WaitNextFrame();
         }
-        layer.reset();
-        if (lastDraw)
+        if (curDrawTime)
+        {
+            MMP_LOG_INFO << "Frame cost (" << count << "x" << count << ") avg : " << totalCostUs / curDrawTime << " us, max : " << maxCostUs << " us";
+            MMP_LOG_INFO << "Texture bytes sampled per frame (estimate) : " << sampledBytesPerFrame / 1024 << " KiB";
+            ReportPerfMetric("compositor_" + std::to_string(count) + "x" + std::to_string(count) + "_frame_us", (double)totalCostUs / curDrawTime);
+            governor->Report("compositor_" + std::to_string(count) + "x" + std::to_string(count));
+        }
+        for (AllocStage* stage : {&paramStage, &drawStage, &readbackStage, &submitStage})
         {
-            lastDraw->Wait();
+            stage->Report();
         }
+        table.reset();
+        layer.reset();
     };
 
     equalSplitScreen(splitNum, fps, duration);
+    presentThread->Stop();
+    ThreadPlacement::Instance().Report();
 
     /******************************* PluginTransitionTest(END) ********************************/
     if (display)
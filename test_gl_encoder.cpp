@@ -0,0 +1,606 @@
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <algorithm>
+
+#include <Poco/Process.h>
+#include <Poco/Stopwatch.h>
+#include <Poco/Util/Application.h>
+#include <Poco/Util/HelpFormatter.h>
+
+#include "Common/Promise.h"
+#include "Common/AbstractLogger.h"
+#include "Common/LogMessage.h"
+#include "Common/ThreadPool.h"
+#include "GPU/GL/GLCommon.h"
+#include "GPU/GL/GLDrawContex.h"
+#include "GPU/Windows/WindowFactory.h"
+#include "GPU/Windows/AbstractWindows.h"
+#include "GPU/PG/AbstractSceneItem.h"
+#include "GPU/PG/AbstractSceneLayer.h"
+#include "GPU/PG/Utility/CommonUtility.h"
+#include "Codec/CodecFactory.h"
+#include "Codec/CodecConfig.h"
+
+#include "SampleUtils.h"
+#include "RenderThread.h"
+#include "BoundedQueue.h"
+#include "NV12Converter.h"
+#include "SceneItemTable.h"
+#include "WorkStealingPool.h"
+
+
+using namespace Mmp;
+using namespace Poco::Util;
+
+
+/**
+ * @sa Core/Extension/poco/Util/samples/SampleApp/src/SampleApp.cpp
+ */
+class App : public Application
+{
+public:
+    App();
+public:
+    void defineOptions(OptionSet& options) override;
+protected:
+    void Initialize();
+    void Uninitialize();
+    void defineProperty(const std::string& def);
+    int main(const ArgVec& args);
+private:
+    void HandleHelp(const std::string& name, const std::string& value);
+    void HandleBackend(const std::string& name, const std::string& value);
+    void HandleSplitNum(const std::string& name, const std::string& value);
+    void HandleFrames(const std::string& name, const std::string& value);
+    void HandleCodecName(const std::string& name, const std::string& value);
+    void HandleOutput(const std::string& name, const std::string& value);
+    void HandleShards(const std::string& name, const std::string& value);
+    void HandleBitrate(const std::string& name, const std::string& value);
+    void HandleShardReport(const std::string& name, const std::string& value);
+    void displayHelp();
+    int RunShards();
+public:
+    GPUBackend   backend;
+    size_t       splitNum;
+    uint64_t     frames;
+    std::string  encoderClassName;
+    std::string  outputFile;
+    uint32_t     shards;
+    uint32_t     bitrateKbps;
+    std::string  shardReportFile;
+private: /* gpu */
+    RenderThread::ptr _renderThread;
+};
+
+App::App()
+{
+    backend = GPUBackend::OPENGL;
+    splitNum = 4;
+    frames = 600;
+    encoderClassName = "OpenH264Encoder";
+    outputFile = "test_gl_encoder.h264";
+    shards = 1;
+    bitrateKbps = 8000;
+}
+
+void App::displayHelp()
+{
+    AbstractLogger::LoggerSingleton()->Enable(AbstractLogger::Direction::CONSLOE);
+    std::stringstream ss;
+    HelpFormatter helpFormatter(options());
+    helpFormatter.setWidth(1024);
+    helpFormatter.setCommand(commandName());
+    helpFormatter.setUsage("OPTIONS");
+    helpFormatter.setHeader("Simple program to test nxn Compositor -> Encoder pipeline using MMP-Core.");
+    helpFormatter.format(ss);
+    ss << std::endl;
+    ss << "Available Encoder Info" << std::endl;
+    std::vector<Codec::CodecDescription> descriptions = Codec::EncoderFactory::DefaultFactory().GetEncoderDescriptions();
+    for (auto& description : descriptions)
+    {
+        ss << "-- CodecType(" << description.codecType << ") CodecProcessType(" << description.processType
+           << ") CodecVendorType("<< description.vendorType << ") "
+           << "name(" << description.name << ") description(" << description.description << ")" << std::endl;
+    }
+    MMP_LOG_INFO << ss.str();
+    exit(0);
+}
+
+void App::HandleHelp(const std::string& name, const std::string& value)
+{
+    displayHelp();
+}
+
+void App::HandleBackend(const std::string& name, const std::string& value)
+{
+    backend = GetGPUBackend(value);
+}
+
+void App::HandleSplitNum(const std::string& name, const std::string& value)
+{
+    splitNum = std::stoi(value);
+    splitNum = std::min(splitNum, (size_t)16);
+    splitNum = std::max(splitNum, (size_t)2);
+}
+
+void App::HandleFrames(const std::string& name, const std::string& value)
+{
+    frames = std::stoi(value);
+    frames = std::max(frames, (uint64_t)1);
+}
+
+void App::HandleCodecName(const std::string& name, const std::string& value)
+{
+    encoderClassName = value;
+}
+
+void App::HandleOutput(const std::string& name, const std::string& value)
+{
+    outputFile = value;
+}
+
+void App::HandleShards(const std::string& name, const std::string& value)
+{
+    shards = std::stoi(value);
+    shards = std::min(shards, (uint32_t)64);
+    shards = std::max(shards, (uint32_t)1);
+}
+
+void App::HandleBitrate(const std::string& name, const std::string& value)
+{
+    bitrateKbps = std::stoi(value);
+    bitrateKbps = std::max(bitrateKbps, (uint32_t)100);
+}
+
+void App::HandleShardReport(const std::string& name, const std::string& value)
+{
+    shardReportFile = value;
+}
+
+void App::Initialize()
+{
+    ThreadPool::ThreadPoolSingleton()->Init();
+    WorkStealingPool::Instance().Init();
+    Codec::CodecConfig::Instance()->Init();
+    _renderThread = std::make_shared<RenderThread>(backend);
+    _renderThread->Start();
+}
+
+void App::Uninitialize()
+{
+    Application::uninitialize();
+    _renderThread->Stop();
+    Codec::CodecConfig::Instance()->Uninit();
+    WorkStealingPool::Instance().Uninit();
+    ThreadPool::ThreadPoolSingleton()->Uninit();
+}
+
+void App::defineOptions(OptionSet& options)
+{
+    Application::defineOptions(options);
+
+    std::string backendDescription = "gpu process uint, available value is: ";
+    {
+        std::vector<GPUBackend> backends = GLDrawContex::GetAvailableBackendType();
+        for (auto& backend : backends)
+        {
+            backendDescription += GPUBackendToStr(backend) + " ";
+        }
+    }
+    options.addOption(Option("help", "h", "")
+        .required(false)
+        .repeatable(false)
+        .callback(OptionCallback<App>(this, &App::HandleHelp))
+    );
+    options.addOption(Option("backend", "b", backendDescription)
+        .required(false)
+        .repeatable(false)
+        .argument("[type]")
+        .callback(OptionCallback<App>(this, &App::HandleBackend))
+    );
+    options.addOption(Option("split_num", "sn", "default(4), 2~16, 2*2, 3*3, n*n")
+        .required(false)
+        .repeatable(false)
+        .argument("[num]")
+        .callback(OptionCallback<App>(this, &App::HandleSplitNum))
+    );
+    options.addOption(Option("frames", "f", "default(600), frame count to encode")
+        .required(false)
+        .repeatable(false)
+        .argument("[num]")
+        .callback(OptionCallback<App>(this, &App::HandleFrames))
+    );
+    options.addOption(Option("codec_name", "codec", "default(OpenH264Encoder), encoder class name (see help name field)")
+        .required(false)
+        .repeatable(false)
+        .argument("[name]")
+        .callback(OptionCallback<App>(this, &App::HandleCodecName))
+    );
+    options.addOption(Option("output", "o", "default(test_gl_encoder.h264), annex-b output file")
+        .required(false)
+        .repeatable(false)
+        .argument("[filepath]")
+        .callback(OptionCallback<App>(this, &App::HandleOutput))
+    );
+    options.addOption(Option("shards", "s", "default(1), 1~64, independent outputs rendered by separate processes (one draw context each)")
+        .required(false)
+        .repeatable(false)
+        .argument("[num]")
+        .callback(OptionCallback<App>(this, &App::HandleShards))
+    );
+    options.addOption(Option("bitrate", "br", "default(8000), target bitrate in kbps")
+        .required(false)
+        .repeatable(false)
+        .argument("[kbps]")
+        .callback(OptionCallback<App>(this, &App::HandleBitrate))
+    );
+    options.addOption(Option("shard_report", "sr", "internal, set by --shards, file to write encoded frames and sustained fps of this shard")
+        .required(false)
+        .repeatable(false)
+        .argument("[filepath]")
+        .callback(OptionCallback<App>(this, &App::HandleShardReport))
+    );
+}
+
+void App::defineProperty(const std::string& def)
+{
+    std::string name;
+    std::string value;
+    std::string::size_type pos = def.find('=');
+    if (pos != std::string::npos)
+    {
+        name.assign(def, 0, pos);
+        value.assign(def, pos + 1, def.length() - pos);
+    }
+    else name = def;
+    config().setString(name, value);
+}
+
+/**
+ * @note GLDrawContex 在进程内为单例, 多个 draw context 通过多个进程实现,
+ *       每个进程拥有独立的渲染线程, 各自合成并编码一路输出
+ * @note 每个子进程将编码帧数及自身的持续帧率 (不含进程启动与 GL 初始化) 写入 <output>.<i>.report,
+ *       总帧率为各路持续帧率之和; 子进程以非零值退出或报告缺失时计为失败
+ */
+int App::RunShards()
+{
+#ifdef _WIN32
+    const std::string optionPrefix = "/";
+#else
+    const std::string optionPrefix = "--";
+#endif
+    std::string command = config().getString("application.path");
+    std::vector<Poco::ProcessHandle> handles;
+    std::vector<std::string> reportFiles;
+    Poco::Stopwatch sw;
+    sw.start();
+    for (uint32_t i=0; i<shards; i++)
+    {
+        std::string shardOutput = outputFile + "." + std::to_string(i);
+        reportFiles.push_back(shardOutput + ".report");
+        std::remove(reportFiles.back().c_str());
+        Poco::Process::Args shardArgs;
+        shardArgs.push_back(optionPrefix + "backend=" + GPUBackendToStr(backend));
+        shardArgs.push_back(optionPrefix + "split_num=" + std::to_string(splitNum));
+        shardArgs.push_back(optionPrefix + "frames=" + std::to_string(frames));
+        shardArgs.push_back(optionPrefix + "codec_name=" + encoderClassName);
+        shardArgs.push_back(optionPrefix + "bitrate=" + std::to_string(bitrateKbps));
+        shardArgs.push_back(optionPrefix + "output=" + shardOutput);
+        shardArgs.push_back(optionPrefix + "shard_report=" + reportFiles.back());
+        handles.push_back(Poco::Process::launch(command, shardArgs));
+    }
+    std::vector<int> exitCodes;
+    for (auto& handle : handles)
+    {
+        exitCodes.push_back(handle.wait());
+    }
+    sw.stop();
+    uint32_t failed = 0;
+    uint64_t totalFrames = 0;
+    double   totalFps = 0;
+    MMP_LOG_INFO << "Shard statistics";
+    for (uint32_t i=0; i<shards; i++)
+    {
+        uint64_t shardFrames = 0;
+        double   shardFps = 0;
+        std::ifstream ifs(reportFiles[i]);
+        bool reported = ifs.is_open() && (ifs >> shardFrames >> shardFps);
+        if (exitCodes[i] != 0 || !reported)
+        {
+            MMP_LOG_ERROR << "-- shard " << i << " fail, exit code : " << exitCodes[i] << (reported ? "" : ", no report");
+            failed++;
+            continue;
+        }
+        MMP_LOG_INFO << "-- shard " << i << " : frames : " << shardFrames << ", sustained fps : " << shardFps;
+        totalFrames += shardFrames;
+        totalFps += shardFps;
+    }
+    MMP_LOG_INFO << "-- shards : " << shards << ", failed : " << failed;
+    MMP_LOG_INFO << "-- total frames : " << totalFrames;
+    MMP_LOG_INFO << "-- total composited fps : " << totalFps;
+    MMP_LOG_INFO << "-- wall clock fps (with process spawn and GL init) : " << (sw.elapsed() > 0 ? (double)totalFrames * 1000000 / sw.elapsed() : 0);
+    ReportPerfMetric("encoder_shards_fps", totalFps);
+    return failed == 0 ? 0 : 255;
+}
+
+/**
+ * @brief 编码器结束标记 (空画面), 送入后编码器输出内部缓存的全部码流, 与解码器的 CreateEndOfStreamPack 对应
+ */
+static AbstractPicture::ptr CreateEndOfStreamPicture(const PixelsInfo& info)
+{
+    PixelsInfo empty = info;
+    empty.width = 0;
+    empty.height = 0;
+    return std::make_shared<NormalPicture>(empty);
+}
+
+/********************************************************* TEST(BEGIN) *****************************************************/
+
+int App::main(const ArgVec& args)
+{
+    AbstractLogger::LoggerSingleton()->Enable(AbstractLogger::Direction::CONSLOE);
+    MMP_LOG_INFO << "test_gl_encoder config";
+    MMP_LOG_INFO << "-- backend : " << backend;
+    MMP_LOG_INFO << "-- window : " << WindowFactory::DefaultFactory().GetGuessClassName(backend);
+    MMP_LOG_INFO << "-- split_num : " << splitNum;
+    MMP_LOG_INFO << "-- frames : " << frames;
+    MMP_LOG_INFO << "-- codec name : " << encoderClassName;
+    MMP_LOG_INFO << "-- output : " << outputFile;
+    MMP_LOG_INFO << "-- shards : " << shards;
+    MMP_LOG_INFO << "-- bitrate : " << bitrateKbps << " kbps";
+    if (shards > 1)
+    {
+        return RunShards();
+    }
+    Initialize();
+
+    Codec::AbstractEncoder::ptr encoder = Codec::EncoderFactory::DefaultFactory().CreateEncoder(encoderClassName);
+    if (!encoder)
+    {
+        MMP_LOG_ERROR << "Unsupport encoder, name is: " << encoderClassName << ", see --help for available encoders";
+        Uninitialize();
+        return 255;
+    }
+    std::ofstream ofs(outputFile, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open())
+    {
+        MMP_LOG_ERROR << "Open output file fail, path is: " << outputFile;
+        Uninitialize();
+        return 255;
+    }
+    PixelsInfo info = {1920, 1080, 8, PixelFormat::RGBA8888};
+    {
+        Codec::EncoderParameter parameter;
+        parameter.width = info.width;
+        parameter.height = info.height;
+        parameter.format = PixelFormat::NV12;
+        parameter.frameRate = 60;
+        parameter.bitrate = (uint64_t)bitrateKbps * 1000;
+        encoder->SetParameter(parameter);
+    }
+    if (!encoder->Init() || !encoder->Start())
+    {
+        MMP_LOG_ERROR << "Init encoder fail, name is: " << encoderClassName;
+        Uninitialize();
+        return 255;
+    }
+
+    AbstractPicture::ptr sceneA = GetFrame1920x1080A();
+    AbstractPicture::ptr sceneB = GetFrame1920x1080B();
+    /******************************* CompositorEncoderTest(BEGIN) ********************************/
+    //
+    // Draw (frame N) -> Readback (frame N-1) -> Encode (frame N-2) -> Annex-B File
+    //
+    constexpr size_t kFramebufferNum = 3;
+    constexpr size_t kPictureNum = 3; // 读回中, 读回队列, 编码中各一张
+    constexpr uint32_t kFlushIdleTimeoutMs = 2000;
+    Texture::ptr imageA;
+    Texture::ptr imageB;
+    Texture::ptr canvas;
+    std::vector<Texture::ptr> framebuffers;
+    {
+        imageA = Gpu::Create2DTextures(GLDrawContex::Instance(), sceneA->info)[0];
+        imageB = Gpu::Create2DTextures(GLDrawContex::Instance(), sceneB->info)[0];
+        canvas = Gpu::Create2DTextures(GLDrawContex::Instance(), info, "Canvas", GlTextureFlags::TEXTURE_USE_FOR_RENDER)[0];
+        for (size_t i=0; i<kFramebufferNum; i++)
+        {
+            framebuffers.push_back(Gpu::Create2DTextures(GLDrawContex::Instance(), info, "Framebuffer", GlTextureFlags::TEXTURE_USE_FOR_RENDER)[0]);
+        }
+        Gpu::Update2DTextures(GLDrawContex::Instance(), std::vector<Texture::ptr>({imageA}), sceneA);
+        Gpu::Update2DTextures(GLDrawContex::Instance(), std::vector<Texture::ptr>({imageB}), sceneB);
+    }
+    Gpu::AbstractSceneLayer::ptr layer = Gpu::AbstractSceneLayer::Create();
+    SceneItemTable::ptr table = std::make_shared<SceneItemTable>(layer);
+    std::vector<Gpu::SceneItemParam> params;
+    std::vector<Gpu::SceneItemParam> rotatedParams;
+    {
+        for (size_t col=0; col<splitNum; col++)
+        {
+            for (size_t row=0; row<splitNum; row++)
+            {
+                Gpu::SceneItemParam param = {};
+                param.location = NormalizedPoint(1.0f/splitNum * row, 1.0f/splitNum * col);
+                param.area = NormalizedRect(1.0f/splitNum, 1.0f/splitNum);
+                params.push_back(param);
+                Gpu::AbstractSceneItem::ptr item = Gpu::AbstractSceneItem::Create();
+                item->UpdateImage((col + row) % 2 == 0 ? imageA : imageB);
+                table->Add(item, param);
+            }
+        }
+        rotatedParams.resize(params.size());
+        Gpu::SceneLayerParam param = {};
+        param.strategy = Gpu::SceneRenderStrategy::Keep;
+        layer->SetParam(param);
+        layer->UpdateCanvas(canvas);
+    }
+
+    class FrameContext
+    {
+    public:
+        uint64_t              index;
+        size_t                slot;
+        AbstractPicture::ptr  picture;
+        Poco::Timestamp       drawBegin;
+    };
+    BoundedQueue<size_t>       freeSlots(kFramebufferNum);
+    BoundedQueue<FrameContext> drawnQueue(1);
+    BoundedQueue<FrameContext> readbackQueue(1);
+    for (size_t i=0; i<kFramebufferNum; i++)
+    {
+        freeSlots.Push(i);
+    }
+    NV12Converter::ptr converter = std::make_shared<NV12Converter>(info);
+    // Hint : NV12 画面循环复用, 不再每帧新建 (1080p 约 3 MB/帧)
+    BoundedQueue<AbstractPicture::ptr> freePictures(kPictureNum);
+    for (size_t i=0; i<kPictureNum; i++)
+    {
+        freePictures.Push(std::make_shared<NormalPicture>(converter->GetNV12Info()));
+    }
+    std::atomic<uint64_t> drawCostUs(0), readbackCostUs(0), encodeCostUs(0), endToEndUs(0);
+    std::atomic<uint64_t> pushedFrames(0), encodedFrames(0), encodedBytes(0), extraPictures(0);
+
+    // Hint : 读回与编码循环在整个编码期间不返回, 使用常驻线程槽; 读回内部的分段转换仍在工作线程上并行
+    TaskGroup::ptr readbackTask = WorkStealingPool::Instance().CommitLongRunning("readback", [&]()
+    {
+        FrameContext context;
+        while (drawnQueue.Pop(context))
+        {
+            freePictures.Pop(context.picture);
+            Poco::Timestamp stamp;
+            {
+                RenderThread::SyncScope sync(*_renderThread);
+                converter->ReadbackAndConvert(framebuffers[context.slot], context.picture);
+            }
+            freeSlots.Push(context.slot);
+            readbackCostUs += stamp.elapsed();
+            readbackQueue.Push(context);
+        }
+        readbackQueue.Close();
+    });
+    TaskGroup::ptr encodeTask = WorkStealingPool::Instance().CommitLongRunning("encode", [&]()
+    {
+        auto drain = [&]() -> bool
+        {
+            bool popped = false;
+            AbstractPack::ptr pack;
+            while (encoder->Pop(pack))
+            {
+                ofs.write((const char*)pack->GetData(), pack->GetSize());
+                encodedBytes += pack->GetSize();
+                encodedFrames++;
+                popped = true;
+            }
+            return popped;
+        };
+        FrameContext context;
+        while (readbackQueue.Pop(context))
+        {
+            Poco::Timestamp stamp;
+            if (encoder->Push(context.picture))
+            {
+                pushedFrames++;
+            }
+            else
+            {
+                MMP_LOG_WARN << "Encoder push fail, frame index is: " << context.index;
+            }
+            // Hint : 编码器的 Push/Pop 为异步接口, 可能仍持有画面; 只回收没有其他持有者的画面, 否则补一张新的,
+            //        避免下一次读回覆盖编码器尚未处理的画面
+            if (context.picture.use_count() == 1)
+            {
+                freePictures.Push(context.picture);
+            }
+            else
+            {
+                freePictures.Push(std::make_shared<NormalPicture>(converter->GetNV12Info()));
+                extraPictures++;
+            }
+            context.picture.reset();
+            drain();
+            encodeCostUs += stamp.elapsed();
+            endToEndUs += context.drawBegin.elapsed();
+        }
+        // Hint : 送入结束标记取出编码器缓存的尾部码流, 取满 (每帧一个 pack) 或超时后结束
+        encoder->Push(CreateEndOfStreamPicture(converter->GetNV12Info()));
+        Poco::Timestamp lastOutput;
+        while (encodedFrames < pushedFrames && lastOutput.elapsed() < (int64_t)kFlushIdleTimeoutMs * 1000)
+        {
+            if (drain())
+            {
+                lastOutput.update();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+        }
+    });
+
+    Poco::Stopwatch sw;
+    sw.start();
+    for (uint64_t i=0; i<frames; i++)
+    {
+        FrameContext context;
+        freeSlots.Pop(context.slot);
+        context.index = i;
+        context.drawBegin.update();
+        for (size_t curItem=0; curItem<params.size(); curItem++)
+        {
+            rotatedParams[curItem] = params[(curItem + i) % params.size()];
+        }
+        table->SetParams(0, rotatedParams.data(), rotatedParams.size());
+        table->Draw(framebuffers[context.slot]);
+        _renderThread->Wake();
+        drawCostUs += context.drawBegin.elapsed();
+        drawnQueue.Push(context);
+    }
+    drawnQueue.Close();
+    readbackTask->Wait();
+    encodeTask->Wait();
+    sw.stop();
+
+    double sustainedFps = sw.elapsed() > 0 ? (double)encodedFrames * 1000000 / sw.elapsed() : 0;
+    if (!shardReportFile.empty())
+    {
+        std::ofstream report(shardReportFile, std::ios::out | std::ios::trunc);
+        report << encodedFrames << " " << sustainedFps << std::endl;
+    }
+    if (encodedFrames)
+    {
+        MMP_LOG_INFO << "Compositor -> Encoder statistics (" << splitNum << "x" << splitNum << ")";
+        MMP_LOG_INFO << "-- frames : " << encodedFrames << ", bytes : " << encodedBytes;
+        MMP_LOG_INFO << "-- pictures still held by encoder : " << extraPictures;
+        MMP_LOG_INFO << "-- sustained fps : " << sustainedFps;
+        MMP_LOG_INFO << "-- draw avg : " << drawCostUs / frames << " us";
+        MMP_LOG_INFO << "-- readback avg : " << readbackCostUs / encodedFrames << " us";
+        MMP_LOG_INFO << "-- encode avg : " << encodeCostUs / encodedFrames << " us";
+        MMP_LOG_INFO << "-- end to end avg : " << endToEndUs / encodedFrames << " us";
+        WorkStealingPool::Instance().Report();
+    }
+    table.reset();
+    layer.reset();
+    /******************************* CompositorEncoderTest(END) ********************************/
+    encoder->Stop();
+    encoder->Uninit();
+    ofs.close();
+
+    Uninitialize();
+    if (pushedFrames != frames || encodedFrames < frames || encodedBytes == 0)
+    {
+        MMP_LOG_ERROR << "Encode incomplete, pushed frames : " << pushedFrames << "/" << frames << ", encoded frames : " << encodedFrames << "/" << frames
+                      << ", bytes : " << encodedBytes;
+        return 255;
+    }
+    return 0;
+}
+
+/********************************************************* TEST(END) *****************************************************/
+
+POCO_APP_MAIN(App)
@@ -5,6 +5,7 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <algorithm>
 
@@ -29,6 +30,13 @@
 
 #include "AbstractDisplay.h"
 #include "SampleUtils.h"
+#include "RenderThread.h"
+#include "StartupTimeline.h"
+#include "PresentThread.h"
+#include "AllocTracker.h"
+#include "ThreadPlacement.h"
+#include "LoadGovernor.h"
+#include "WorkStealingPool.h"
 
 
 using namespace Mmp;
@@ -54,17 +62,26 @@ private:
     void HandleBackend(const std::string& name, const std::string& value);
     void HandleTransition(const std::string& name, const std::string& value);
     void HandleDuration(const std::string& name, const std::string& value);
+    void HandleDisplay(const std::string& name, const std::string& value);
+    void HandleAllocAssert(const std::string& name, const std::string& value);
+    void HandlePlacement(const std::string& name, const std::string& value);
+    void HandleGovernor(const std::string& name, const std::string& value);
+    void HandleDirectPresent(const std::string& name, const std::string& value);
+    void HandleFitDisplay(const std::string& name, const std::string& value);
     void displayHelp();
 public:
     std::string transitionName;
     GPUBackend backend;
     uint64_t   duration;
     uint32_t   fps;
+    bool       show;
+    int64_t    allocWarmUp;
+    bool       governorEnable;
+    bool       directPresent;
+    bool       fitDisplay;
+    ScaleFilter scaleFilter;
 private: /* gpu */
-    std::atomic<bool> _gpuInited;
-    std::thread _renderThread;
-    AbstractWindows::ptr _window;
-    GLDrawContex::ptr    _draw;
+    RenderThread::ptr _renderThread;
 };
 
 App::App()
@@ -73,6 +90,12 @@ App::App()
     fps = 60;
     duration = 1;
     transitionName = "DirectionalTransition";
+    show = true;
+    allocWarmUp = -1;
+    governorEnable = true;
+    directPresent = false;
+    fitDisplay = true;
+    scaleFilter = ScaleFilter::AREA;
 }
 
 void App::displayHelp()
@@ -126,58 +149,78 @@ void App::HandleDuration(const std::string& name, const std::string& value)
     duration = std::max(duration, (uint64_t)1);
 }
 
+void App::HandleDisplay(const std::string& name, const std::string& value)
+{
+    if (value == "false")
+    {
+        show = false;
+    }
+}
+
+void App::HandleAllocAssert(const std::string& name, const std::string& value)
+{
+    allocWarmUp = value.empty() ? 60 : std::stoll(value);
+    allocWarmUp = std::max(allocWarmUp, (int64_t)0);
+}
+
+void App::HandleGovernor(const std::string& name, const std::string& value)
+{
+    if (value == "false")
+    {
+        governorEnable = false;
+    }
+}
+
+void App::HandleDirectPresent(const std::string& name, const std::string& value)
+{
+    if (value == "true")
+    {
+        directPresent = true;
+    }
+}
+
+void App::HandleFitDisplay(const std::string& name, const std::string& value)
+{
+    if (value == "none" || value == "false")
+    {
+        fitDisplay = false;
+    }
+    else if (value == "bilinear")
+    {
+        scaleFilter = ScaleFilter::BILINEAR;
+    }
+}
+
+void App::HandlePlacement(const std::string& name, const std::string& value)
+{
+    // Hint : <stage>=<spec> 写入 placement.<stage>, 与配置文件中的 key 一致
+    std::string::size_type pos = value.find('=');
+    if (pos == std::string::npos)
+    {
+        MMP_LOG_WARN << "Invalid placement : " << value << ", expect <stage>=<spec>";
+        return;
+    }
+    config().setString("placement." + value.substr(0, pos), value.substr(pos + 1));
+}
+
 void App::Initialize()
 {
+    ThreadPlacement::Instance().Load(config());
     ThreadPool::ThreadPoolSingleton()->Init();
+    ThreadPlacement::Instance().ApplyThreadPool(std::thread::hardware_concurrency());
+    WorkStealingPool::Instance().Init();
     Codec::CodecConfig::Instance()->Init();
-    {
-        _renderThread = std::thread([this]() -> void
-        {
-            GLDrawContex::SetGPUBackendType(backend);
-            _window = WindowFactory::DefaultFactory().createWindow(WindowFactory::DefaultFactory().GetGuessClassName(backend));
-            _window->SetRenderMode(false);
-            _window->Open();
-            _window->BindRenderThread(true);
-            _draw = GLDrawContex::Instance();
-            _draw->SetWindows(_window);
-            _gpuInited = true;
-            _draw->ThreadStart();
-            while (true)
-            {
-                GpuTaskStatus status;
-                status = _draw->ThreadFrame();
-                if (status == GpuTaskStatus::EXIT)
-                {
-                    break;
-                }
-                else if (status == GpuTaskStatus::PRESENT)
-                {
-                    _window->Swap();
-                }
-                else
-                {
-                    continue;
-                }
-            };
-            _draw->ThreadEnd();
-            _window->BindRenderThread(false);
-            _window->Close();
-        });
-        while (!_gpuInited)
-        {
-            std::this_thread::sleep_for(std::chrono::microseconds(200));
-        }
-    }
+    _renderThread = std::make_shared<RenderThread>(backend);
+    // Hint : 不等待 GPU 就绪, 与资源解码等步骤并行, 使用 GPU 前调用 WaitReady
+    _renderThread->Start(false);
 }
 
 void App::Uninitialize()
 {
     Application::uninitialize();
-    {
-        _draw->ThreadStop();
-        _renderThread.join();
-    }
+    _renderThread->Stop();
     Codec::CodecConfig::Instance()->Uninit();
+    WorkStealingPool::Instance().Uninit();
     ThreadPool::ThreadPoolSingleton()->Uninit();
 }
 
@@ -216,6 +259,42 @@ void App::defineOptions(OptionSet& options)
         .argument("[name]")
         .callback(OptionCallback<App>(this, &App::HandleTransition))
     );
+    options.addOption(Option("display", "display", "default(true), true or false, false for offscreen run")
+        .required(false)
+        .repeatable(false)
+        .argument("[show]")
+        .callback(OptionCallback<App>(this, &App::HandleDisplay))
+    );
+    options.addOption(Option("alloc_assert", "aa", "default(off), [warm up frames], abort on heap allocation after warm up, build with MMP_SAMPLE_ALLOC_TRACKER")
+        .required(false)
+        .repeatable(false)
+        .argument("[frames]", false)
+        .callback(OptionCallback<App>(this, &App::HandleAllocAssert))
+    );
+    options.addOption(Option("placement", "pl", "<stage>=<spec>, stage is render/pool/display/main/memory, spec is cpu:0-3,8 or node:1")
+        .required(false)
+        .repeatable(true)
+        .argument("[placement]")
+        .callback(OptionCallback<App>(this, &App::HandlePlacement))
+    );
+    options.addOption(Option("governor", "gov", "default(true), true or false, degrade step by step under overload (skip readback, drop display, reduce fps)")
+        .required(false)
+        .repeatable(false)
+        .argument("[enable]")
+        .callback(OptionCallback<App>(this, &App::HandleGovernor))
+    );
+    options.addOption(Option("direct_present", "dp", "default(false), true or false, read back straight into the locked display texture and present on the main loop thread")
+        .required(false)
+        .repeatable(false)
+        .argument("[enable]")
+        .callback(OptionCallback<App>(this, &App::HandleDirectPresent))
+    );
+    options.addOption(Option("fit_display", "fd", "default(area), area, bilinear or none, shrink the window to fit the screen and scale on CPU before upload")
+        .required(false)
+        .repeatable(false)
+        .argument("[filter]")
+        .callback(OptionCallback<App>(this, &App::HandleFitDisplay))
+    );
 }
 
 void App::defineProperty(const std::string& def)
@@ -242,35 +321,137 @@ int App::main(const ArgVec& args)
     MMP_LOG_INFO << "-- window : " << WindowFactory::DefaultFactory().GetGuessClassName(backend);
     MMP_LOG_INFO << "-- transition : " << transitionName;
     MMP_LOG_INFO << "-- duration : " << duration << " second";
-    Initialize();
-
-    AbstractPicture::ptr sceneA = GetFrame1920x1080A();
-    AbstractPicture::ptr sceneB = GetFrame1920x1080B();
-    AbstractDisplay::ptr display = AbstractDisplay::Create();
+    MMP_LOG_INFO << "-- display : " << (show ? "true" : "false");
+    MMP_LOG_INFO << "-- governor : " << (governorEnable ? "true" : "false");
+    MMP_LOG_INFO << "-- direct_present : " << (directPresent ? "true" : "false");
+    MMP_LOG_INFO << "-- fit_display : " << (fitDisplay ? (scaleFilter == ScaleFilter::AREA ? "area" : "bilinear") : "none");
+    if (allocWarmUp >= 0)
+    {
+        MMP_LOG_INFO << "-- alloc_assert : after " << allocWarmUp << " frames";
+        if (!AllocTracker::Enabled())
+        {
+            MMP_LOG_WARN << "Alloc tracker is not compiled in, rebuild with -DMMP_SAMPLE_ALLOC_TRACKER=ON";
+        }
+    }
+    StartupTimeline timeline;
+    {
+        Poco::Timestamp begin;
+        Initialize();
+        timeline.Record("initialize", begin);
+    }
+    AbstractPicture::ptr sceneA;
+    AbstractPicture::ptr sceneB;
+    Promise<void>::ptr decodeA = std::make_shared<Promise<void>>([&]()
+    {
+        Poco::Timestamp begin;
+        sceneA = GetFrame1920x1080A();
+        timeline.Record("decode A", begin);
+    });
+    Promise<void>::ptr decodeB = std::make_shared<Promise<void>>([&]()
+    {
+        Poco::Timestamp begin;
+        sceneB = GetFrame1920x1080B();
+        timeline.Record("decode B", begin);
+    });
+    ThreadPool::ThreadPoolSingleton()->Commit(decodeA);
+    ThreadPool::ThreadPoolSingleton()->Commit(decodeB);
+    AbstractDisplay::ptr display;
     PixelsInfo info = {1920, 1080, 8, PixelFormat::RGBA8888};
-    AbstractPicture::ptr fb = std::make_shared<NormalPicture>(info);
-    if (display)
     {
-        display->Init();
-        display->Open(info);
+        Poco::Timestamp begin;
+        display = show ? AbstractDisplay::Create() : nullptr;
+        if (display)
+        {
+            display->Init();
+            display->SetFitToDisplay(fitDisplay, scaleFilter);
+            display->Open(info);
+        }
+        timeline.Record("display", begin);
     }
     /******************************* PluginTransitionTest(BEGIN) ********************************/
     Texture::ptr imageA;
     Texture::ptr imageB;
     Texture::ptr framebuffer;
     {
+        Poco::Timestamp begin;
+        _renderThread->WaitReady();
+        timeline.Record("wait gpu", begin);
+    }
+    Gpu::AbstractTransition::ptr transition;
+    Promise<void>::ptr createTransition = std::make_shared<Promise<void>>([&]()
+    {
+        Poco::Timestamp begin;
+        transition = Gpu::TransitionFactory::DefaultFactory().CreateTransition(transitionName);
+        timeline.Record("create transition", begin);
+    });
+    ThreadPool::ThreadPoolSingleton()->Commit(createTransition);
+    {
+        Poco::Timestamp begin;
+        framebuffer = Gpu::Create2DTextures(GLDrawContex::Instance(), info, "Framebuffer", GlTextureFlags::TEXTURE_USE_FOR_RENDER)[0];
+        timeline.Record("create framebuffer", begin);
+    }
+    {
+        decodeA->Wait();
+        Poco::Timestamp begin;
         imageA = Gpu::Create2DTextures(GLDrawContex::Instance(), sceneA->info)[0];
-        imageB = Gpu::Create2DTextures(GLDrawContex::Instance(), sceneB->info)[0];
-        framebuffer = Gpu::Create2DTextures(GLDrawContex::Instance(), sceneA->info, "Framebuffer", GlTextureFlags::TEXTURE_USE_FOR_RENDER)[0];
         Gpu::Update2DTextures(GLDrawContex::Instance(), std::vector<Texture::ptr>({imageA}), sceneA);
+        timeline.Record("upload A", begin);
+    }
+    {
+        decodeB->Wait();
+        Poco::Timestamp begin;
+        imageB = Gpu::Create2DTextures(GLDrawContex::Instance(), sceneB->info)[0];
         Gpu::Update2DTextures(GLDrawContex::Instance(), std::vector<Texture::ptr>({imageB}), sceneB);
+        timeline.Record("upload B", begin);
     }
+    createTransition->Wait();
     
-    Promise<void>::ptr lastDraw;
+    // Hint : 常驻显示线程, 读回直接写入信箱的 back 画面, 发布不阻塞, 显示耗时不影响渲染
+    // Hint : 直写模式下读回目标为加锁的显示纹理, 在本线程 Present, 不经过显示线程;
+    //        纹理内存不是紧密排列时 (跨距不等于宽度) 无法直接作为读回目标, 回退至信箱
+    if (directPresent && display)
+    {
+        DisplayBuffer buffer;
+        if (display->AcquireBuffer(buffer))
+        {
+            // Hint : 窗口被缩小时显示纹理小于读回画面, 同样回退
+            bool sameSize = buffer.info.width == info.width && buffer.info.height == info.height;
+            AbstractPicture::ptr probe = sameSize ? WrapDisplayBuffer(buffer) : nullptr;
+            memset(buffer.data[0], 0, (size_t)buffer.stride[0] * buffer.info.height);
+            display->Present();
+            if (!probe)
+            {
+                MMP_LOG_WARN << "Display buffer is not tightly packed or window is scaled, fallback to mailbox present";
+                directPresent = false;
+            }
+        }
+        else
+        {
+            MMP_LOG_WARN << "Display does not support AcquireBuffer, fallback to mailbox present";
+            directPresent = false;
+        }
+    }
+    bool direct = directPresent && display;
+    DisplayBufferCache displayBuffers;
+    PresentThread::ptr presentThread = std::make_shared<PresentThread>(direct ? nullptr : display, info);
+    presentThread->Start();
+    std::vector<Texture::ptr> framebuffers = {framebuffer};
+    AllocStage drawStage("transition");
+    AllocStage readbackStage("readback");
+    AllocStage submitStage("present submit");
+    for (AllocStage* stage : {&drawStage, &readbackStage, &submitStage})
+    {
+        stage->SetWarmUp(allocWarmUp > 0 ? (uint64_t)allocWarmUp : 0);
+    }
+    ThreadPlacement::Instance().Apply(PipelineStage::MAIN);
+    // Hint : 转场输出尺寸固定, 没有可降低的采样分辨率
+    LoadGovernor::ptr governor = std::make_shared<LoadGovernor>(fps);
+    governor->SetEnable(governorEnable);
+    governor->SetLevelEnabled(GovernorLevel::LOWER_RESOLUTION, false);
     Poco::Timestamp stamp;
     uint64_t curDrawTime = 0;
     uint64_t itemParamOffset = 0;
-    Gpu::AbstractTransition::ptr transition = Gpu::TransitionFactory::DefaultFactory().CreateTransition(transitionName);
+    uint64_t totalCostUs = 0;
     Gpu::AbstractTransitionParams::ptr params = std::make_shared<Gpu::AbstractTransitionParams>();
     if (!transition)
     {
@@ -278,34 +459,87 @@ int App::main(const ArgVec& args)
         displayHelp();
         return 0;
     }
-    for (uint32_t i=0; i< fps * duration; i++)
+    // Hint : 进度按实际经过的时间计算, 降帧率或丢帧时转场总时长不变
+    Poco::Timestamp runStamp;
+    while (runStamp.elapsed() < (Poco::Timestamp::TimeDiff)(duration * 1000000))
     {
         stamp.update();
-        params->progress = (float)i / (fps * duration);
+        // Hint : 断言只覆盖 sample 自身的代码, MMP-Core 内部 (Transition/Copy2DTexturesToMemory) 的分配只统计不断言
+        bool steady = allocWarmUp >= 0 && curDrawTime >= (uint64_t)allocWarmUp;
+        drawStage.Begin();
+        {
+            AllocAssertScope noAlloc(steady);
+            params->progress = (float)runStamp.elapsed() / (duration * 1000000);
+        }
         transition->Transition(imageA, imageB, framebuffer, params);
-        if (lastDraw)
+        _renderThread->Wake();
+        drawStage.End();
+        // Hint : 未读回的帧没有新内容, 同样不显示; 上一帧还未被取走且允许丢帧时, 不再读回本帧
+        bool present = governor->ShouldReadback(curDrawTime);
+        if (present && !presentThread->IsIdle() && governor->ShouldDropBusyDisplay())
         {
-            lastDraw->Wait();
+            governor->RecordDroppedDisplay();
+            present = false;
         }
-        Gpu::Copy2DTexturesToMemory(GLDrawContex::Instance(), std::vector<Texture::ptr>({framebuffer}), fb);
-        if (stamp.elapsed()/1000 > 1000 / fps)
+        AbstractPicture::ptr fb = presentThread->GetBackBuffer();
+        if (present)
         {
-            MMP_LOG_WARN << "overload, cost time is: " << stamp.elapsed()/1000 << " ms";
+            readbackStage.Begin();
+            // Hint : 直写模式下获取或包装显示缓冲失败时放弃本帧, 不读回到不会显示的信箱画面
+            AbstractPicture::ptr target = fb;
+            if (direct)
+            {
+                DisplayBuffer buffer;
+                bool acquired = display->AcquireBuffer(buffer);
+                target = acquired ? displayBuffers.Wrap(buffer) : nullptr;
+                if (acquired && !target)
+                {
+                    display->AbortBuffer();
+                }
+            }
+            if (target)
+            {
+                RenderThread::SyncScope sync(*_renderThread);
+                Gpu::Copy2DTexturesToMemory(GLDrawContex::Instance(), framebuffers, target);
+            }
+            readbackStage.End();
+            if (direct && target)
+            {
+                display->Present();
+            }
+        }
+        if (curDrawTime == 0)
+        {
+            timeline.Record("first frame", stamp);
+            timeline.Dump();
         }
-        lastDraw = std::make_shared<Promise<void>>([display, fb, info]()
+        totalCostUs += stamp.elapsed();
+        // Hint : 直写模式下不访问信箱画面, 不统计跨节点访问
+        ThreadPlacement::Instance().Sample(PipelineStage::MAIN, direct ? nullptr : fb->GetData(), stamp.elapsed());
+        governor->Update(stamp.elapsed());
+        if (present && !direct)
         {
-            if (display)
+            submitStage.Begin();
             {
-                display->UpdateWindow((const uint32_t*)(fb->GetData()), info);
+                AllocAssertScope noAlloc(steady);
+                presentThread->Publish();
             }
-        });
-        ThreadPool::ThreadPoolSingleton()->Commit(lastDraw);
+            submitStage.End();
+        }
         curDrawTime++;
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000 / fps - stamp.elapsed()/1000));
+        governor->WaitNextFrame();
+    }
+    presentThread->Stop();
+    ThreadPlacement::Instance().Report();
+    for (AllocStage* stage : {&drawStage, &readbackStage, &submitStage})
+    {
+        stage->Report();
     }
-    if (lastDraw)
+    if (curDrawTime)
     {
-        lastDraw->Wait();
+        MMP_LOG_INFO << "Frame cost avg : " << totalCostUs / curDrawTime << " us";
+        ReportPerfMetric("transition_" + transitionName + "_frame_us", (double)totalCostUs / curDrawTime);
+        governor->Report("transition_" + transitionName);
     }
     transition.reset();
     /******************************* PluginTransitionTest(END) ********************************/
@@ -0,0 +1,383 @@
+#include <map>
+#include <atomic>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+
+#include <Poco/AutoPtr.h>
+#include <Poco/Util/Application.h>
+#include <Poco/Util/HelpFormatter.h>
+#include <Poco/Util/MapConfiguration.h>
+
+#include "Common/AbstractLogger.h"
+#include "Common/LogMessage.h"
+
+#include "PipelineGraph.h"
+#include "WorkStealingPool.h"
+
+using namespace Mmp;
+using namespace Poco::Util;
+
+/**
+ * @sa Core/Extension/poco/Util/samples/SampleApp/src/SampleApp.cpp
+ */
+class App : public Application
+{
+public:
+    App();
+public:
+    void defineOptions(OptionSet& options) override;
+protected:
+    void defineProperty(const std::string& def);
+    int main(const ArgVec& args);
+private:
+    void HandleHelp(const std::string& name, const std::string& value);
+    void HandleTimeout(const std::string& name, const std::string& value);
+    void displayHelp();
+public:
+    uint32_t  timeoutMs;
+};
+
+App::App()
+{
+    timeoutMs = 10000;
+}
+
+void App::displayHelp()
+{
+    AbstractLogger::LoggerSingleton()->Enable(AbstractLogger::Direction::CONSLOE);
+    std::stringstream ss;
+    HelpFormatter helpFormatter(options());
+    helpFormatter.setWidth(1024);
+    helpFormatter.setCommand(commandName());
+    helpFormatter.setUsage("OPTIONS");
+    helpFormatter.setHeader("Simple program to check pipeline graph shutdown, fan-in and stop without any codec or display.");
+    helpFormatter.format(ss);
+    MMP_LOG_INFO << ss.str();
+    exit(0);
+}
+
+void App::HandleHelp(const std::string& name, const std::string& value)
+{
+    displayHelp();
+}
+
+void App::HandleTimeout(const std::string& name, const std::string& value)
+{
+    timeoutMs = std::stoi(value);
+    timeoutMs = std::max(timeoutMs, (uint32_t)100);
+}
+
+void App::defineOptions(OptionSet& options)
+{
+    Application::defineOptions(options);
+
+    options.addOption(Option("help", "h", "")
+        .required(false)
+        .repeatable(false)
+        .callback(OptionCallback<App>(this, &App::HandleHelp))
+    );
+    options.addOption(Option("timeout", "t", "default(10000), max time in ms for each case before it is treated as hung")
+        .required(false)
+        .repeatable(false)
+        .argument("[ms]")
+        .callback(OptionCallback<App>(this, &App::HandleTimeout))
+    );
+}
+
+void App::defineProperty(const std::string& def)
+{
+    std::string name;
+    std::string value;
+    std::string::size_type pos = def.find('=');
+    if (pos != std::string::npos)
+    {
+        name.assign(def, 0, pos);
+        value.assign(def, pos + 1, def.length() - pos);
+    }
+    else name = def;
+    config().setString(name, value);
+}
+
+/**
+ * @brief 测试节点之间传递的数据
+ */
+class TestPayload
+{
+public:
+    using ptr = std::shared_ptr<TestPayload>;
+public:
+    TestPayload(const std::string& source, uint64_t seq)
+    {
+        this->source = source;
+        this->seq = seq;
+    }
+public:
+    std::string  source;
+    uint64_t     seq;
+};
+
+/**
+ * @brief 依次输出 count 个 item 的源节点, count 为 0 表示不结束
+ */
+static PipelineNode::ptr CreateCounterSource(const std::string& name, uint64_t count)
+{
+    std::shared_ptr<uint64_t> seq = std::make_shared<uint64_t>(0);
+    return PipelineNode::Create([name, count, seq](PipelineItem& item, PipelineEmitter& emitter) -> bool
+    {
+        if (count != 0 && *seq >= count)
+        {
+            return false;
+        }
+        item.Set(std::make_shared<TestPayload>(name, (*seq)++));
+        return emitter.Emit(item);
+    });
+}
+
+/**
+ * @brief 在单独的线程上运行 graph, 超过 timeoutMs 仍未返回视为卡死, 直接退出进程
+ * @note  卡死的节点阻塞在常驻线程槽上, 无法安全析构 graph, 因此不尝试继续后续用例
+ */
+static void RunWithWatchdog(const std::string& caseName, PipelineGraph::ptr graph, uint32_t timeoutMs)
+{
+    std::packaged_task<void()> task([graph]()
+    {
+        graph->Run();
+    });
+    std::future<void> done = task.get_future();
+    std::thread runner(std::move(task));
+    if (done.wait_for(std::chrono::milliseconds(timeoutMs)) != std::future_status::ready)
+    {
+        MMP_LOG_ERROR << "-- " << caseName << " : FAIL, Run does not return in " << timeoutMs << " ms";
+        std::_Exit(255);
+    }
+    runner.join();
+}
+
+/**
+ * @brief 正常结束: 源结束后下游依次 Flush, Flush 中输出的 item 仍能到达 sink
+ */
+static bool TestShutdown(uint32_t timeoutMs)
+{
+    constexpr uint64_t kItems = 100;
+    std::vector<uint64_t> received;
+    uint32_t passFlushes = 0;
+    uint32_t sinkFlushes = 0;
+    PipelineGraph::ptr graph = std::make_shared<PipelineGraph>();
+    graph->RegisterType("src", [&]() -> PipelineNode::ptr
+    {
+        return CreateCounterSource("src", kItems);
+    });
+    graph->RegisterType("pass", [&]() -> PipelineNode::ptr
+    {
+        return PipelineNode::Create([](PipelineItem& item, PipelineEmitter& emitter) -> bool
+        {
+            emitter.Emit(item);
+            return true;
+        }, [&](PipelineEmitter& emitter)
+        {
+            passFlushes++;
+            PipelineItem item;
+            item.Set(std::make_shared<TestPayload>("pass", kItems));
+            emitter.Emit(item);
+        });
+    });
+    graph->RegisterType("sink", [&]() -> PipelineNode::ptr
+    {
+        return PipelineNode::Create([&](PipelineItem& item, PipelineEmitter& emitter) -> bool
+        {
+            TestPayload::ptr payload = item.Get<TestPayload>();
+            received.push_back(payload ? payload->seq : UINT64_MAX);
+            return true;
+        }, [&](PipelineEmitter& emitter)
+        {
+            sinkFlushes++;
+        });
+    });
+    Poco::AutoPtr<MapConfiguration> config = new MapConfiguration();
+    config->setString("pipeline.nodes", "src,pass,sink");
+    if (!graph->Build(*config))
+    {
+        return false;
+    }
+    RunWithWatchdog("shutdown", graph, timeoutMs);
+
+    bool ordered = received.size() == kItems + 1;
+    for (size_t i = 0; i < received.size() && ordered; i++)
+    {
+        ordered = received[i] == i;
+    }
+    MMP_LOG_INFO << "-- shutdown, received : " << received.size() << "/" << kItems + 1 << ", ordered : " << (ordered ? "yes" : "no")
+                 << ", flush (pass/sink) : " << passFlushes << "/" << sinkFlushes;
+    return ordered && passFlushes == 1 && sinkFlushes == 1;
+}
+
+/**
+ * @brief 多个上游: 所有上游结束后下游的输入队列才关闭, Flush 前已收到每个上游的全部 item
+ */
+static bool TestFanIn(uint32_t timeoutMs)
+{
+    constexpr uint64_t kItemsA = 50;
+    constexpr uint64_t kItemsB = 70;
+    std::map<std::string, uint64_t> received;
+    std::map<std::string, uint64_t> receivedOnFlush;
+    uint32_t flushes = 0;
+    bool ordered = true;
+    PipelineGraph::ptr graph = std::make_shared<PipelineGraph>();
+    graph->RegisterType("a", [&]() -> PipelineNode::ptr
+    {
+        return CreateCounterSource("a", kItemsA);
+    });
+    graph->RegisterType("b", [&]() -> PipelineNode::ptr
+    {
+        return CreateCounterSource("b", kItemsB);
+    });
+    graph->RegisterType("sink", [&]() -> PipelineNode::ptr
+    {
+        return PipelineNode::Create([&](PipelineItem& item, PipelineEmitter& emitter) -> bool
+        {
+            TestPayload::ptr payload = item.Get<TestPayload>();
+            if (!payload)
+            {
+                ordered = false;
+                return true;
+            }
+            // Hint : 同一个上游的 item 保持顺序, 不同上游之间的交错顺序不确定
+            ordered = ordered && payload->seq == received[payload->source];
+            received[payload->source]++;
+            return true;
+        }, [&](PipelineEmitter& emitter)
+        {
+            flushes++;
+            receivedOnFlush = received;
+        });
+    });
+    Poco::AutoPtr<MapConfiguration> config = new MapConfiguration();
+    config->setString("pipeline.nodes", "a,b,sink");
+    config->setString("pipeline.b.inputs", "");
+    config->setString("pipeline.sink.inputs", "a,b");
+    if (!graph->Build(*config))
+    {
+        return false;
+    }
+    RunWithWatchdog("fan-in", graph, timeoutMs);
+
+    MMP_LOG_INFO << "-- fan-in, received on flush (a/b) : " << receivedOnFlush["a"] << "/" << kItemsA << ", " << receivedOnFlush["b"] << "/" << kItemsB
+                 << ", ordered : " << (ordered ? "yes" : "no") << ", flush : " << flushes;
+    return ordered && flushes == 1 && receivedOnFlush["a"] == kItemsA && receivedOnFlush["b"] == kItemsB;
+}
+
+/**
+ * @brief 外部 Stop: 不结束的源与慢速的 sink, 在其他线程调用 Stop 后 Run 返回且不调用 Flush
+ */
+static bool TestStop(uint32_t timeoutMs)
+{
+    std::atomic<uint64_t> received(0);
+    std::atomic<uint32_t> flushes(0);
+    PipelineGraph::ptr graph = std::make_shared<PipelineGraph>();
+    graph->RegisterType("src", [&]() -> PipelineNode::ptr
+    {
+        return CreateCounterSource("src", 0);
+    });
+    graph->RegisterType("sink", [&]() -> PipelineNode::ptr
+    {
+        return PipelineNode::Create([&](PipelineItem& item, PipelineEmitter& emitter) -> bool
+        {
+            received++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            return true;
+        }, [&](PipelineEmitter& emitter)
+        {
+            flushes++;
+        });
+    });
+    Poco::AutoPtr<MapConfiguration> config = new MapConfiguration();
+    config->setString("pipeline.nodes", "src,sink");
+    if (!graph->Build(*config))
+    {
+        return false;
+    }
+    std::thread stopper([graph]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        graph->Stop();
+    });
+    RunWithWatchdog("stop", graph, timeoutMs);
+    stopper.join();
+
+    MMP_LOG_INFO << "-- stop, received : " << received << ", flush : " << flushes;
+    return received > 0 && flushes == 0;
+}
+
+/**
+ * @brief 节点停止: sink 的 Process 返回 false 后整个流水线停止, 阻塞在队列上的上游随之退出
+ */
+static bool TestNodeStop(uint32_t timeoutMs)
+{
+    constexpr uint64_t kStopAfter = 10;
+    uint64_t received = 0;
+    PipelineGraph::ptr graph = std::make_shared<PipelineGraph>();
+    graph->RegisterType("src", [&]() -> PipelineNode::ptr
+    {
+        return CreateCounterSource("src", 0);
+    });
+    graph->RegisterType("sink", [&]() -> PipelineNode::ptr
+    {
+        return PipelineNode::Create([&](PipelineItem& item, PipelineEmitter& emitter) -> bool
+        {
+            received++;
+            return received < kStopAfter;
+        });
+    });
+    Poco::AutoPtr<MapConfiguration> config = new MapConfiguration();
+    config->setString("pipeline.nodes", "src,pass,sink");
+    config->setString("pipeline.pass.type", "rate");
+    config->setString("pipeline.pass.fps", "1000");
+    if (!graph->Build(*config))
+    {
+        return false;
+    }
+    RunWithWatchdog("node stop", graph, timeoutMs);
+
+    MMP_LOG_INFO << "-- node stop, received : " << received << "/" << kStopAfter;
+    return received == kStopAfter;
+}
+
+/********************************************************* TEST(BEGIN) *****************************************************/
+
+int App::main(const ArgVec& args)
+{
+    AbstractLogger::LoggerSingleton()->Enable(AbstractLogger::Direction::CONSLOE);
+    WorkStealingPool::Instance().Init();
+
+    MMP_LOG_INFO << "Pipeline graph test config";
+    MMP_LOG_INFO << "-- timeout : " << timeoutMs << " ms";
+
+    std::vector<std::pair<std::string, std::function<bool(uint32_t)>>> cases =
+    {
+        {"shutdown", TestShutdown},
+        {"fan-in", TestFanIn},
+        {"stop", TestStop},
+        {"node stop", TestNodeStop}
+    };
+    bool pass = true;
+    for (auto& testCase : cases)
+    {
+        bool result = testCase.second(timeoutMs);
+        MMP_LOG_INFO << "-- " << testCase.first << " : " << (result ? "PASS" : "FAIL");
+        pass = pass && result;
+    }
+    MMP_LOG_INFO << "-- result : " << (pass ? "PASS" : "FAIL");
+
+    WorkStealingPool::Instance().Uninit();
+    return pass ? 0 : 255;
+}
+
+/********************************************************* TEST(END) *****************************************************/
+
+POCO_APP_MAIN(App)